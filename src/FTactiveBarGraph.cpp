@@ -36,6 +36,7 @@
 #include "FTutils.hpp"
 #include "FTmainwin.hpp"
 #include "FTjackSupport.hpp"
+#include "FTcurveFile.hpp"
 
 
 enum
@@ -44,6 +45,8 @@ enum
 	FT_2Xscale,
 	FT_LogaXscale,
 	FT_LogbXscale,	
+	FT_ImportCurve,
+	FT_ExportCurve
 };
 
 
@@ -69,6 +72,8 @@ BEGIN_EVENT_TABLE(FTactiveBarGraph, wxPanel)
 	EVT_MENU (FT_2Xscale,FTactiveBarGraph::OnXscaleMenu)
 	EVT_MENU (FT_LogaXscale,FTactiveBarGraph::OnXscaleMenu)
 	EVT_MENU (FT_LogbXscale,FTactiveBarGraph::OnXscaleMenu)
+	EVT_MENU (FT_ImportCurve,FTactiveBarGraph::OnCurveMenu)
+	EVT_MENU (FT_ExportCurve,FTactiveBarGraph::OnCurveMenu)
 	
 END_EVENT_TABLE()
 
@@ -141,6 +146,9 @@ FTactiveBarGraph::FTactiveBarGraph(FTmainwin *win, wxWindow *parent, wxWindowID
 	_xscaleMenu->Append ( new wxMenuItem(_xscaleMenu, FT_2Xscale, wxT("2x Scale")));
 	_xscaleMenu->Append ( new wxMenuItem(_xscaleMenu, FT_LogaXscale, wxT("logA Scale")));
 	_xscaleMenu->Append ( new wxMenuItem(_xscaleMenu, FT_LogbXscale, wxT("logB Scale")));
+	_xscaleMenu->AppendSeparator();
+	_xscaleMenu->Append ( new wxMenuItem(_xscaleMenu, FT_ImportCurve, wxT("Import Curve...")));
+	_xscaleMenu->Append ( new wxMenuItem(_xscaleMenu, FT_ExportCurve, wxT("Export Curve...")));
 
 	// grid choices can't be determined until we get a specmod
 
@@ -1040,16 +1048,17 @@ void FTactiveBarGraph::OnPaint(wxPaintEvent & event)
 	//float barwidthF = _width / (float) barcnt;
 	//int currx = 0;
 
-	float *bvalues = 0, *tvalues=0;
+	// show them with any modulation on top
+	const float *bvalues = 0, *tvalues=0;
 	FTspectrumModifier * specmod = 0;
 	
 	if (_specMod) {
-		bvalues = _specMod->getValues();
+		bvalues = _specMod->getModulatedValues();
 		specmod = _specMod;
 	}
 
 	if (_topSpecMod) {
-		tvalues = _topSpecMod->getValues();
+		tvalues = _topSpecMod->getModulatedValues();
 		specmod = _topSpecMod;
 	}
 
@@ -1538,16 +1547,16 @@ void FTactiveBarGraph::OnMouseActivity( wxMouseEvent &event)
 		if (_topSpecMod) {
 			if (event.ShiftDown() && _specMod) {
 				// shift does regular specmod if there is a topspecmod
-				values = _specMod->getValues();
+				values = _specMod->beginEdit();
 				specmod =_specMod;
 			}
 			else {
-				values = _topSpecMod->getValues();
+				values = _topSpecMod->beginEdit();
 				specmod = _topSpecMod;
 			}
 		}
 		else if (_specMod) {
-			values = _specMod->getValues();
+			values = _specMod->beginEdit();
 			specmod = _specMod;
 		}
 		else {
@@ -1743,6 +1752,7 @@ void FTactiveBarGraph::OnMouseActivity( wxMouseEvent &event)
 			
 		}
 		
+		specmod->commitEdit();
 		
 		Refresh(FALSE);
 		_mainwin->updateGraphs(this, specm->getSpecModifierType());
@@ -1773,36 +1783,36 @@ void FTactiveBarGraph::OnMouseActivity( wxMouseEvent &event)
 
 		if (_topSpecMod) {
 			if (event.ShiftDown() && _specMod) {
-				valueslist[0] = _specMod->getValues();
+				valueslist[0] = _specMod->beginEdit();
 				specmod = _specMod;
 				totbins = _specMod->getLength();
 				valueslist[1] = 0;
 
 				// do both
 				if (event.LeftIsDown()) {
-					valueslist[1] = _topSpecMod->getValues();
+					valueslist[1] = _topSpecMod->beginEdit();
 				}
 			}
 			else {
-				valueslist[0] = _topSpecMod->getValues();
+				valueslist[0] = _topSpecMod->beginEdit();
 				specmod = _topSpecMod;
 				totbins = _topSpecMod->getLength();
 				valueslist[1] = 0;
 
 				// do both
 				if (event.LeftIsDown()) {
-					valueslist[1] = _specMod->getValues();
+					valueslist[1] = _specMod->beginEdit();
 				}
 			}
 		}
 		else if (_specMod) {
-			valueslist[0] = _specMod->getValues();
+			valueslist[0] = _specMod->beginEdit();
 			specmod = _specMod;
 			totbins = _specMod->getLength();
 			valueslist[1] = 0;
 
 			if (event.LeftIsDown() && _topSpecMod) {
-				valueslist[1] = _topSpecMod->getValues();
+				valueslist[1] = _topSpecMod->beginEdit();
 			}
 		}
 		else {
@@ -1908,6 +1918,10 @@ void FTactiveBarGraph::OnMouseActivity( wxMouseEvent &event)
 
 		}
 
+		specmod->commitEdit();
+		if (valueslist[1]) {
+			(specmod == _specMod ? _topSpecMod : _specMod)->commitEdit();
+		}
 		
 		Refresh(FALSE);
 		_mainwin->updateGraphs(this, specm->getSpecModifierType());
@@ -1960,10 +1974,12 @@ void FTactiveBarGraph::OnMouseActivity( wxMouseEvent &event)
 			else {
 				// reset filter
 				if (_specMod) {
-					_specMod->reset();
+					_specMod->fillDefaults (_specMod->beginEdit());
+					_specMod->commitEdit();
 				}
 				if (_topSpecMod) {
-					_topSpecMod->reset();
+					_topSpecMod->fillDefaults (_topSpecMod->beginEdit());
+					_topSpecMod->commitEdit();
 				}
 				
 				Refresh(FALSE);
@@ -2016,7 +2032,7 @@ void FTactiveBarGraph::updatePositionLabels(int pX, int pY, bool showreal, FTspe
 		else return;
 	}
 
-	float *data = specmod->getValues();
+	const float *data = specmod->getLatestValues();
 
 	if (specmod->getModifierType() == FTspectrumModifier::GAIN_MODIFIER
 	    ||specmod->getModifierType() == FTspectrumModifier::POS_GAIN_MODIFIER)
@@ -2138,3 +2154,33 @@ void FTactiveBarGraph::OnXscaleMenu (wxCommandEvent &event)
 
 	Refresh(FALSE);
 }
+
+void FTactiveBarGraph::OnCurveMenu (wxCommandEvent &event)
+{
+	if (!_specMod) return;
+
+	float samplerate = (float) FTioSupport::instance()->getSampleRate();
+	
+	if (event.GetId() == FT_ImportCurve)
+	{
+		wxString path = wxFileSelector (wxT("Import a frequency response curve"), wxT(""), wxT(""), wxT(""),
+						wxT("Curves (*.txt;*.csv;*.frd)|*.txt;*.csv;*.frd|All files|*"),
+						0, this);
+		if (path.empty()) return;
+
+		if (FTcurveFile::importFilter (static_cast<const char *> (path.fn_str()), _specMod, samplerate)) {
+			Refresh(FALSE);
+			_mainwin->updateGraphs(this, _specMod->getSpecModifierType());
+		}
+	}
+	else if (event.GetId() == FT_ExportCurve)
+	{
+		wxString path = wxFileSelector (wxT("Export the curve"), wxT(""),
+						wxString::FromAscii (_specMod->getConfigName().c_str()) + wxT(".csv"), wxT("csv"),
+						wxT("CSV (*.csv)|*.csv|Text (*.txt)|*.txt"),
+						wxSAVE | wxOVERWRITE_PROMPT, this);
+		if (path.empty()) return;
+
+		FTcurveFile::exportFilter (static_cast<const char *> (path.fn_str()), _specMod, samplerate);
+	}
+}
@@ -73,6 +73,8 @@ class FTactiveBarGraph
 	void OnSize ( wxSizeEvent &event);
 	void OnMouseActivity ( wxMouseEvent &event );
 	void OnXscaleMenu (wxCommandEvent &event);
+	// measured curves, see FTcurveFile
+	void OnCurveMenu (wxCommandEvent &event);
 
 	void setBypassed (bool flag) { _bypassed = flag; Refresh(FALSE);}
 	bool getBypassed () { return _bypassed; }
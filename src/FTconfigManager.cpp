@@ -28,6 +28,10 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <climits>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <map>
 
 #include <wx/wx.h>
 #include <wx/dir.h>
@@ -43,19 +47,39 @@
 #include "FTmodulatorManager.hpp"
 #include "FTprocI.hpp"
 #include "FTmodulatorI.hpp"
+#include "FTpresetFile.hpp"
 #include "version.h"
 
 #include "xml++.hpp"
 
 using namespace std;
 
-FTconfigManager::FTconfigManager(const std::string & basedir)
-        : _basedir (basedir)
+FTstagedPreset::FTstagedPreset()
+	: fft_size(1024), windowing(0), update_speed(2), oversamp(4), tempo(120), max_delay(2.5f), dropped(0)
+{
+}
+
+FTstagedPreset::~FTstagedPreset()
 {
-	if (_basedir.empty()) {
-	        _basedir = (wxGetHomeDir() + wxFileName::GetPathSeparator() + wxT(".freqtweak")).fn_str();
+	// modulators first, they let go of the filters
+	for (unsigned int i=0; i < modvec.size(); i++) {
+		for (vector<FTmodulatorI*>::iterator iter = modvec[i].begin(); iter != modvec[i].end(); ++iter) {
+			delete (*iter);
+		}
+	}
+	for (unsigned int i=0; i < procvec.size(); i++) {
+		for (vector<FTprocI*>::iterator iter = procvec[i].begin(); iter != procvec[i].end(); ++iter) {
+			delete (*iter);
+		}
 	}
+}
 
+
+FTconfigManager::FTconfigManager(const std::string & basedir)
+        : _basedir (basedir.empty() ? std::string (static_cast<const char *> ((wxGetHomeDir() + wxFileName::GetPathSeparator() + wxT(".freqtweak")).fn_str())) : basedir),
+	  _index (_basedir + "/presets", _basedir + "/preset_index.xml"),
+	  _lastSum(0), _lastAutosave(time(0)), _recalling(0), _recallPolls(0), _reclaimPending(false)
+{
 	// try to create basedir if it doesn't exist
         //wxDir bdir(_basedir);
 	
@@ -85,41 +109,163 @@ FTconfigManager::FTconfigManager(const std::string & basedir)
 		//printf ("config_presets dir exists\n");
 	}
 	
-	
+	_index.load();
 }
 
 FTconfigManager::~FTconfigManager()
 {
+	// _writer finishes it before it goes
+	saveIndex();
+	
+	for (list<FTstagedPreset*>::iterator iter = _staged.begin(); iter != _staged.end(); ++iter) {
+		delete (*iter);
+	}
+	delete _recalling;
 }
 
 
+wxString FTconfigManager::getSettingsPath (const std::string &name, bool uselast)
+{
+	wxString path (wxString::FromAscii (_basedir.c_str()) + wxFileName::GetPathSeparator());
+
+	if (uselast) {
+		path += wxT("last_setting");
+	}
+	else {
+		path += (wxString (wxT("presets"))
+			 + wxFileName::GetPathSeparator()
+			 + wxString::FromAscii (name.c_str()));
+	}
+
+	return path;
+}
+
 bool FTconfigManager::storeSettings (const std::string &name, bool uselast)
 {
 	if (!uselast && (name == "")) {
 		return false;
 	}
 
-	wxString dirname (wxString::FromAscii (_basedir.c_str()) + wxFileName::GetPathSeparator());
+	wxString filename (getSettingsPath (name, uselast) + wxString::FromAscii (FT_PRESET_EXT));
 
-	// directory to store settings
-	if (uselast)
-	{
-	        dirname += wxT("last_setting");
-	}
-	else
-	{
-		dirname += (wxString (wxT("presets"))
-		                 + wxFileName::GetPathSeparator()
-			         + wxString::FromAscii(name.c_str()));
+	// a staged copy would be stale now
+	for (list<FTstagedPreset*>::iterator iter = _staged.begin(); iter != _staged.end(); ++iter) {
+		if (!uselast && (*iter)->name == name) {
+			delete (*iter);
+			_staged.erase (iter);
+			break;
+		}
 	}
-
+	
 	std::cout<< "storing setting '"
 		 << (name.empty() ? "(last setting)" : name)
-		 << "' to directory '"
-		 << static_cast<const char *> (dirname.mb_str())
+		 << "' to file '"
+		 << static_cast<const char *> (filename.mb_str())
 		 << "'"
 		 << std::endl;
+
+	// everything goes in the one file, the writer deletes it
+	FTpresetFile * binfile = new FTpresetFile();
+	XMLTree configdoc;
+	configdoc.set_root (buildSettings (wxT(""), binfile));
+
+	if (!uselast) {
+		// tags given since it was last stored
+		const FTpresetIndex::Entry * entry = _index.lookup (name);
+		if (entry && !entry->tags.empty()) {
+			std::string tags;
+			for (unsigned int n=0; n < entry->tags.size(); ++n) {
+				tags += (n ? "," : "") + entry->tags[n];
+			}
+			configdoc.root()->add_property ("tags", tags);
+		}
+	}
+	
+	binfile->setConfig (configdoc.write_buffer());
+
+	if (uselast) {
+		_lastSum = binfile->checksum();
+		_lastAutosave = time(0);
+	}
+	else {
+		_index.update (name, configdoc.root(), *binfile);
+	}
+	
+	std::string path (static_cast<const char *> (filename.fn_str()));
+	_storing[path] = uselast ? std::string() : name;
+	_writer.save (path, binfile);
+	saveIndex();
+
+	return true;
+}
+
+void FTconfigManager::takeStored (list<std::string> & stored, list<std::string> & failed)
+{
+	list<std::string> written, notwritten;
+	_writer.takeFinished (written, notwritten);
+
+	// the index isn't in _storing
+	for (int pass=0; pass < 2; ++pass) {
+		list<std::string> & paths = pass ? notwritten : written;
+		
+		for (list<std::string>::iterator iter = paths.begin(); iter != paths.end(); ++iter) {
+			map<std::string, std::string>::iterator found = _storing.find (*iter);
+			if (found == _storing.end()) continue;
+
+			(pass ? failed : stored).push_back (found->second);
+
+			// a newer store of it may still be coming
+			if (!_writer.isPending (*iter)) {
+				_storing.erase (found);
+			}
+		}
+	}
+}
+
+void FTconfigManager::saveIndex()
+{
+	if (_index.isDirty()) {
+		_writer.save (_index.getPath(), _index.serialize());
+	}
+}
+
+bool FTconfigManager::autosaveDue()
+{
+	return time(0) - _lastAutosave >= FT_AUTOSAVE_INTERVAL;
+}
+
+void FTconfigManager::autosave()
+{
+	_lastAutosave = time(0);
 	
+	FTpresetFile * binfile = new FTpresetFile();
+	XMLTree configdoc;
+	configdoc.set_root (buildSettings (wxT(""), binfile));
+	binfile->setConfig (configdoc.write_buffer());
+
+	uint32_t sum = binfile->checksum();
+
+	// lookups since may have filled in entries
+	saveIndex();
+	
+	if (sum == _lastSum) {
+		// nothing to write
+		delete binfile;
+		return;
+	}
+
+	_lastSum = sum;
+	
+	wxString filename (getSettingsPath ("", true) + wxString::FromAscii (FT_PRESET_EXT));
+	std::string path (static_cast<const char *> (filename.fn_str()));
+	_storing[path] = std::string();
+	_writer.save (path, binfile);
+}
+
+bool FTconfigManager::exportSettings (const std::string &dirpath)
+{
+	wxString dirname (wxString::FromAscii (dirpath.c_str()));
+
 	if ( ! wxDir::Exists(dirname) ) {
 		if (mkdir ( dirname.fn_str(), 0755 )) {
 			printf ("Error creating %s\n", static_cast<const char *> (dirname.mb_str())); 
@@ -127,9 +273,6 @@ bool FTconfigManager::storeSettings (const std::string &name, bool uselast)
 		}
 	}
 	
-
-	FTioSupport * iosup = FTioSupport::instance();
-
 	// remove all of our files
 	wxDir dir(dirname);
 	if ( !dir.IsOpened() )
@@ -146,48 +289,290 @@ bool FTconfigManager::storeSettings (const std::string &name, bool uselast)
 		cont = dir.GetNext(&filename);
 	}
 
+	XMLTree configdoc;
+	configdoc.set_root (buildSettings (dirname, 0));
+	
+	// write doc to file
+	
+	if (configdoc.write (static_cast<const char *> ((dirname + wxFileName::GetPathSeparator() + wxT("config.xml")).fn_str())))
+	{	    
+		fprintf (stderr, "Exported settings into %s\n", static_cast<const char *> (dirname.fn_str()));
+		return true;
+	}
+	else {
+		fprintf (stderr, "Failed to export settings into %s\n", static_cast<const char *> (dirname.fn_str()));
+		return false;
+	}
+}
+
+bool FTconfigManager::readPreset (const std::string & path, FTstagedPreset & preset)
+{
+	wxString wpath (wxString::FromAscii (path.c_str()));
+	bool ok;
 
-	// make xmltree
+	if (wxDir::Exists (wpath)
+	    && !wxFileName::FileExists (wpath + wxFileName::GetPathSeparator() + wxT("config.xml"))
+	    && wxFileName::FileExists (wpath + wxFileName::GetPathSeparator() + wxT("config.0")))
+	{
+		ok = loadLegacySettings (wpath, &preset);
+	}
+	else {
+		ok = loadSettingsFrom (wpath, false, true, preset.procvec, &preset);
+	}
+
+	// nothing will run these, so no smoothing
+	for (unsigned int i=0; i < preset.procvec.size(); i++) {
+		for (unsigned int n=0; n < preset.procvec[i].size(); n++) {
+			preset.procvec[i][n]->settleFilters();
+		}
+	}
+
+	return ok;
+}
+
+bool FTconfigManager::writePreset (const std::string & path, FTstagedPreset & preset, bool dirformat)
+{
 	XMLTree configdoc;
+	
+	if (!dirformat) {
+		FTpresetFile binfile;
+		configdoc.set_root (buildSettings (wxT(""), &binfile, &preset));
+		binfile.setConfig (configdoc.write_buffer());
+
+		if (!binfile.write (path)) {
+			fprintf (stderr, "Failed to write preset %s\n", path.c_str());
+			return false;
+		}
+		return true;
+	}
+	
+	wxString dirname (wxString::FromAscii (path.c_str()));
+
+	if ( ! wxDir::Exists(dirname) ) {
+		if (mkdir ( dirname.fn_str(), 0755 )) {
+			fprintf (stderr, "Error creating %s\n", path.c_str()); 
+			return false;
+		}
+	}
+
+	configdoc.set_root (buildSettings (dirname, 0, &preset));
+	
+	if (!configdoc.write (static_cast<const char *> ((dirname + wxFileName::GetPathSeparator() + wxT("config.xml")).fn_str()))) {
+		fprintf (stderr, "Failed to write preset into %s\n", path.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool FTconfigManager::loadLegacySettings (const wxString & dirname, FTstagedPreset * staged)
+{
+	// the chain was fixed back then
+	const char * pmnames[] = { "EQ", "Pitch", "Gate", "Delay", 0 };
+
+	_linkCache.clear();
+
+	for (unsigned int chan=0; chan < FT_MAXPATHS; chan++)
+	{
+		wxTextFile cfile (dirname + wxFileName::GetPathSeparator() + wxString::Format (wxT("config.%d"), chan));
+		if (!cfile.Exists() || !cfile.Open()) {
+			break;
+		}
+
+		// key=value lines
+		map<string, string> info;
+		
+		for (unsigned int i=0; i < cfile.GetLineCount(); i++)
+		{
+			wxString line = cfile[i];
+			line.Trim(true);
+			line.Trim(false);
+
+			if (line.IsEmpty() || line.GetChar(0) == '#' || line.Find('=') < 0) {
+				continue;
+			}
+
+			info[static_cast<const char *> (line.BeforeFirst('=').mb_str())]
+				= static_cast<const char *> (line.AfterFirst('=').mb_str());
+		}
+		cfile.Close();
+
+		double fval;
+		long ival;
+		
+		if (chan == 0) {
+			if (wxString::FromAscii (info["fft_size"].c_str()).ToLong (&ival)) staged->fft_size = (int) ival;
+			if (wxString::FromAscii (info["windowing"].c_str()).ToLong (&ival)) staged->windowing = (int) ival;
+			if (wxString::FromAscii (info["update_speed"].c_str()).ToLong (&ival)) staged->update_speed = (int) ival;
+			if (wxString::FromAscii (info["oversamp"].c_str()).ToLong (&ival)) staged->oversamp = (int) ival;
+			if (wxString::FromAscii (info["tempo"].c_str()).ToLong (&ival)) staged->tempo = (int) ival;
+			if (wxString::FromAscii (info["max_delay"].c_str()).ToDouble (&fval)) staged->max_delay = (float) fval;
+		}
+
+		FTstagedPreset::Channel chanset;
+
+		if (wxString::FromAscii (info["input_gain"].c_str()).ToDouble (&fval)) chanset.input_gain = (float) fval;
+		if (wxString::FromAscii (info["mix_ratio"].c_str()).ToDouble (&fval)) chanset.mix_ratio = (float) fval;
+		if (wxString::FromAscii (info["bypassed"].c_str()).ToLong (&ival)) chanset.bypassed = (ival == 1);
+		if (wxString::FromAscii (info["muted"].c_str()).ToLong (&ival)) chanset.muted = (ival == 1);
+
+		// comma separated port names
+		for (int dir=0; dir < 2; dir++) {
+			wxString ports = wxString::FromAscii (info[dir ? "output_ports" : "input_ports"].c_str());
+			while (!ports.IsEmpty()) {
+				std::string port = static_cast<const char *> (ports.BeforeFirst(',').Strip(wxString::both).mb_str());
+				ports = ports.AfterFirst(',');
+				if (port.empty()) continue;
+
+				if (dir) {
+					chanset.outputs.push_back (port);
+				}
+				else {
+					chanset.inputs.push_back (port);
+				}
+			}
+		}
+		
+		staged->channels.push_back (chanset);
+		staged->modvec.push_back (vector<FTmodulatorI *>());
+		staged->procvec.push_back (vector<FTprocI *>());
+
+		for (unsigned int ppos=0; pmnames[ppos]; ppos++)
+		{
+			FTprocI * procmod = FTdspManager::instance()->getModuleByConfigName(pmnames[ppos]);
+			if (!procmod) {
+				fprintf (stderr, "no proc module '%s' supported\n", pmnames[ppos]);
+				staged->dropped++;
+				continue;
+			}
+			procmod = procmod->clone();
+			
+			procmod->setMaxDelay (staged->max_delay);
+			procmod->initialize();
+			procmod->setFFTsize ((unsigned int) staged->fft_size);
+			procmod->setOversamp (staged->oversamp);
+			procmod->setId ((int) chan);
+
+			vector<FTspectrumModifier *> filts;
+			procmod->getFilters (filts);
+
+			for (unsigned int fpos=0; fpos < filts.size(); fpos++)
+			{
+				FTspectrumModifier * specmod = filts[fpos];
+				string fname = specmod->getConfigName();
+				
+				wxTextFile filtfile (dirname + wxFileName::GetPathSeparator()
+						     + wxString::FromAscii (fname.c_str())
+						     + wxString::Format (wxT(".%d.filter"), chan));
+				if (filtfile.Exists() && filtfile.Open()) {
+					loadFilter (specmod, filtfile);
+					filtfile.Close();
+				}
+
+				if (wxString::FromAscii (info[fname + "_bypassed"].c_str()).ToLong (&ival)) {
+					specmod->setBypassed (ival == 1);
+				}
+				if (wxString::FromAscii (info[fname + "_linked"].c_str()).ToLong (&ival) && ival >= 0) {
+					_linkCache.push_back (LinkCache(chan, (unsigned int) ival, staged->procvec[chan].size(), fpos));
+				}
+			}
+
+			staged->procvec[chan].push_back (procmod);
+		}
+	}
+
+	if (staged->procvec.empty()) {
+		fprintf (stderr, "No channels found in %s!\n", static_cast<const char *> (dirname.mb_str()));
+		return false;
+	}
+
+	linkLoaded (staged->procvec);
+	
+	return true;
+}
+
+XMLNode * FTconfigManager::buildSettings (const wxString & dirname, FTpresetFile * binfile, FTstagedPreset * staged)
+{
+	FTioSupport * iosup = FTioSupport::instance();
+
+	// make xmltree
 	XMLNode * rootNode = new XMLNode("Preset");
 	rootNode->add_property("version", freqtweak_version);
-	configdoc.set_root (rootNode);
+
+	if (staged && !staged->tags.empty()) {
+		rootNode->add_property ("tags", staged->tags);
+	}
 	
 	// Params node has global dsp settings
 	XMLNode * paramsNode = rootNode->add_child ("Params");
 
 	XMLNode * channelsNode = rootNode->add_child ("Channels");
 
+	int chans = staged ? (int) staged->procvec.size() : iosup->getActivePathCount();
 	
-	for (int i=0; i < iosup->getActivePathCount(); i++)
+	for (int i=0; i < chans; i++)
 	{
-		FTprocessPath * procpath = iosup->getProcessPath(i);
-		if (!procpath) continue; // shouldnt happen
+		FTspectralEngine *engine = 0;
+		FTstagedPreset::Channel chanset;
+		vector<FTprocI *> procmods;
 
-		FTspectralEngine *engine = procpath->getSpectralEngine();
+		if (staged) {
+			if (i < (int) staged->channels.size()) {
+				chanset = staged->channels[i];
+			}
+			procmods = staged->procvec[i];
+		}
+		else {
+			FTprocessPath * procpath = iosup->getProcessPath(i);
+			if (!procpath) continue; // shouldnt happen
+
+			engine = procpath->getSpectralEngine();
+			engine->getProcessorModules (procmods);
 
+			chanset.input_gain = engine->getInputGain();
+			chanset.mix_ratio = engine->getMixRatio();
+			chanset.bypassed = engine->getBypassed();
+			chanset.muted = engine->getMuted();
+		}
+		
 		if (i==0)
 		{
 			// pull global params from first procpath
-			paramsNode->add_property ("fft_size", static_cast<const char *> (wxString::Format(wxT("%d"), engine->getFFTsize()).mb_str()));
-			paramsNode->add_property ("windowing", static_cast<const char *> (wxString::Format(wxT("%d"), engine->getWindowing()).mb_str()));			
-			paramsNode->add_property ("update_speed", static_cast<const char *> (wxString::Format(wxT("%d"), engine->getUpdateSpeed()).mb_str()));			
-			paramsNode->add_property ("oversamp", static_cast<const char *> (wxString::Format(wxT("%d"), engine->getOversamp()).mb_str()));			
-			paramsNode->add_property ("tempo", static_cast<const char *> (wxString::Format(wxT("%d"), engine->getTempo()).mb_str()));			
-			paramsNode->add_property ("max_delay", static_cast<const char *> (wxString::Format(wxT("%.10g"), engine->getMaxDelay()).mb_str()));			
+			int fft_size, windowing, update_speed, oversamp, tempo;
+			float max_delay;
+
+			if (staged) {
+				fft_size = staged->fft_size;
+				windowing = staged->windowing;
+				update_speed = staged->update_speed;
+				oversamp = staged->oversamp;
+				tempo = staged->tempo;
+				max_delay = staged->max_delay;
+			}
+			else {
+				fft_size = engine->getFFTsize();
+				windowing = engine->getWindowing();
+				update_speed = engine->getUpdateSpeed();
+				oversamp = engine->getOversamp();
+				tempo = engine->getTempo();
+				max_delay = engine->getMaxDelay();
+			}
+			
+			paramsNode->add_property ("fft_size", static_cast<const char *> (wxString::Format(wxT("%d"), fft_size).mb_str()));
+			paramsNode->add_property ("windowing", static_cast<const char *> (wxString::Format(wxT("%d"), windowing).mb_str()));			
+			paramsNode->add_property ("update_speed", static_cast<const char *> (wxString::Format(wxT("%d"), update_speed).mb_str()));			
+			paramsNode->add_property ("oversamp", static_cast<const char *> (wxString::Format(wxT("%d"), oversamp).mb_str()));			
+			paramsNode->add_property ("tempo", static_cast<const char *> (wxString::Format(wxT("%d"), tempo).mb_str()));			
+			paramsNode->add_property ("max_delay", static_cast<const char *> (wxString::Format(wxT("%.10g"), max_delay).mb_str()));			
 		}
 
 
-		vector<FTprocI *> procmods;
-		engine->getProcessorModules (procmods);
-
 		XMLNode * chanNode = channelsNode->add_child ("Channel");
 
 		chanNode->add_property ("pos", static_cast<const char *> (wxString::Format(wxT("%d"), i).mb_str()));
-		chanNode->add_property ("input_gain", static_cast<const char *> (wxString::Format(wxT("%.10g"), engine->getInputGain()).mb_str()));
-		chanNode->add_property ("mix_ratio", static_cast<const char *> (wxString::Format(wxT("%.10g"), engine->getMixRatio()).mb_str()));
-		chanNode->add_property ("bypassed", static_cast<const char *> (wxString::Format(wxT("%d"), engine->getBypassed() ? 1: 0).mb_str()));
-		chanNode->add_property ("muted", static_cast<const char *> (wxString::Format(wxT("%d"), engine->getMuted() ? 1 : 0).mb_str()));
+		chanNode->add_property ("input_gain", static_cast<const char *> (wxString::Format(wxT("%.10g"), chanset.input_gain).mb_str()));
+		chanNode->add_property ("mix_ratio", static_cast<const char *> (wxString::Format(wxT("%.10g"), chanset.mix_ratio).mb_str()));
+		chanNode->add_property ("bypassed", static_cast<const char *> (wxString::Format(wxT("%d"), chanset.bypassed ? 1: 0).mb_str()));
+		chanNode->add_property ("muted", static_cast<const char *> (wxString::Format(wxT("%d"), chanset.muted ? 1 : 0).mb_str()));
 
 		
 		// now for the filter sections
@@ -219,23 +604,32 @@ bool FTconfigManager::storeSettings (const std::string &name, bool uselast)
                                         wxString::Format(wxT("%d"),
 							 filts[m]->getBypassed() ? 1 : 0).mb_str()));
 
-				std::string filtfname ( (wxString::Format(wxT("%d_%d_"), i, n)
-							 + wxString::FromAscii (filts[m]->getConfigName().c_str())
-							 + wxT(".filter")).fn_str() );
-				filtNode->add_property ("file", filtfname);
-
-				// write out filter file
-				wxTextFile filtfile (dirname +
-						     wxFileName::GetPathSeparator() +
-						     wxString::FromAscii (filtfname.c_str()));
-				if (filtfile.Exists()) {
-					// remove it
-					unlink (wxString (filtfile.GetName()).fn_str ());
+				if (binfile) {
+					// at the finest size it has been, so loading at
+					// that size gets all of it back
+					int length = 0;
+					const float * values = filts[m]->getSourceValues (length);
+					binfile->addFilter (i, n, m, values, length);
+				}
+				else {
+					std::string filtfname ( (wxString::Format(wxT("%d_%d_"), i, n)
+								 + wxString::FromAscii (filts[m]->getConfigName().c_str())
+								 + wxT(".filter")).fn_str() );
+					filtNode->add_property ("file", filtfname);
+
+					// write out filter file
+					wxTextFile filtfile (dirname +
+							     wxFileName::GetPathSeparator() +
+							     wxString::FromAscii (filtfname.c_str()));
+					if (filtfile.Exists()) {
+						// remove it
+						unlink (wxString (filtfile.GetName()).fn_str ());
+					}
+					filtfile.Create ();
+					writeFilter (filts[m], filtfile);
+					filtfile.Write();
+					filtfile.Close();
 				}
-				filtfile.Create ();
-				writeFilter (filts[m], filtfile);
-				filtfile.Write();
-				filtfile.Close();
 
 				// write Extra node
 				XMLNode * extran = filts[m]->getExtraNode();
@@ -248,7 +642,18 @@ bool FTconfigManager::storeSettings (const std::string &name, bool uselast)
 
 		// port connections		
 		XMLNode * inputsNode = chanNode->add_child ("Inputs");
+		XMLNode * outputsNode = chanNode->add_child ("Outputs");
 
+		if (staged) {
+			for (unsigned int n=0; n < chanset.inputs.size(); n++) {
+				inputsNode->add_child ("Port")->add_property ("name", chanset.inputs[n]);
+			}
+			for (unsigned int n=0; n < chanset.outputs.size(); n++) {
+				outputsNode->add_child ("Port")->add_property ("name", chanset.outputs[n]);
+			}
+			continue;
+		}
+		
 		const char ** inports = iosup->getConnectedInputPorts(i);
 		if (inports) {
 			for (int n=0; inports[n]; n++) {
@@ -259,8 +664,6 @@ bool FTconfigManager::storeSettings (const std::string &name, bool uselast)
 			free(inports);
 		}
 
-		XMLNode * outputsNode = chanNode->add_child ("Outputs");
-		
 		const char ** outports = iosup->getConnectedOutputPorts(i);
 		if (outports) {
 			for (int n=0; outports[n]; n++) {
@@ -284,7 +687,7 @@ bool FTconfigManager::storeSettings (const std::string &name, bool uselast)
 		      </Controls>
 
 		      <Filters>
-                         <Filter chan="" modpos="" filtpos="" />
+                         <Filter chan="" modpos="" filtpos="" depth="" />
 			 ...
 		      </Filters>
 		      
@@ -293,16 +696,21 @@ bool FTconfigManager::storeSettings (const std::string &name, bool uselast)
 	 */
 
 	
-	for (int i=0; i < iosup->getActivePathCount(); i++)
+	for (int i=0; i < chans; i++)
 	{
-		FTprocessPath * procpath = iosup->getProcessPath(i);
-		if (!procpath) continue; // shouldnt happen
-
-		FTspectralEngine *engine = procpath->getSpectralEngine();
-		
-			
 		vector<FTmodulatorI *> mods;
-		engine->getModulators (mods);
+
+		if (staged) {
+			if (i < (int) staged->modvec.size()) {
+				mods = staged->modvec[i];
+			}
+		}
+		else {
+			FTprocessPath * procpath = iosup->getProcessPath(i);
+			if (!procpath) continue; // shouldnt happen
+
+			procpath->getSpectralEngine()->getModulators (mods);
+		}
 
 		for (vector<FTmodulatorI*>::iterator miter = mods.begin(); miter != mods.end(); ++miter)
 		{
@@ -325,11 +733,16 @@ bool FTconfigManager::storeSettings (const std::string &name, bool uselast)
 			{
 				int chan=0, modpos=0, filtpos=0;
 
-				if (lookupFilterLocation ((*filtiter), chan, modpos, filtpos)) {
+				if (lookupFilterLocation ((*filtiter), chan, modpos, filtpos, staged)) {
 					XMLNode * filtNode = filtersNode->add_child ("Filter");
 					filtNode->add_property ("channel", static_cast<const char *> (wxString::Format(wxT("%d"), chan).mb_str()));
 					filtNode->add_property ("modpos", static_cast<const char *> (wxString::Format(wxT("%d"), modpos).mb_str()));
 					filtNode->add_property ("filtpos", static_cast<const char *> (wxString::Format(wxT("%d"), filtpos).mb_str()));
+
+					float depth = mod->getRouteDepth (*filtiter);
+					if (depth != 1.0f) {
+						filtNode->add_property ("depth", static_cast<const char *> (wxString::Format(wxT("%.6g"), depth).mb_str()));
+					}
 				}
 			}
 			
@@ -397,21 +810,8 @@ bool FTconfigManager::storeSettings (const std::string &name, bool uselast)
 		}
 
 	}
-	
-	
-	
-	
-	// write doc to file
-	
-	if (configdoc.write (static_cast<const char *> ((dirname + wxFileName::GetPathSeparator() + wxT("config.xml")).fn_str())))
-	{	    
-		fprintf (stderr, "Stored settings into %s\n", static_cast<const char *> (dirname.fn_str()));
-		return true;
-	}
-	else {
-		fprintf (stderr, "Failed to store settings into %s\n", static_cast<const char *> (dirname.fn_str()));
-		return false;
-	}
+
+	return rootNode;
 }
 
 bool FTconfigManager::loadSettings (const std::string &name, bool restore_ports, bool uselast)
@@ -426,75 +826,98 @@ bool FTconfigManager::loadSettings (const std::string &name, bool restore_ports,
 		return false;
 	}
 
-	wxString dirname (wxString::FromAscii (_basedir.c_str()) + wxFileName::GetPathSeparator());
-	if (uselast) {
-		dirname += wxT("last_setting");
-	}
-	else {
-		dirname += (wxString (wxT("presets")) + wxFileName::GetPathSeparator() + wxString::FromAscii (name.c_str()));
+	if (!ignore_iosup) {
+		// it would set its channels over these
+		finishRecall (true);
 	}
-	
-	if ( ! wxDir::Exists(dirname) ) {
-		printf ("Settings %s does not exist!\n", static_cast<const char *> (dirname.fn_str())); 
+
+	wxString path;
+	if (!findSettings (name, uselast, path)) {
+		printf ("Settings %s does not exist!\n", static_cast<const char *> (path.fn_str())); 
 		return false;
 	}
 
-	FTioSupport * iosup = 0;
+	return loadSettingsFrom (path, restore_ports, ignore_iosup, procvec);
+}
 
-	if (!ignore_iosup) {
-		iosup = FTioSupport::instance();
-	}
+bool FTconfigManager::findSettings (const std::string &name, bool uselast, wxString & path)
+{
+	// the single file if there is one, otherwise an older directory
+	path = getSettingsPath (name, uselast);
+
+	// a store may still be on its way
+	_writer.wait (static_cast<const char *> ((path + wxString::FromAscii (FT_PRESET_EXT)).fn_str()));
+	
+	if (wxFileName::FileExists (path + wxString::FromAscii (FT_PRESET_EXT))) {
+		path += wxString::FromAscii (FT_PRESET_EXT);
+		return true;
+	}
 	
-	// open file
-	string configfname(static_cast<const char *> ((dirname + wxFileName::GetPathSeparator() + wxT("config.xml")).fn_str() ));
-	XMLTree configdoc (configfname);
+	return wxDir::Exists(path);
+}
+
+bool FTconfigManager::importSettings (const std::string &dirpath, bool restore_ports)
+{
+	wxString dirname (wxString::FromAscii (dirpath.c_str()));
 
-	if (!configdoc.initialized()) {
-		fprintf (stderr, "Error loading config at %s!\n", configfname.c_str()); 
+	if ( ! wxDir::Exists(dirname) ) {
+		printf ("Settings %s does not exist!\n", static_cast<const char *> (dirname.fn_str())); 
 		return false;
 	}
 
-	XMLNode * rootNode = configdoc.root();
-	if (!rootNode || rootNode->name() != "Preset") {
-		fprintf (stderr, "Preset root node not found in %s!\n", configfname.c_str()); 
-		return false;
+	vector<vector <FTprocI *> > tmpvec;
+	return loadSettingsFrom (dirname, restore_ports, false, tmpvec);
+}
+
+bool FTconfigManager::loadSettingsFrom (const wxString & path, bool restore_ports, bool ignore_iosup, vector< vector<FTprocI *> > & procvec,
+					FTstagedPreset * staged)
+{
+	FTioSupport * iosup = 0;
+
+	if (!ignore_iosup) {
+		iosup = FTioSupport::instance();
 	}
 
-	// get channels
+	bool isdir = wxDir::Exists (path);
+	wxString dirname = path;
+	FTpresetFile binfile;
+	string configfname;
+
+	// Read in one pass as it streams in, no tree.  buildSettings()
+	// writes Params, Channels and Modulators in that order, which
+	// is the order everything has to happen in anyway
+	XMLReader reader;
+	bool opened = false;
+
+	if (isdir) {
+		// config.xml and a text file per filter
+		configfname = static_cast<const char *> ((dirname + wxFileName::GetPathSeparator() + wxT("config.xml")).fn_str() );
+		opened = reader.open (configfname);
+	}
+	else {
+		configfname = static_cast<const char *> (path.fn_str());
+		if (binfile.open (configfname)) {
+			opened = reader.open_buffer (binfile.getConfig());
+		}
+	}
 
-	XMLNode * channelsNode = find_named_node (rootNode, "Channels");
-	if (!channelsNode ) {
-		fprintf (stderr, "Preset Channels node not found in %s!\n", configfname.c_str()); 
+	if (!opened || !reader.next_child (-1)) {
+		fprintf (stderr, "Error loading config at %s!\n", configfname.c_str());
 		return false;
 	}
 
-	XMLNodeList chanlist = channelsNode->children();
-	if (chanlist.size() < 1) {
-		fprintf (stderr, "No channels found in %s!\n", configfname.c_str()); 
+	if (reader.name() != "Preset") {
+		fprintf (stderr, "Preset root node not found in %s!\n", configfname.c_str());
 		return false;
 	}
 
-	if (!ignore_iosup)
-	{
-		unsigned int i;
-		for (i=0; i < chanlist.size() && i < FT_MAXPATHS; i++)
-		{
-			iosup->setProcessPathActive(i, true);
-		}
-		// set all remaining paths inactive
-		for ( ; i < FT_MAXPATHS; i++) {
-			iosup->setProcessPathActive(i, false);
-		}
-	}
-	else {
-		// set up procvec with its channels
-		for (unsigned int i=0; i < chanlist.size() && i < FT_MAXPATHS; i++)
-		{
-			procvec.push_back(vector<FTprocI *>());
-		}
+	string value;
+
+	if (staged && reader.property ("tags", value)) {
+		staged->tags = value;
 	}
-	
-	// get global params
+
+	// global params
 	unsigned long fft_size = 1024;
 	unsigned long windowing = 0;
 	unsigned long update_speed = 2;
@@ -502,367 +925,415 @@ bool FTconfigManager::loadSettings (const std::string &name, bool restore_ports,
 	unsigned long tempo = 120;
 	double        max_delay = 2.5;
 
-	XMLNode * paramsNode = find_named_node (rootNode, "Params");
-	if (paramsNode)
+	_linkCache.clear();
+
+	int rootdepth = reader.depth();
+	bool gotchannels = false;
+	double fval;
+	unsigned long uval;
+
+	while (reader.next_child (rootdepth))
 	{
-		XMLPropertyConstIterator propiter;
-		XMLPropertyList proplist = paramsNode->properties();
-		
-		for (propiter=proplist.begin(); propiter != proplist.end(); ++propiter)
+		if (reader.name() == "Params")
 		{
-			string key = (*propiter)->name();
-			wxString value (wxString::FromAscii ((*propiter)->value().c_str()));
+			if (gotchannels) {
+				fprintf (stderr, "Preset Params after the Channels in %s, ignored!\n", configfname.c_str());
+				continue;
+			}
 
-			if (key == "fft_size") {
-				value.ToULong(&fft_size);
+			if (reader.property ("fft_size", value)) {
+				wxString::FromAscii (value.c_str()).ToULong (&fft_size);
 			}
-			else if (key == "windowing") {
-				value.ToULong(&windowing);
+			if (reader.property ("windowing", value)) {
+				wxString::FromAscii (value.c_str()).ToULong (&windowing);
 			}
-			else if (key == "update_speed") {
-				value.ToULong(&update_speed);
+			if (reader.property ("update_speed", value)) {
+				wxString::FromAscii (value.c_str()).ToULong (&update_speed);
 			}
-			else if (key == "oversamp") {
-				value.ToULong(&oversamp);
+			if (reader.property ("oversamp", value)) {
+				wxString::FromAscii (value.c_str()).ToULong (&oversamp);
 			}
-			else if (key == "tempo") {
-				value.ToULong(&tempo);
+			if (reader.property ("tempo", value)) {
+				wxString::FromAscii (value.c_str()).ToULong (&tempo);
 			}
-			else if (key == "max_delay") {
-				value.ToDouble(&max_delay);
+			if (reader.property ("max_delay", value)) {
+				wxString::FromAscii (value.c_str()).ToDouble (&max_delay);
 			}
+			continue;
 		}
-	}
-
-
-	_linkCache.clear();
-	
-	// clear all procpaths
-	XMLNodeConstIterator chaniter;
-	XMLNode * chanNode;
-	double fval;
-	unsigned long uval;
-	
-	for (chaniter=chanlist.begin(); chaniter != chanlist.end(); ++chaniter)
-	{
-		chanNode = *chaniter;
-
-		XMLProperty * prop;
-
-		if (!(prop = chanNode->property ("pos"))) {
-			fprintf (stderr, "pos missing in channel!\n"); 
+		else if (reader.name() == "Modulators")
+		{
+			if (!gotchannels) {
+				fprintf (stderr, "Preset Modulators before the Channels in %s, ignored!\n", configfname.c_str());
+			}
+			else if (!ignore_iosup || staged) {
+				// loaded chains only get theirs when staged
+				loadModulators (reader, staged);
+			}
 			continue;
 		}
-		
-		unsigned long chan_pos;
-		wxString tmpstr (wxString::FromAscii (prop->value().c_str()));
-		if (!tmpstr.ToULong (&chan_pos) || chan_pos >= FT_MAXPATHS) {
-			fprintf (stderr, "invalid pos in channel!\n"); 
+		else if (reader.name() != "Channels" || gotchannels) {
 			continue;
 		}
 
-		FTspectralEngine * engine = 0;
+		gotchannels = true;
 
-		if (!ignore_iosup) {
-			FTprocessPath * procpath = iosup->getProcessPath((int) chan_pos);
-			if (!procpath) continue; // shouldnt happen
-			
-			engine = procpath->getSpectralEngine();
+		if (staged) {
+			staged->fft_size = (int) fft_size;
+			staged->windowing = (int) windowing;
+			staged->update_speed = (int) update_speed;
+			staged->oversamp = (int) oversamp;
+			staged->tempo = (int) tempo;
+			staged->max_delay = (float) max_delay;
+		}
 
-			// apply some of the global settings now
-			engine->setOversamp ((int) oversamp);
-			engine->setTempo ((int) tempo);
-			engine->setMaxDelay ((float) max_delay);
+		int chansdepth = reader.depth();
+		unsigned int chancount = 0;
 
-		
-			// get channel settings
-			XMLPropertyConstIterator propiter;
-			XMLPropertyList proplist = chanNode->properties();
+		while (reader.next_child (chansdepth))
+		{
+			if (reader.name() != "Channel") continue;
 
-			for (propiter=proplist.begin(); propiter != proplist.end(); ++propiter)
-			{
-				string key = (*propiter)->name();
-				wxString value (wxString::FromAscii ((*propiter)->value().c_str()));
+			if (!reader.property ("pos", value)) {
+				fprintf (stderr, "pos missing in channel!\n");
+				continue;
+			}
 
-				if (key == "input_gain") {
-					if (value.ToDouble(&fval)) {
-						engine->setInputGain ((float) fval);
-					}
-				}
-				else if (key == "mix_ratio") {
-					if (value.ToDouble(&fval)) {
-						engine->setMixRatio ((float) fval);
-					}
+			unsigned long chan_pos;
+			if (!wxString::FromAscii (value.c_str()).ToULong (&chan_pos) || chan_pos >= FT_MAXPATHS) {
+				fprintf (stderr, "invalid pos in channel!\n");
+				continue;
+			}
+
+			// the channels up to this one are in use, as they come
+			for ( ; chancount <= chan_pos; chancount++) {
+				if (!ignore_iosup) {
+					iosup->setProcessPathActive (chancount, true);
 				}
-				else if (key == "bypassed") {
-					if (value.ToULong(&uval)) {
-						engine->setBypassed (uval==1 ? true: false);
+				else {
+					procvec.push_back (vector<FTprocI *>());
+
+					if (staged) {
+						staged->channels.push_back (FTstagedPreset::Channel());
+						staged->modvec.push_back (vector<FTmodulatorI *>());
 					}
 				}
-				else if (key == "muted") {
-					if (value.ToULong(&uval)) {
-						engine->setMuted (uval==1 ? true: false);
-					}
-				}	
 			}
 
+			FTspectralEngine * engine = 0;
 
-			// clear existing procmods
-			engine->clearProcessorModules();
-		}
-		
-		// get procmods node
-		XMLNode * procmodsNode = find_named_node (chanNode, "ProcMods");
-		
-		if ( !procmodsNode ) {
-			fprintf (stderr, "Preset ProcMods node not found in %s!\n", configfname.c_str()); 
-			return false;
-		}
-
-		XMLNodeList pmlist = procmodsNode->children();
-		XMLNodeConstIterator pmiter;
-		XMLNode * pmNode;
-
-		for (pmiter=pmlist.begin(); pmiter != pmlist.end(); ++pmiter)
-		{
-			pmNode = *pmiter;
+			// get channel settings
+			FTstagedPreset::Channel chanset;
 
-			if (pmNode->name() != "ProcMod") continue;
-			
-			if (!(prop = pmNode->property ("pos"))) {
-				fprintf (stderr, "pos missing in procmod!\n"); 
-				continue;
+			if (reader.property ("input_gain", value) && wxString::FromAscii (value.c_str()).ToDouble (&fval)) {
+				chanset.input_gain = (float) fval;
 			}
-			unsigned long ppos;
-			tmpstr = wxString::FromAscii (prop->value().c_str());
-			if (!tmpstr.ToULong (&ppos)) {
-				fprintf (stderr, "invalid pos in procmod!\n"); 
-				continue;
+			if (reader.property ("mix_ratio", value) && wxString::FromAscii (value.c_str()).ToDouble (&fval)) {
+				chanset.mix_ratio = (float) fval;
 			}
-
-			if (!(prop = pmNode->property ("name"))) {
-				fprintf (stderr, "name missing in procmod!\n"); 
-				continue;
+			if (reader.property ("bypassed", value) && wxString::FromAscii (value.c_str()).ToULong (&uval)) {
+				chanset.bypassed = (uval==1 ? true: false);
 			}
-			string pmname = prop->value();
-
-			// construct new procmod
-			FTprocI * procmod = FTdspManager::instance()->getModuleByConfigName(pmname);
-			if (!procmod) {
-				fprintf (stderr, "no proc module '%s' supported\n", pmname.c_str()); 
-				continue;
+			if (reader.property ("muted", value) && wxString::FromAscii (value.c_str()).ToULong (&uval)) {
+				chanset.muted = (uval==1 ? true: false);
 			}
-			procmod = procmod->clone();
 
-			// must call this before initialization
-			procmod->setMaxDelay ((float)max_delay);
-
-			procmod->initialize();
+			if (staged && chan_pos < staged->channels.size()) {
+				staged->channels[chan_pos] = chanset;
+			}
 
 			if (!ignore_iosup) {
-				procmod->setSampleRate (iosup->getSampleRate());
+				FTprocessPath * procpath = iosup->getProcessPath((int) chan_pos);
+				if (!procpath) continue; // shouldnt happen
+
+				engine = procpath->getSpectralEngine();
+
+				// apply some of the global settings now
+				engine->setOversamp ((int) oversamp);
+				engine->setTempo ((int) tempo);
+				engine->setMaxDelay ((float) max_delay);
+				engine->setInputGain (chanset.input_gain);
+				engine->setMixRatio (chanset.mix_ratio);
+				engine->setBypassed (chanset.bypassed);
+				engine->setMuted (chanset.muted);
+
+				// clear existing procmods
+				engine->clearProcessorModules();
+
+				// and take the preset's size while there are none, so
+				// the filters can be loaded at the size they were stored
+				engine->setFFTsize ((FTspectralEngine::FFT_Size) fft_size);
 			}
-			
-			procmod->setOversamp ((int)oversamp);
 
-			// load up the filters in the procmod
-			
-			XMLNodeList filtlist = pmNode->children();
-			XMLNodeConstIterator filtiter;
-			XMLNode * filtNode;
+			int chandepth = reader.depth();
+			bool gotprocmods = false;
+			bool gotinputs = false;
+			bool gotoutputs = false;
 
-			for (filtiter=filtlist.begin(); filtiter != filtlist.end(); ++filtiter)
+			while (reader.next_child (chandepth))
 			{
-				filtNode = *filtiter;
-
-			        if (filtNode->name() != "Filter")
+				if (reader.name() == "Inputs" || reader.name() == "Outputs")
 				{
-					continue;
-				}
-				
-				if (!(prop =filtNode->property ("pos"))) {
-					fprintf (stderr, "pos missing in filter!\n"); 
-					continue;
-				}
-				unsigned long fpos;
-				tmpstr = wxString::FromAscii (prop->value().c_str());
-				if (!tmpstr.ToULong (&fpos)) {
-					fprintf (stderr, "invalid filter pos in channel!\n"); 
-					continue;
-				}
+					bool inputs = (reader.name() == "Inputs");
+					if (inputs) {
+						gotinputs = true;
+					}
+					else {
+						gotoutputs = true;
+					}
 
-				if (!(prop = filtNode->property ("file"))) {
-					fprintf (stderr, "filter filename missing in procmod!\n"); 
+					bool connect = restore_ports && !ignore_iosup;
+					bool keep = staged && chan_pos < staged->channels.size();
+					if (!connect && !keep) continue;
+
+					// disconnect all
+					if (connect && inputs) {
+						iosup->disconnectPathInput(chan_pos, NULL);
+					}
+					else if (connect) {
+						iosup->disconnectPathOutput(chan_pos, NULL);
+					}
+
+					int portsdepth = reader.depth();
+					while (reader.next_child (portsdepth))
+					{
+						if (reader.name() != "Port" || !reader.property ("name", value)) continue;
+
+						if (keep && inputs) {
+							staged->channels[chan_pos].inputs.push_back (value);
+						}
+						else if (keep) {
+							staged->channels[chan_pos].outputs.push_back (value);
+						}
+						
+						if (connect && inputs) {
+							iosup->connectPathInput(chan_pos, value.c_str());
+						}
+						else if (connect) {
+							iosup->connectPathOutput(chan_pos, value.c_str());
+						}
+					}
 					continue;
 				}
-				std::string filtfname = prop->value();
-
-				FTspectrumModifier * specmod = procmod->getFilter (fpos);
-				if (!specmod) {
-					fprintf (stderr, "no filter at index %lu in procmod!\n", fpos); 
+				else if (reader.name() != "ProcMods") {
 					continue;
 				}
 
-				// load filter
-				wxTextFile filtfile (dirname
-						     + wxFileName::GetPathSeparator()
-						     + wxString::Format (wxT("%d_"), (int) chan_pos)
-						     + wxString::Format (wxT("%d_"), (int) ppos)
-						     + wxString::FromAscii (specmod->getConfigName().c_str())
-						     + wxT(".filter"));
-				if (filtfile.Open()) {
+				gotprocmods = true;
+				int pmsdepth = reader.depth();
 
-					loadFilter (specmod, filtfile);
-					filtfile.Close();
-				}
+				while (reader.next_child (pmsdepth))
+				{
+					if (reader.name() != "ProcMod") continue;
 
-				// set bypassed
-				if ((prop = filtNode->property ("bypassed"))) {
-					wxString value (wxString::FromAscii (prop->value().c_str()));
-					if (value.ToULong(&uval)) {
-						specmod->setBypassed (uval==1 ? true: false);
+					if (!reader.property ("pos", value)) {
+						fprintf (stderr, "pos missing in procmod!\n");
+						continue;
+					}
+					unsigned long ppos;
+					if (!wxString::FromAscii (value.c_str()).ToULong (&ppos)) {
+						fprintf (stderr, "invalid pos in procmod!\n");
+						continue;
 					}
-				}
 
-				// actual linkage must wait for later
-				long linked = -1;
-				if ((prop = filtNode->property ("linked"))) {
-					wxString value (wxString::FromAscii (prop->value().c_str()));
-					if (value.ToLong(&linked) && linked >= 0) {
-						
-						_linkCache.push_back (LinkCache(chan_pos, linked, ppos, fpos));
+					if (!reader.property ("name", value)) {
+						fprintf (stderr, "name missing in procmod!\n");
+						continue;
+					}
+					string pmname = value;
+
+					// construct new procmod
+					FTprocI * procmod = FTdspManager::instance()->getModuleByConfigName(pmname);
+					if (!procmod) {
+						fprintf (stderr, "no proc module '%s' supported\n", pmname.c_str());
+						if (staged) staged->dropped++;
+						continue;
+					}
+					procmod = procmod->clone();
+
+					// must call this before initialization
+					procmod->setMaxDelay ((float)max_delay);
+
+					procmod->initialize();
+
+					if (!ignore_iosup) {
+						procmod->setSampleRate (iosup->getSampleRate());
 					}
 					else {
-						specmod->unlink(false);
+						// no engine to size it, take the preset's
+						procmod->setFFTsize ((unsigned int) fft_size);
 					}
-				}
 
-				// extra node
-				XMLNode * extraNode = find_named_node (filtNode, "Extra");
-				
-				if (extraNode) {
-					specmod->setExtraNode (extraNode);
-				}
-			}
+					procmod->setOversamp ((int)oversamp);
 
-			// insert procmod
+					// load up the filters in the procmod
+					int pmdepth = reader.depth();
 
-			if (!ignore_iosup)
-			{
-				engine->insertProcessorModule (procmod, ppos);
-			}
-			else {
-				// add to vector in the right spot
-				vector<FTprocI*>::iterator iter = procvec[chan_pos].begin();
-				
-				for (unsigned int n=0; n < ppos && iter!=procvec[chan_pos].end(); ++n) {
-					++iter;
-				}
-				
-				procvec[chan_pos].insert (iter, procmod);
-			}
-		}
+					while (reader.next_child (pmdepth))
+					{
+						if (reader.name() != "Filter") continue;
 
+						if (!reader.property ("pos", value)) {
+							fprintf (stderr, "pos missing in filter!\n");
+							continue;
+						}
+						unsigned long fpos;
+						if (!wxString::FromAscii (value.c_str()).ToULong (&fpos)) {
+							fprintf (stderr, "invalid filter pos in channel!\n");
+							continue;
+						}
 
-		if (ignore_iosup) {
-			// can skip to the next one
-			continue;
-		}
-		
-		// apply global settings
-		engine->setFFTsize ((FTspectralEngine::FFT_Size) fft_size);
-		engine->setWindowing ((FTspectralEngine::Windowing) windowing);
-		engine->setUpdateSpeed ((FTspectralEngine::UpdateSpeed)(int) update_speed);
-		
+						FTspectrumModifier * specmod = procmod->getFilter (fpos);
+						if (!specmod) {
+							fprintf (stderr, "no filter at index %lu in procmod!\n", fpos);
+							if (staged) staged->dropped++;
+							continue;
+						}
 
-		// input ports
+						if (!isdir) {
+							unsigned int length = 0;
+							const float * bins = binfile.getFilter (chan_pos, ppos, fpos, length);
+
+							if (bins) {
+								// straight from the file in one edit, then
+								// rendered at the size the procmod runs at
+								int size = specmod->getLength();
+								specmod->setLength (length);
+								if ((unsigned int) specmod->getLength() < length) {
+									length = specmod->getLength();
+								}
+								memcpy (specmod->beginEdit(), bins, length * sizeof(float));
+								specmod->commitEdit();
+								specmod->setLength (size);
+							}
+						}
+						else {
+							if (!reader.property ("file", value)) {
+								fprintf (stderr, "filter filename missing in procmod!\n");
+								continue;
+							}
 
-		if (restore_ports)
-		{
-			XMLNode * inputsNode = find_named_node (chanNode, "Inputs");
-			if (inputsNode )
-			{
-				XMLNodeList portlist = inputsNode->children();
-				XMLNodeConstIterator portiter;
+							// load filter
+							wxTextFile filtfile (dirname
+									     + wxFileName::GetPathSeparator()
+									     + wxString::Format (wxT("%d_"), (int) chan_pos)
+									     + wxString::Format (wxT("%d_"), (int) ppos)
+									     + wxString::FromAscii (specmod->getConfigName().c_str())
+									     + wxT(".filter"));
+							if (filtfile.Open()) {
+
+								loadFilter (specmod, filtfile);
+								filtfile.Close();
+							}
+						}
 
-				iosup->disconnectPathInput(chan_pos, NULL); // disconnect all
-			
-				for (portiter = portlist.begin(); portiter != portlist.end(); ++portiter)
-				{
-					XMLNode * port = *portiter;
-					if (port->name() == "Port") {
-						XMLProperty * prop = port->property("name");
-						if (prop) {
-							iosup->connectPathInput(chan_pos, prop->value().c_str());
+						// set bypassed
+						if (reader.property ("bypassed", value)) {
+							if (wxString::FromAscii (value.c_str()).ToULong (&uval)) {
+								specmod->setBypassed (uval==1 ? true: false);
+							}
+						}
+
+						// actual linkage must wait for later
+						long linked = -1;
+						if (reader.property ("linked", value)) {
+							if (wxString::FromAscii (value.c_str()).ToLong (&linked) && linked >= 0) {
+
+								_linkCache.push_back (LinkCache(chan_pos, linked, ppos, fpos));
+							}
+							else {
+								specmod->unlink(false);
+							}
+						}
+
+						// extra node, the one part kept as a tree
+						int filtdepth = reader.depth();
+						while (reader.next_child (filtdepth))
+						{
+							if (reader.name() == "Extra") {
+								XMLNode * extraNode = reader.expand();
+								specmod->setExtraNode (extraNode);
+								delete extraNode;
+							}
 						}
 					}
-				}
-			
-			}
-			else {
-				fprintf (stderr, "channel inputs node not found in %s!\n", configfname.c_str()); 
-			}
 
-			// output ports
-			XMLNode * outputsNode = find_named_node (chanNode, "Outputs");
-			if (inputsNode )
-			{
-				XMLNodeList portlist = outputsNode->children();
-				XMLNodeConstIterator portiter;
+					// insert procmod
 
-				iosup->disconnectPathOutput(chan_pos, NULL); // disconnect all
-			
-				for (portiter = portlist.begin(); portiter != portlist.end(); ++portiter)
-				{
-					XMLNode * port = *portiter;
-					if (port->name() == "Port") {
-						XMLProperty * prop = port->property("name");
-						if (prop) {
-							iosup->connectPathOutput(chan_pos, prop->value().c_str());
+					if (!ignore_iosup)
+					{
+						engine->insertProcessorModule (procmod, ppos);
+					}
+					else {
+						// add to vector in the right spot
+						vector<FTprocI*>::iterator iter = procvec[chan_pos].begin();
+
+						for (unsigned int n=0; n < ppos && iter!=procvec[chan_pos].end(); ++n) {
+							++iter;
 						}
+
+						procvec[chan_pos].insert (iter, procmod);
+						procmod->setId ((int) chan_pos);
 					}
 				}
-			
 			}
-			else {
-				fprintf (stderr, "channel outputs node not found in %s!\n", configfname.c_str()); 
+
+			if (!gotprocmods) {
+				fprintf (stderr, "Preset ProcMods node not found in %s!\n", configfname.c_str());
+				return false;
 			}
-		}		
 
-// 		// TEMPORARY
-// 		FTprocI * firstproc = engine->getProcessorModule(0);
-// 		if (firstproc) {
-// 			FTmodulatorI * modul = FTmodulatorManager::instance()->getModuleByConfigName("Shift")->clone();
-// 			modul->initialize();
-// 			modul->addSpecMod (firstproc->getFilter(0));
-// 			engine->appendModulator(modul);
-// 		}
-	}
+			if (ignore_iosup) {
+				// can skip to the next one
+				continue;
+			}
 
-	// Modulations
+			// apply global settings
+			engine->setFFTsize ((FTspectralEngine::FFT_Size) fft_size);
+			engine->setWindowing ((FTspectralEngine::Windowing) windowing);
+			engine->setUpdateSpeed ((FTspectralEngine::UpdateSpeed)(int) update_speed);
 
-	// clear all modulators from all engines
-	for (int i=0; i < FTioSupport::instance()->getActivePathCount(); i++) {
-		FTprocessPath * procpath = FTioSupport::instance()->getProcessPath(i);
-		if (procpath) {
-			FTspectralEngine *engine = procpath->getSpectralEngine();
-			
-			engine->clearModulators ();
+			if (restore_ports && !gotinputs) {
+				fprintf (stderr, "channel inputs node not found in %s!\n", configfname.c_str());
+			}
+			if (restore_ports && !gotoutputs) {
+				fprintf (stderr, "channel outputs node not found in %s!\n", configfname.c_str());
+			}
+		}
+
+		if (chancount < 1) {
+			fprintf (stderr, "No channels found in %s!\n", configfname.c_str());
+			return false;
+		}
+
+		if (!ignore_iosup) {
+			// set all remaining paths inactive
+			for (unsigned int i = chancount; i < FT_MAXPATHS; i++) {
+				iosup->setProcessPathActive(i, false);
+			}
+
+			// clear all modulators from all engines, before any
+			// Modulators that follow
+			for (int i=0; i < FTioSupport::instance()->getActivePathCount(); i++) {
+				FTprocessPath * procpath = FTioSupport::instance()->getProcessPath(i);
+				if (procpath) {
+					FTspectralEngine *engine = procpath->getSpectralEngine();
+
+					engine->clearModulators ();
+				}
+			}
 		}
-	}
-	
-	
-	XMLNode * modulatorsNode = find_named_node (rootNode, "Modulators");
-	if ( modulatorsNode )
-	{
-		
-		loadModulators (modulatorsNode);
-		
 	}
 
+	if (reader.error()) {
+		fprintf (stderr, "Error reading config at %s!\n", configfname.c_str());
+	}
 
+	if (!gotchannels) {
+		fprintf (stderr, "Preset Channels node not found in %s!\n", configfname.c_str());
+		return false;
+	}
 
-	
 	if (!ignore_iosup)
 	{
 		// now we can apply linkages
@@ -883,82 +1354,93 @@ bool FTconfigManager::loadSettings (const std::string &name, bool restore_ports,
 			else {
 				fprintf(stderr, "could not link! source or dest does not exist!\n");
 			}
-		
+
 		}
-	
+
 	}
 	else
 	{
 		// just use the stored ones
-		list<LinkCache>::iterator liter;
-		for (liter = _linkCache.begin(); liter != _linkCache.end(); ++liter)
-		{
-			LinkCache & lc = *liter;
+		linkLoaded (procvec);
+	}
+
+
+	return true;
+}
+
+void FTconfigManager::linkLoaded (vector<vector <FTprocI *> > & procvec)
+{
+	list<LinkCache>::iterator liter;
+	for (liter = _linkCache.begin(); liter != _linkCache.end(); ++liter)
+	{
+		LinkCache & lc = *liter;
 
-			FTspectrumModifier *source = procvec[lc.source_chan][lc.mod_n]->getFilter(lc.filt_n);
-			FTspectrumModifier *dest = procvec[lc.dest_chan][lc.mod_n]->getFilter(lc.filt_n);
+		FTspectrumModifier *source = 0;
+		FTspectrumModifier *dest = 0;
 
+		if (lc.source_chan < procvec.size() && lc.mod_n < procvec[lc.source_chan].size()) {
+			source = procvec[lc.source_chan][lc.mod_n]->getFilter(lc.filt_n);
+		}
+		if (lc.dest_chan < procvec.size() && lc.mod_n < procvec[lc.dest_chan].size()) {
+			dest = procvec[lc.dest_chan][lc.mod_n]->getFilter(lc.filt_n);
+		}
+
+		if (dest && source && dest != source) {
 			source->link (dest);
 		}
+		else {
+			fprintf(stderr, "could not link! source or dest does not exist!\n");
+		}
 	}
-	
-	
-	return true;
 }
 
 
-void FTconfigManager::loadModulators (const XMLNode * modulatorsNode)
+void FTconfigManager::loadModulators (XMLReader & reader, FTstagedPreset * staged)
 {
-
-	XMLNodeList modlist = modulatorsNode->children();
-	XMLNodeConstIterator moditer;
-	XMLNode * modNode;
-	XMLProperty * prop;
+	string value;
 	wxString tmpstr;
+	int modsdepth = reader.depth();
 
-	
-	for (moditer=modlist.begin(); moditer != modlist.end(); ++moditer)
+	while (reader.next_child (modsdepth))
 	{
-		modNode = *moditer;
-			
-		if (modNode->name() != "Modulator") continue;
+		if (reader.name() != "Modulator") continue;
 
-		if (!(prop = modNode->property ("name"))) {
-			fprintf (stderr, "name missing in modulator!\n"); 
+		if (!reader.property ("name", value)) {
+			fprintf (stderr, "name missing in modulator!\n");
 			continue;
 		}
-		string modname = prop->value();
+		string modname = value;
 
 		string usermodname;
-		if (!(prop = modNode->property ("user_name"))) {
-			fprintf (stderr, "user_name missing in modulator!\n"); 
+		if (!reader.property ("user_name", value)) {
+			fprintf (stderr, "user_name missing in modulator!\n");
 		} else {
-			usermodname = prop->value();
+			usermodname = value;
 		}
-			
+
 
 		bool bypass = false;
-		if (!(prop = modNode->property ("bypassed"))) {
-			fprintf (stderr, "bypassed missing in modulator!\n"); 
+		if (!reader.property ("bypassed", value)) {
+			fprintf (stderr, "bypassed missing in modulator!\n");
 		}
 		else {
 			unsigned long bypassi = 0;
-				
-			tmpstr = wxString::FromAscii (prop->value().c_str());
+
+			tmpstr = wxString::FromAscii (value.c_str());
 			if (!tmpstr.ToULong (&bypassi)) {
-				fprintf (stderr, "invalid bypass flag in modulator!\n"); 
+				fprintf (stderr, "invalid bypass flag in modulator!\n");
 			}
 			bypass = (bypassi==0 ? false: true);
 		}
 
 		long channel = -1;
-		if (!(prop = modNode->property ("channel"))) {
-			fprintf (stderr, "channel missing in modulator!\n"); 
+		if (!reader.property ("channel", value)) {
+			fprintf (stderr, "channel missing in modulator!\n");
 		} else
 		{
-			tmpstr = wxString::FromAscii (prop->value().c_str());
+			tmpstr = wxString::FromAscii (value.c_str());
 			if (!tmpstr.ToLong (&channel)) {
-				fprintf (stderr, "invalid channel in modulator!\n"); 
+				fprintf (stderr, "invalid channel in modulator!\n");
 			}
 		}
 
@@ -967,9 +1449,10 @@ void FTconfigManager::loadModulators (const XMLNode * modulatorsNode)
 		FTmodulatorI * protomod = FTmodulatorManager::instance()->getModuleByConfigName (modname);
 		if (!protomod) {
 			fprintf (stderr, "module %s could not be found\n", modname.c_str());
+			if (staged) staged->dropped++;
 			continue;
 		}
-			
+
 		FTmodulatorI * mod = protomod->clone();
 		mod->initialize();
 
@@ -979,169 +1462,189 @@ void FTconfigManager::loadModulators (const XMLNode * modulatorsNode)
 		// get all controls from real one
 		FTmodulatorI::ControlList ctrllist;
 		mod->getControls (ctrllist);
-			
-		// now do controls
-		XMLNode * modControlsNode = find_named_node (modNode, "Controls");
-		if (modControlsNode) {
-			XMLNodeList modctrllist = modControlsNode->children();
-			XMLNodeConstIterator modctrliter;
-			XMLNode * ctrlNode;
-				
-			for (modctrliter=modctrllist.begin(); modctrliter != modctrllist.end(); ++modctrliter)
+
+		bool gotcontrols = false;
+		int moddepth = reader.depth();
+
+		while (reader.next_child (moddepth))
+		{
+			if (reader.name() == "Controls")
 			{
-				ctrlNode = *modctrliter;
-				if (ctrlNode->name() != "Control") continue;
-					
-				if (!(prop = ctrlNode->property ("name"))) {
-					fprintf (stderr, "name missing in modulator control!\n"); 
-					continue;
-				}
-				string ctrlname = prop->value();
+				gotcontrols = true;
 
-					
-				// lookup control by name
-				for (FTmodulatorI::ControlList::iterator citer = ctrllist.begin(); citer != ctrllist.end(); ++citer) {
+				// now do controls
+				int ctrlsdepth = reader.depth();
 
-					FTmodulatorI::Control * ctrl = (*citer);
-					if (ctrl->getConfName() == ctrlname)
-					{
-						if (ctrl->getType() == FTmodulatorI::Control::IntegerType) {
-							long intval = 0;
-							if (!(prop = ctrlNode->property ("value"))) {
-								fprintf (stderr, "int value missing in modulator control!\n"); 
-							} else
-							{
-								tmpstr = wxString::FromAscii (prop->value().c_str());
-								if (!tmpstr.ToLong (&intval)) {
-									fprintf (stderr, "invalid value in modulator control!\n"); 
-								}
-								else {
-									ctrl->setValue ((int)intval);
+				while (reader.next_child (ctrlsdepth))
+				{
+					if (reader.name() != "Control") continue;
+
+					if (!reader.property ("name", value)) {
+						fprintf (stderr, "name missing in modulator control!\n");
+						continue;
+					}
+					string ctrlname = value;
+
+
+					// lookup control by name
+					for (FTmodulatorI::ControlList::iterator citer = ctrllist.begin(); citer != ctrllist.end(); ++citer) {
+
+						FTmodulatorI::Control * ctrl = (*citer);
+						if (ctrl->getConfName() == ctrlname)
+						{
+							if (ctrl->getType() == FTmodulatorI::Control::IntegerType) {
+								long intval = 0;
+								if (!reader.property ("value", value)) {
+									fprintf (stderr, "int value missing in modulator control!\n");
+								} else
+								{
+									tmpstr = wxString::FromAscii (value.c_str());
+									if (!tmpstr.ToLong (&intval)) {
+										fprintf (stderr, "invalid value in modulator control!\n");
+									}
+									else {
+										ctrl->setValue ((int)intval);
+									}
 								}
 							}
-						}
-						else if (ctrl->getType() == FTmodulatorI::Control::FloatType) {
-							double fval = 0;
-							if (!(prop = ctrlNode->property ("value"))) {
-								fprintf (stderr, "float value missing in modulator control!\n"); 
-							} else
-							{
-								tmpstr = wxString::FromAscii (prop->value().c_str());
-								if (!tmpstr.ToDouble (&fval)) {
-									fprintf (stderr, "invalid value in modulator control!\n"); 
-								}
-								else {
-									ctrl->setValue ((float)fval);
+							else if (ctrl->getType() == FTmodulatorI::Control::FloatType) {
+								double fval = 0;
+								if (!reader.property ("value", value)) {
+									fprintf (stderr, "float value missing in modulator control!\n");
+								} else
+								{
+									tmpstr = wxString::FromAscii (value.c_str());
+									if (!tmpstr.ToDouble (&fval)) {
+										fprintf (stderr, "invalid value in modulator control!\n");
+									}
+									else {
+										ctrl->setValue ((float)fval);
+									}
 								}
 							}
-						}
-						else if (ctrl->getType() == FTmodulatorI::Control::StringType ||
-							 ctrl->getType() == FTmodulatorI::Control::EnumType)
-						{
-							if (!(prop = ctrlNode->property ("value"))) {
-								fprintf (stderr, "string enum value missing in modulator control!\n"); 
-							} else {
-								string valstr = prop->value();
-								ctrl->setValue(valstr);
-							}
-						}
-						else if (ctrl->getType() == FTmodulatorI::Control::BooleanType) {
-							long intval = 0;
-							if (!(prop = ctrlNode->property ("value"))) {
-								fprintf (stderr, "bool value missing in modulator control!\n"); 
-							} else
+							else if (ctrl->getType() == FTmodulatorI::Control::StringType ||
+								 ctrl->getType() == FTmodulatorI::Control::EnumType)
 							{
-								tmpstr = wxString::FromAscii (prop->value().c_str());
-								if (!tmpstr.ToLong (&intval)) {
-									fprintf (stderr, "invalid value in modulator control!\n"); 
+								if (!reader.property ("value", value)) {
+									fprintf (stderr, "string enum value missing in modulator control!\n");
+								} else {
+									ctrl->setValue(value);
 								}
-								else {
-									ctrl->setValue ((intval == 0 ? false : true));
+							}
+							else if (ctrl->getType() == FTmodulatorI::Control::BooleanType) {
+								long intval = 0;
+								if (!reader.property ("value", value)) {
+									fprintf (stderr, "bool value missing in modulator control!\n");
+								} else
+								{
+									tmpstr = wxString::FromAscii (value.c_str());
+									if (!tmpstr.ToLong (&intval)) {
+										fprintf (stderr, "invalid value in modulator control!\n");
+									}
+									else {
+										ctrl->setValue ((intval == 0 ? false : true));
+									}
 								}
 							}
-						}
 
-							
-						break;
+
+							break;
+						}
 					}
 				}
-					
-					
-
 			}
-			
-		} else {
-			fprintf (stderr, "module controls node could not be found\n");
-		}
+			else if (reader.name() == "Filters")
+			{
+				// link to filters
+				int filtsdepth = reader.depth();
 
+				while (reader.next_child (filtsdepth))
+				{
+					if (reader.name() != "Filter") continue;
 
-		// link to filters
+					unsigned long filtchan = 0;
 
-		XMLNode * modFiltersNode = find_named_node (modNode, "Filters");
-		if (modFiltersNode) {
-			XMLNodeList filtlist = modFiltersNode->children();
-			XMLNodeConstIterator filtiter;
-			XMLNode * filtNode;
-				
-			for (filtiter=filtlist.begin(); filtiter != filtlist.end(); ++filtiter)
-			{
-				filtNode = *filtiter;
-				if (filtNode->name() != "Filter") continue;
+					if (!reader.property ("channel", value)) {
+						fprintf (stderr, "int value missing in modulator filter channel!\n");
+						continue;
+					}
+					tmpstr = wxString::FromAscii (value.c_str());
+					if (!tmpstr.ToULong (&filtchan)) {
+						fprintf (stderr, "invalid channel value in modulator filter control!\n");
+						continue;
+					}
 
-				unsigned long filtchan = 0;
+					unsigned long modpos = 0;
 
-				if (!(prop = filtNode->property ("channel"))) {
-					fprintf (stderr, "int value missing in modulator filter channel!\n"); 
-					continue;
-				} 
-				tmpstr = wxString::FromAscii (prop->value().c_str());
-				if (!tmpstr.ToULong (&filtchan)) {
-					fprintf (stderr, "invalid channel value in modulator filter control!\n"); 
-					continue;
-				}
+					if (!reader.property ("modpos", value)) {
+						fprintf (stderr, "int value missing in modulator filter pos!\n");
+						continue;
+					}
+					tmpstr = wxString::FromAscii (value.c_str());
+					if (!tmpstr.ToULong (&modpos)) {
+						fprintf (stderr, "invalid modpos value in modulator filter pos control!\n");
+						continue;
+					}
 
-				unsigned long modpos = 0;
+					unsigned long filtpos = 0;
 
-				if (!(prop = filtNode->property ("modpos"))) {
-					fprintf (stderr, "int value missing in modulator filter pos!\n"); 
-					continue;
-				} 
-				tmpstr = wxString::FromAscii (prop->value().c_str());
-				if (!tmpstr.ToULong (&modpos)) {
-					fprintf (stderr, "invalid modpos value in modulator filter pos control!\n"); 
-					continue;
-				}
-				
-				unsigned long filtpos = 0;
+					if (!reader.property ("filtpos", value)) {
+						fprintf (stderr, "int value missing in modulator filter pos!\n");
+						continue;
+					}
+					tmpstr = wxString::FromAscii (value.c_str());
+					if (!tmpstr.ToULong (&filtpos)) {
+						fprintf (stderr, "invalid channel value in modulator filter pos control!\n");
+						continue;
+					}
 
-				if (!(prop = filtNode->property ("filtpos"))) {
-					fprintf (stderr, "int value missing in modulator filter pos!\n"); 
-					continue;
-				} 
-				tmpstr = wxString::FromAscii (prop->value().c_str());
-				if (!tmpstr.ToULong (&filtpos)) {
-					fprintf (stderr, "invalid channel value in modulator filter pos control!\n"); 
-					continue;
-				}
+					// finally look it up
+					FTspectrumModifier * specmod = 0;
+
+					if (!staged) {
+						specmod = lookupFilter (filtchan, modpos, filtpos);
+					}
+					else if (filtchan < staged->procvec.size() && modpos < staged->procvec[filtchan].size()) {
+						specmod = staged->procvec[filtchan][modpos]->getFilter (filtpos);
+					}
 
-				// finally look it up
-				FTspectrumModifier * specmod = lookupFilter (filtchan, modpos, filtpos);
+					if (specmod) {
+						mod->addSpecMod (specmod);
 
-				if (specmod) {
-					mod->addSpecMod (specmod);
+						double depth = 1.0;
+						if (reader.property ("depth", value)) {
+							tmpstr = wxString::FromAscii (value.c_str());
+							if (tmpstr.ToDouble (&depth)) {
+								mod->setRouteDepth (specmod, (float) depth);
+							}
+							else {
+								fprintf (stderr, "invalid depth value in modulator filter!\n");
+							}
+						}
+					}
 				}
-				
 			}
 		}
-		
-		
+
+		if (!gotcontrols) {
+			fprintf (stderr, "module controls node could not be found\n");
+		}
+
 		// add it to proper spectral engine
-		
-		if (channel > -1) {
+
+		if (staged) {
+			if (channel > -1 && channel < (long) staged->modvec.size()) {
+				staged->modvec[channel].push_back (mod);
+			}
+			else {
+				delete mod;
+			}
+		}
+		else if (channel > -1) {
 			FTprocessPath * procpath = FTioSupport::instance()->getProcessPath(channel);
 			if (procpath) {
 				FTspectralEngine *engine = procpath->getSpectralEngine();
-				
+
 				engine->appendModulator (mod);
 			}
 			else {
@@ -1152,8 +1655,8 @@ void FTconfigManager::loadModulators (const XMLNode * modulatorsNode)
 			// for NOW, just delete it
 			delete mod;
 		}
-		
-			
+
+
 	}
 
 }
@@ -1171,7 +1674,9 @@ void FTconfigManager::loadFilter (FTspectrumModifier *specmod, wxTextFile & tf)
 	// the value is assigned to the bin following the most recently filled bin.
 	// The bin indexes start from 0 and the ranges are inclusive
 
-	float *values = specmod->getValues();
+	// the whole file goes over in one edit
+	float *values = specmod->beginEdit();
+	int totbins = specmod->getLength();
 	
 	// parse lines from it
 	wxString line;
@@ -1206,7 +1711,7 @@ void FTconfigManager::loadFilter (FTspectrumModifier *specmod, wxTextFile & tf)
 			if (rangestr.BeforeFirst(':').ToULong(&sbin)
 			    && rangestr.AfterFirst(':').ToULong(&ebin))
 			{
-				for (unsigned int j=sbin; j <=ebin; j++) {
+				for (unsigned int j=sbin; j <=ebin && j < (unsigned int) totbins; j++) {
 					if (value.ToDouble(&val)) {
 						values[j] = (float) val;
 					}
@@ -1221,7 +1726,7 @@ void FTconfigManager::loadFilter (FTspectrumModifier *specmod, wxTextFile & tf)
 			lastbin += 1;
 			// printf ("bin=%d  value is %s\n", lastbin, value.c_str());
 
-			if (value.ToDouble(&val)) {
+			if (lastbin < totbins && value.ToDouble(&val)) {
 				values[lastbin] = (float) val;
 			}
 			
@@ -1230,7 +1735,7 @@ void FTconfigManager::loadFilter (FTspectrumModifier *specmod, wxTextFile & tf)
 		
 	}
 
-	
+	specmod->commitEdit();
 }
 
 
@@ -1250,7 +1755,7 @@ void FTconfigManager::writeFilter (FTspectrumModifier *specmod, wxTextFile & tf)
 	// the value is assigned to the bin following the most recently filled bin.
 	// The bin indexes start from 0 and the ranges are inclusive
 	
-	float * values = specmod->getValues();
+	const float * values = specmod->getLatestValues();
 	
 	int totbins = specmod->getLength();
 	int pos = 0;
@@ -1292,64 +1797,288 @@ list<string> FTconfigManager::getSettingsNames()
         wxString dirname (wxString::FromAscii(_basedir.c_str()) + wxFileName::GetPathSeparator() + wxT("presets"));
 
 	list<string> flist;
+
+	// only lists the directory if it changed
+	_index.getNames (flist);
+
+	// and new ones not written yet
+	list<string> pending;
+	_writer.getPending (pending);
+
+	string predir (static_cast<const char *> ((dirname + wxFileName::GetPathSeparator()).fn_str()));
+	string ext (FT_PRESET_EXT);
 	
-	wxDir dir(dirname);
-	if ( !dir.IsOpened() ) {
-		return flist;
+	for (list<string>::iterator iter = pending.begin(); iter != pending.end(); ++iter)
+	{
+		const string & path = *iter;
+		
+		if (path.size() > predir.size() + ext.size() && path.compare (0, predir.size(), predir) == 0
+		    && path.compare (path.size() - ext.size(), ext.size(), ext) == 0)
+		{
+			string name = path.substr (predir.size(), path.size() - predir.size() - ext.size());
+			if (find (flist.begin(), flist.end(), name) == flist.end()) {
+				flist.push_back (name);
+			}
+		}
 	}
+	
+	return flist;
+}
 
-	wxString filename;
+const FTpresetIndex::Entry * FTconfigManager::getSettingsInfo (const std::string & name)
+{
+	// a store may still be on its way
+	_writer.wait (static_cast<const char *> ((getSettingsPath (name, false) + wxString::FromAscii (FT_PRESET_EXT)).fn_str()));
 
-	
-	bool cont = dir.GetFirst(&filename, wxT(""), wxDIR_DIRS);
+	return _index.lookup (name);
+}
 
-	while ( cont )
+list<string> FTconfigManager::searchSettings (const std::string & text)
+{
+	list<string> names;
+	_index.search (text, names);
+	return names;
+}
+
+void FTconfigManager::setSettingsTags (const std::string & name, const vector<std::string> & tags)
+{
+	_index.setTags (name, tags);
+	saveIndex();
+}
+
+void FTconfigManager::stageSettings (const list<std::string> & names)
+{
+	// drop the ones nobody wants anymore
+	list<FTstagedPreset*>::iterator iter = _staged.begin();
+	while (iter != _staged.end()) {
+		if (find (names.begin(), names.end(), (*iter)->name) == names.end()) {
+			delete (*iter);
+			iter = _staged.erase (iter);
+		}
+		else {
+			++iter;
+		}
+	}
+	
+	for (list<std::string>::const_iterator name = names.begin(); name != names.end(); ++name)
 	{
-		//printf ("%s\n", filename.c_str());
-		flist.push_back (static_cast<const char *> (filename.fn_str()));
-		cont = dir.GetNext(&filename);
+		bool have = false;
+		for (iter = _staged.begin(); iter != _staged.end(); ++iter) {
+			if ((*iter)->name == *name) {
+				have = true;
+				break;
+			}
+		}
+
+		wxString path;
+		if (have || name->empty() || !findSettings (*name, false, path)) {
+			continue;
+		}
+
+		FTstagedPreset * staged = new FTstagedPreset();
+		staged->name = *name;
+
+		if (!loadSettingsFrom (path, false, true, staged->procvec, staged)) {
+			fprintf (stderr, "could not stage preset %s\n", name->c_str());
+			delete staged;
+			continue;
+		}
+
+		// start off on the loaded curves instead of ramping to them
+		for (unsigned int i=0; i < staged->procvec.size(); i++) {
+			for (unsigned int n=0; n < staged->procvec[i].size(); n++) {
+				staged->procvec[i][n]->settleFilters();
+			}
+		}
+		
+		_staged.push_back (staged);
 	}
+}
 
-	return flist;
+bool FTconfigManager::recallStaged (const std::string & name)
+{
+	FTstagedPreset * staged = 0;
+	list<FTstagedPreset*>::iterator iter;
+	
+	for (iter = _staged.begin(); iter != _staged.end(); ++iter) {
+		if ((*iter)->name == name) {
+			staged = (*iter);
+			break;
+		}
+	}
+
+	if (!staged) return false;
+
+	// only the chains can change on the fly
+	FTioSupport * iosup = FTioSupport::instance();
+	int chans = (int) staged->procvec.size();
+
+	if (chans != iosup->getActivePathCount()) {
+		return false;
+	}
+
+	vector<FTspectralEngine *> engines;
+	
+	for (int i=0; i < chans; i++) {
+		FTprocessPath * procpath = iosup->getProcessPath(i);
+		if (!procpath) return false;
+
+		FTspectralEngine * engine = procpath->getSpectralEngine();
+		
+		if (engine->getFFTsize() != staged->fft_size
+		    || engine->getOversamp() != staged->oversamp
+		    || fabsf (engine->getMaxDelay() - staged->max_delay) > 0.001f)
+		{
+			return false;
+		}
+
+		engines.push_back (engine);
+	}
+
+	// the last recall has to be out of the way first
+	finishRecall (true);
+	for (int i=0; i < chans; i++) {
+		engines[i]->stagedDone (true);
+	}
+	reclaimStaged();
+
+	if (_reclaimPending) {
+		return false;
+	}
+	
+	int fadehops = (int) (FT_RECALL_FADE_TIME * iosup->getSampleRate() * staged->oversamp / staged->fft_size);
+	unsigned int generation = FTspectralEngine::newStageGeneration();
+	vector<vector <FTmodulatorI *> > added = staged->modvec;
+
+	for (int i=0; i < chans; i++) {
+		engines[i]->stageProcessorModules (staged->procvec[i], staged->modvec[i], generation, fadehops);
+	}
+
+	// all of them go on the same hop
+	FTspectralEngine::activateStaged (generation);
+
+	// the engines own it all now, the rest waits for the swap
+	_staged.erase (iter);
+	_recalling = staged;
+	_recallAdded = added;
+	_recallPolls = 0;
+	
+	finishRecall();
+	
+	return true;
 }
 
-XMLNode *
-FTconfigManager::find_named_node (const XMLNode * node, string name)
+bool FTconfigManager::finishRecall (bool force)
 {
-        XMLNodeList nlist;
-        XMLNodeConstIterator niter;
-        XMLNode* child;
-                                                                                                      
-        nlist = node->children();
-                                                                                                      
-        for (niter = nlist.begin(); niter != nlist.end(); ++niter) {
-                                                                                                      
-                child = *niter;
-                                                                                                      
-                if (child->name() == name) {
-                        return child;
-                }
-        }
-                                                                                                      
-        return 0;
+	if (!_recalling) return false;
+
+	FTioSupport * iosup = FTioSupport::instance();
+	FTstagedPreset * staged = _recalling;
+	int chans = (int) staged->procvec.size();
+
+	vector<FTspectralEngine *> engines;
+	for (int i=0; i < chans && i < iosup->getActivePathCount(); i++) {
+		FTprocessPath * procpath = iosup->getProcessPath(i);
+		if (procpath) {
+			engines.push_back (procpath->getSpectralEngine());
+		}
+	}
+
+	bool swapped = true;
+	for (unsigned int i=0; i < engines.size(); i++) {
+		swapped = swapped && engines[i]->stagedSwapped();
+	}
+
+	// the process thread swaps on its next hop, if it still
+	// hasn't by the call after this it isn't going round
+	if (!swapped && !force && _recallPolls++ == 0) {
+		return false;
+	}
+	
+	for (unsigned int i=0; i < engines.size(); i++) {
+		// do it here if it hasn't
+		engines[i]->stagedSwapped (true);
+
+		FTstagedPreset::Channel & chanset = staged->channels[i];
+		engines[i]->setInputGain (chanset.input_gain);
+		engines[i]->setMixRatio (chanset.mix_ratio);
+		engines[i]->setBypassed (chanset.bypassed);
+		engines[i]->setMuted (chanset.muted);
+		engines[i]->setTempo (staged->tempo);
+		engines[i]->setWindowing ((FTspectralEngine::Windowing) staged->windowing);
+		engines[i]->setUpdateSpeed ((FTspectralEngine::UpdateSpeed) staged->update_speed);
+
+		for (vector<FTmodulatorI*>::iterator mod = _recallAdded[i].begin(); mod != _recallAdded[i].end(); ++mod) {
+			engines[i]->ModulatorAdded (*mod); // emit
+		}
+	}
+	
+	delete staged;
+	_recalling = 0;
+	_recallAdded.clear();
+	
+	_reclaimPending = true;
+	
+	return true;
 }
 
+void FTconfigManager::reclaimStaged ()
+{
+	if (!_reclaimPending) return;
+
+	FTioSupport * iosup = FTioSupport::instance();
+	
+	// filters can be linked across channels, nothing goes until
+	// every engine is done with it
+	for (int i=0; i < iosup->getActivePathCount(); i++) {
+		FTprocessPath * procpath = iosup->getProcessPath(i);
+		if (procpath && !procpath->getSpectralEngine()->stagedDone()) {
+			return;
+		}
+	}
 
-bool FTconfigManager::lookupFilterLocation (FTspectrumModifier * specmod, int & chan, int & modpos, int & filtpos)
+	vector<FTprocI *> procmods;
+	vector<FTmodulatorI *> mods;
+	
+	for (int i=0; i < iosup->getActivePathCount(); i++) {
+		FTprocessPath * procpath = iosup->getProcessPath(i);
+		if (procpath) {
+			procpath->getSpectralEngine()->reclaimStaged (procmods, mods);
+		}
+	}
+
+	// modulators first, they let go of the filters
+	for (vector<FTmodulatorI*>::iterator mod = mods.begin(); mod != mods.end(); ++mod) {
+		delete (*mod);
+	}
+	for (vector<FTprocI*>::iterator pm = procmods.begin(); pm != procmods.end(); ++pm) {
+		delete (*pm);
+	}
+
+	_reclaimPending = false;
+}
+
+bool FTconfigManager::lookupFilterLocation (FTspectrumModifier * specmod, int & chan, int & modpos, int & filtpos,
+					    FTstagedPreset * staged)
 {
 	// brute force
 	FTioSupport * iosup = FTioSupport::instance();
 	bool done = false;
+	int chans = staged ? (int) staged->procvec.size() : iosup->getActivePathCount();
 	
-	for (int i=0; i < iosup->getActivePathCount(); i++)
+	for (int i=0; i < chans; i++)
 	{
-		FTprocessPath * procpath = iosup->getProcessPath(i);
-		if (!procpath) continue; // shouldnt happen
-
-		FTspectralEngine *engine = procpath->getSpectralEngine();
-	
 		vector<FTprocI *> procmods;
-		engine->getProcessorModules (procmods);
+
+		if (staged) {
+			procmods = staged->procvec[i];
+		}
+		else {
+			FTprocessPath * procpath = iosup->getProcessPath(i);
+			if (!procpath) continue; // shouldnt happen
+
+			procpath->getSpectralEngine()->getProcessorModules (procmods);
+		}
 	
 		for (unsigned int n=0; n < procmods.size(); ++n)
 		{
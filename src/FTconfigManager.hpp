@@ -27,12 +27,69 @@
 #include <string>
 #include <list>
 #include <vector>
+#include <map>
+#include <ctime>
 using namespace std;
 
+#include "FTsettingsWriter.hpp"
+#include "FTpresetIndex.hpp"
+
 class FTspectralEngine;
 class FTspectrumModifier;
 class XMLNode;
+class XMLReader;
 class FTprocI;
+class FTmodulatorI;
+class FTpresetFile;
+
+// how long a staged recall crossfades from the old chain, in seconds
+#define FT_RECALL_FADE_TIME 0.05f
+
+// seconds between autosaves of the last setting
+#define FT_AUTOSAVE_INTERVAL 30
+
+
+// A preset built ahead of time, apart from the engines, so recalling
+// it only takes a swap.  See FTconfigManager::stageSettings()
+class FTstagedPreset
+{
+   public:
+	FTstagedPreset();
+	// deletes whatever it still holds
+	~FTstagedPreset();
+
+	struct Channel {
+		Channel() : input_gain(1.0f), mix_ratio(1.0f), bypassed(false), muted(false) {}
+		
+		float input_gain;
+		float mix_ratio;
+		bool bypassed;
+		bool muted;
+		// port connections as stored, only for readPreset()
+		vector<std::string> inputs;
+		vector<std::string> outputs;
+	};
+	
+	std::string name;
+	// comma separated, as stored
+	std::string tags;
+
+	int fft_size;
+	int windowing;
+	int update_speed;
+	int oversamp;
+	int tempo;
+	float max_delay;
+	
+	// all per channel
+	vector<Channel> channels;
+	vector<vector <FTprocI *> > procvec;
+	vector<vector <FTmodulatorI *> > modvec;
+
+	// modules, filters and modulators in the preset that couldn't
+	// be loaded, unknown or out of place
+	unsigned int dropped;
+};
 
 class FTconfigManager
 {
@@ -42,26 +99,99 @@ class FTconfigManager
 	virtual ~FTconfigManager();
 
 
+	// presets are stored as one binary file each (see FTpresetFile),
+	// loading also takes the directories older versions wrote.
+	// Storing takes a snapshot and leaves the writing to a
+	// background thread, loading waits for any write still pending.
+	// true only means it was queued, takeStored() tells how it went
 	bool storeSettings (const std::string &name, bool uselast=false);
+	// names of the presets written, and that failed to be, since
+	// the last call.  "" for the last setting
+	void takeStored (list<std::string> & stored, list<std::string> & failed);
+
+	// true once FT_AUTOSAVE_INTERVAL has passed since the last one
+	bool autosaveDue();
+	// stores the last setting if it changed since it was last stored
+	void autosave();
+	// blocks until every store has been written
+	void waitForSaves() { _writer.wait(); }
 
 	bool loadSettings (const std::string &name, bool restore_ports=false, bool uselast=false);
 	bool loadSettings (const std::string &name, bool restore_ports, bool ignore_iosup, vector<vector <FTprocI *> > & procvec, bool uselast);
 
-	list<std::string> getSettingsNames();
+	// the directory format, config.xml plus a text file per filter
+	bool exportSettings (const std::string &dirname);
+	bool importSettings (const std::string &dirname, bool restore_ports=false);
 
+	// from the preset index, see FTpresetIndex
+	list<std::string> getSettingsNames();
+	// 0 if there is no such preset
+	const FTpresetIndex::Entry * getSettingsInfo (const std::string & name);
+	// names of presets whose name, tags or modules contain text
+	list<std::string> searchSettings (const std::string & text);
+	// kept in the index, and stored with the preset the next time it is
+	void setSettingsTags (const std::string & name, const vector<std::string> & tags);
+
+	// Builds the named presets ahead of time, ready for
+	// recallStaged().  Staged presets not in names are dropped
+	void stageSettings (const list<std::string> & names);
+	// switches the running engines over to a staged preset without
+	// stopping them.  false if name isn't staged or doesn't fit the
+	// engines as they are (channels, fft size, overlap or max delay).
+	// The swap happens on the next hop, finishRecall() does the rest
+	bool recallStaged (const std::string & name);
+	// sets up the channels once the engines swapped to the recalled
+	// chains, true when this call did.  Call it every now and then
+	// after recallStaged(), force does it whether they swapped or not
+	bool finishRecall (bool force = false);
+	// deletes what recalls replaced once nothing runs it anymore,
+	// call it every now and then
+	void reclaimStaged ();
+
+	// Offline, for tools, the engines aren't touched.  Reads the
+	// preset file or directory at path, in any format this or an
+	// older version wrote, into preset.  false if it couldn't be
+	// read at all
+	bool readPreset (const std::string & path, FTstagedPreset & preset);
+	// writes preset to path as a preset file, or in the directory
+	// format if dirformat.  waits until it is on disk
+	bool writePreset (const std::string & path, FTstagedPreset & preset, bool dirformat=false);
+	
    protected:
 
+	// where name is stored, without the extension
+	wxString getSettingsPath (const std::string &name, bool uselast);
+	// the file or directory name is stored in, false if neither exists
+	bool findSettings (const std::string &name, bool uselast, wxString & path);
+
+	// the config tree for the current state, or for staged if given.
+	// filters go into binfile if given, otherwise into text files in
+	// dirname
+	XMLNode * buildSettings (const wxString & dirname, FTpresetFile * binfile, FTstagedPreset * staged=0);
+
+	// path is a preset file or directory
+	// path is a preset file or directory.  staged, with ignore_iosup,
+	// gets the settings and modulators the engines would have had
+	bool loadSettingsFrom (const wxString & path, bool restore_ports, bool ignore_iosup, vector<vector <FTprocI *> > & procvec,
+			       FTstagedPreset * staged=0);
+	// the per channel config.N files from before 0.5.0, into staged
+	bool loadLegacySettings (const wxString & dirname, FTstagedPreset * staged);
+	// applies _linkCache to a loaded chain
+	void linkLoaded (vector<vector <FTprocI *> > & procvec);
+	
 	void writeFilter (FTspectrumModifier *specmod, wxTextFile & tf);
 
 	void loadFilter (FTspectrumModifier *specmod, wxTextFile & tf);
 
-	bool lookupFilterLocation (FTspectrumModifier * specmod, int & chan, int & modpos, int & filtpos);
+	// in the running engines, or in staged if given
+	bool lookupFilterLocation (FTspectrumModifier * specmod, int & chan, int & modpos, int & filtpos,
+				   FTstagedPreset * staged=0);
 
 	FTspectrumModifier * lookupFilter (int  chan, int  modpos, int  filtpos);
 
-        void loadModulators (const XMLNode * modulatorsNode);
-	
-	XMLNode* find_named_node (const XMLNode * node, string name);
+	// onto the running engines, or into staged.  reader is on the
+	// Modulators element
+	void loadModulators (XMLReader & reader, FTstagedPreset * staged=0);
 	
 	std::string _basedir;
 
@@ -78,6 +208,25 @@ class FTconfigManager
 	};
 
 	list<LinkCache> _linkCache;
+
+	// hands the index to _writer if it changed
+	void saveIndex();
+	
+	FTsettingsWriter _writer;
+	// preset names by path, of what went to _writer
+	map<std::string, std::string> _storing;
+	FTpresetIndex _index;
+	// of the last setting as last stored, and when
+	uint32_t _lastSum;
+	time_t _lastAutosave;
+
+	list<FTstagedPreset *> _staged;
+	// recalled, waiting for the engines to swap
+	FTstagedPreset * _recalling;
+	vector<vector <FTmodulatorI *> > _recallAdded;
+	int _recallPolls;
+	// chains recalls replaced, not deleted yet
+	bool _reclaimPending;
 };
 
 
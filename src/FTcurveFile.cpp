@@ -0,0 +1,221 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#include <vector>
+
+#include "FTcurveFile.hpp"
+#include "FTspectrumModifier.hpp"
+
+using namespace std;
+
+// lowest gain written, in dB
+#define FT_CURVE_DB_FLOOR -100.0f
+
+
+static bool isGainType (FTspectrumModifier * specmod)
+{
+	return specmod->getModifierType() == FTspectrumModifier::GAIN_MODIFIER
+		|| specmod->getModifierType() == FTspectrumModifier::POS_GAIN_MODIFIER;
+}
+
+// the frequency and value at the start of line, false if it isn't a point
+static bool parsePoint (const char * line, double & freq, double & val)
+{
+	char * end;
+
+	freq = strtod (line, &end);
+	if (end == line) {
+		return false;
+	}
+
+	line = end;
+	while (*line == ',' || *line == ';' || *line == ' ' || *line == '\t') {
+		++line;
+	}
+	
+	val = strtod (line, &end);
+	return end != line && freq >= 0.0;
+}
+
+
+bool FTcurveFile::read (const string & path, float * values, int length, float nyquist, bool lineargain)
+{
+	FILE * in = fopen (path.c_str(), "r");
+	if (!in) {
+		fprintf (stderr, "Error opening %s: %s\n", path.c_str(), strerror(errno));
+		return false;
+	}
+
+	// per bin, for where the points are denser than the bins
+	vector<double> sums (length, 0.0);
+	vector<int> counts (length, 0);
+
+	const double binhz = nyquist / length;
+	double freq, val;
+	double lastfreq = 0.0, lastval = 0.0;
+	unsigned long points = 0, skipped = 0;
+	int k = 0;
+	char line[256];
+
+	while (fgets (line, sizeof(line), in))
+	{
+		bool whole = strchr (line, '\n') != 0;
+		bool point = parsePoint (line, freq, val);
+
+		// drop the rest of an overlong line
+		while (!whole && fgets (line, sizeof(line), in)) {
+			whole = strchr (line, '\n') != 0;
+		}
+		
+		if (!point) {
+			continue;
+		}
+		
+		if (points > 0 && freq < lastfreq) {
+			// the interpolation needs them in order
+			++skipped;
+			continue;
+		}
+
+		int bin = (int) (freq / binhz + 0.5);
+		if (bin < length) {
+			sums[bin] += val;
+			counts[bin]++;
+		}
+
+		// every bin up to here lies between the last point and this one
+		for ( ; k < length && k * binhz <= freq; ++k)
+		{
+			double binfreq = k * binhz;
+			
+			if (points == 0 || freq <= lastfreq) {
+				values[k] = val;
+			}
+			else if (lastfreq > 0.0 && binfreq > 0.0) {
+				double t = log (binfreq / lastfreq) / log (freq / lastfreq);
+				values[k] = lastval + t * (val - lastval);
+			}
+			else {
+				values[k] = lastval + (binfreq - lastfreq) / (freq - lastfreq) * (val - lastval);
+			}
+		}
+
+		lastfreq = freq;
+		lastval = val;
+		++points;
+	}
+
+	fclose (in);
+
+	if (points == 0) {
+		fprintf (stderr, "No frequency points found in %s\n", path.c_str());
+		return false;
+	}
+
+	if (skipped > 0) {
+		fprintf (stderr, "Skipped %lu points of %s that were out of frequency order\n", skipped, path.c_str());
+	}
+	
+	// past the last point
+	for ( ; k < length; ++k) {
+		values[k] = lastval;
+	}
+
+	for (k=0; k < length; ++k)
+	{
+		if (counts[k] > 1) {
+			values[k] = sums[k] / counts[k];
+		}
+		if (lineargain) {
+			values[k] = powf (10.0f, values[k] / 20.0f);
+		}
+	}
+
+	return true;
+}
+
+bool FTcurveFile::write (const string & path, const float * values, int length, float nyquist,
+			 bool lineargain, const string & name)
+{
+	FILE * out = fopen (path.c_str(), "w");
+	if (!out) {
+		fprintf (stderr, "Error opening %s for writing: %s\n", path.c_str(), strerror(errno));
+		return false;
+	}
+
+	bool csv = path.size() >= 4 && strcasecmp (path.c_str() + path.size() - 4, ".csv") == 0;
+	const char * format = csv ? "%.6g,%.6g\n" : "%.6g\t%.6g\n";
+	const double binhz = nyquist / length;
+	
+	fprintf (out, "* FreqTweak %s\n", name.c_str());
+	fprintf (out, csv ? "* Freq(Hz),%s\n" : "* Freq(Hz)\t%s\n", lineargain ? "dB" : "Value");
+
+	for (int k=0; k < length; ++k)
+	{
+		float val = values[k];
+		
+		if (lineargain) {
+			val = val > 0.0f ? 20.0f * log10f (val) : FT_CURVE_DB_FLOOR;
+			if (val < FT_CURVE_DB_FLOOR) val = FT_CURVE_DB_FLOOR;
+		}
+		
+		fprintf (out, format, k * binhz, val);
+	}
+
+	if (fclose (out) != 0) {
+		fprintf (stderr, "Error writing %s: %s\n", path.c_str(), strerror(errno));
+		return false;
+	}
+
+	return true;
+}
+
+bool FTcurveFile::importFilter (const string & path, FTspectrumModifier * specmod, float samplerate)
+{
+	int length = specmod->getLength();
+	vector<float> curve (length);
+
+	if (!read (path, &curve[0], length, samplerate * 0.5f, isGainType (specmod))) {
+		return false;
+	}
+
+	float min, max;
+	specmod->getRange (min, max);
+	
+	// goes over to the audio thread in one piece, like a drawn edit
+	float * values = specmod->beginEdit();
+	for (int k=0; k < length; ++k) {
+		values[k] = curve[k] < min ? min : (curve[k] > max ? max : curve[k]);
+	}
+	specmod->commitEdit();
+
+	return true;
+}
+
+bool FTcurveFile::exportFilter (const string & path, FTspectrumModifier * specmod, float samplerate)
+{
+	return write (path, specmod->getLatestValues(), specmod->getLength(), samplerate * 0.5f,
+		      isGainType (specmod), specmod->getName());
+}
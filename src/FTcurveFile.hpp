@@ -0,0 +1,55 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#ifndef __FTCURVEFILE_HPP__
+#define __FTCURVEFILE_HPP__
+
+#include <string>
+using namespace std;
+
+class FTspectrumModifier;
+
+// Frequency response curves in the text formats measurement tools
+// write: a point per line, the frequency in Hz and then a value,
+// separated by commas, semicolons, tabs or spaces (CSV, REW and most
+// others).  Lines not starting with a number are skipped, as are
+// columns after the second (phase).  Files are read a line at a time,
+// so the number of points doesn't matter
+class FTcurveFile
+{
+  public:
+
+	// resamples path onto length bins spanning 0 to nyquist Hz,
+	// interpolating on a log frequency scale and averaging where
+	// several points land in a bin.  With lineargain the values are
+	// in dB and come out as linear gain.  false if it has no points
+	static bool read (const string & path, float * values, int length, float nyquist, bool lineargain);
+
+	// a point per bin, as csv if path ends in .csv, tab separated
+	// otherwise.  With lineargain the values are written in dB
+	static bool write (const string & path, const float * values, int length, float nyquist,
+			   bool lineargain, const string & name);
+
+	// the same for a filter, in dB for gain filters and clamped to
+	// its range
+	static bool importFilter (const string & path, FTspectrumModifier * specmod, float samplerate);
+	static bool exportFilter (const string & path, FTspectrumModifier * specmod, float samplerate);
+};
+
+#endif
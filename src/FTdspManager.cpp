@@ -54,6 +54,9 @@ FTdspManager::FTdspManager()
 	procmod = new FTprocDelay (samprate, fftn);
  	_prototypes.push_back (procmod);
 
+	procmod = new FTprocDelay (samprate, fftn, FTprocDelay::DELAY_INTERPOLATED);
+ 	_prototypes.push_back (procmod);
+
 	procmod = new FTprocLimit (samprate, fftn);
  	_prototypes.push_back (procmod);
 
@@ -26,7 +26,11 @@
 using namespace std;
 
 #include "FTioSupport.hpp"
+#include "FTofflineSupport.hpp"
+// the preset tools are built without jack
+#ifndef FT_NO_JACK
 #include "FTjackSupport.hpp"
+#endif
 
 FTioSupport * FTioSupport::_instance = 0;
 
@@ -38,9 +42,14 @@ FTioSupport * FTioSupport::createInstance()
 {
 	// static method
 
+#ifndef FT_NO_JACK
 	if (_iotype == IO_JACK) {
 		return new FTjackSupport(_defaultName.c_str(), _defaultServ.c_str());
 	}
+#endif
+	if (_iotype == IO_OFFLINE) {
+		return new FTofflineSupport();
+	}
 	else {
 		return 0;
 	}
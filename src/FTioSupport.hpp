@@ -87,6 +87,8 @@ class FTioSupport
 	enum IOtype
 	{
 		IO_JACK,
+		// no audio at all, for the preset tools
+		IO_OFFLINE
 	};
 
 	// set io type for this session
@@ -40,7 +40,7 @@ using namespace std;
 
 
 FTjackSupport::FTjackSupport(const char * name, const char * dir)
-	:  _inited(false), _jackClient(0), _activePathCount(0), _activated(false), _bypassed(false)
+	:  _inited(false), _jackClient(0), _sampleRate(44100), _activePathCount(0), _activated(false), _bypassed(false)
 {
 	// init process path info
 	for (int i=0; i < FT_MAXPATHS; i++) {
@@ -621,6 +621,9 @@ int FTjackSupport::processCallback (jack_nframes_t nframes, void *arg)
 	FTjackSupport * jsup = (FTjackSupport *) FTioSupport::instance();
 	PathInfo * tmppath;
 
+	// staged chains switch on the same cycle in every path
+	FTspectralEngine::latchStaged();
+	
 	// do processing for each path
 	for (int i=0; i < FT_MAXPATHS; i++)
 	{
@@ -40,6 +40,7 @@
 #include <math.h>
 #include <stdint.h>
 #include <string>
+#include <algorithm>
 using namespace std;
 
 #include "FTmainwin.hpp"
@@ -55,6 +56,7 @@ using namespace std;
 #include "FTupdateToken.hpp"
 #include "FTprocOrderDialog.hpp"
 #include "FTpresetBlendDialog.hpp"
+#include "FTpresetBrowser.hpp"
 #include "FTmodulatorDialog.hpp"
 #include "FThelpWindow.hpp"
 
@@ -73,6 +75,8 @@ using namespace JLCui;
 
 #include "pixmap_includes.hpp"
 
+// how many presets after the current one are kept ready to recall
+#define FT_STAGED_PRESETS 2
 
 // ----------------------------------------------------------------------------
 // event tables and other macros for wxWindows
@@ -86,6 +90,7 @@ enum WindowIds
 	FT_AboutMenu,
 	FT_ProcModMenu,
 	FT_PresetBlendMenu,
+	FT_PresetBrowserMenu,
 	FT_ModulatorMenu,
 	FT_HelpTipsMenu,
 	FT_InputButtonId,
@@ -155,6 +160,7 @@ BEGIN_EVENT_TABLE(FTmainwin, wxFrame)
 	EVT_MENU(FT_HelpTipsMenu, FTmainwin::OnAbout)
 	EVT_MENU(FT_ProcModMenu, FTmainwin::OnProcMod)
 	EVT_MENU(FT_PresetBlendMenu, FTmainwin::OnPresetBlend)
+	EVT_MENU(FT_PresetBrowserMenu, FTmainwin::OnPresetBrowser)
 	EVT_MENU(FT_ModulatorMenu, FTmainwin::OnModulatorDialog)
 
 	
@@ -196,6 +202,7 @@ BEGIN_EVENT_TABLE(FTmainwin, wxFrame)
 
 	EVT_BUTTON(FT_StoreButton, FTmainwin::handleStoreButton)
 	EVT_BUTTON(FT_LoadButton, FTmainwin::handleLoadButton)
+	EVT_COMBOBOX(FT_PresetCombo, FTmainwin::handlePresetCombo)
 
 	EVT_CHECKBOX(FT_MixLinkedButton, FTmainwin::handleLinkButtons)
 	EVT_BUTTON(FT_IOreconnectButton, FTmainwin::handleIOButtons)
@@ -224,7 +231,7 @@ FTmainwin::FTmainwin(int startpath, const wxString& title, const wxString& rcdir
 	  _updateMS(10), _superSmooth(false), _refreshMS(200),
 	  _pathCount(startpath),
 	  _configManager(static_cast<const char *> (rcdir.fn_str())),
-	  _procmodDialog(0), _blendDialog(0), _modulatorDialog(0),
+	  _procmodDialog(0), _blendDialog(0), _modulatorDialog(0), _presetBrowser(0),
 	  _titleFont(10, wxDEFAULT, wxNORMAL, wxBOLD),
 	  _titleAltFont(10, wxDEFAULT, wxSLANT, wxBOLD),
 	  _buttFont(10, wxDEFAULT, wxNORMAL, wxNORMAL)
@@ -282,6 +289,7 @@ void FTmainwin::buildGui()
 	menuFile->Append(FT_ProcModMenu, wxT("&DSP Modules...\tCtrl-P"), wxT("Configure DSP modules"));
 	menuFile->Append(FT_ModulatorMenu, wxT("&Modulators...\tCtrl-M"), wxT("Configure Modulations"));
 	menuFile->Append(FT_PresetBlendMenu, wxT("Preset &Blend...\tCtrl-B"), wxT("Blend multiple presets"));
+	menuFile->Append(FT_PresetBrowserMenu, wxT("Preset B&rowser...\tCtrl-R"), wxT("Search, preview and tag presets"));
 
 	menuFile->AppendSeparator();	
 	menuFile->Append(FT_QuitMenu, wxT("&Quit\tCtrl-Q"), wxT("Quit this program"));
@@ -3023,6 +3031,9 @@ void FTmainwin::changePathCount (int newcnt, bool rebuild, bool ignorelink)
 {
 	FTioSupport *iosup = FTioSupport::instance();
 
+	// a recall waiting to finish needs the paths it was made for
+	_configManager.finishRecall (true);
+
 	// change path count
 	if (newcnt < _pathCount)
 	{
@@ -3209,6 +3220,17 @@ void FTmainwin::OnProcMod (wxCommandEvent &event)
 	
 }
 
+void FTmainwin::OnPresetBrowser (wxCommandEvent &event)
+{
+	if (!_presetBrowser) {
+		_presetBrowser = new FTpresetBrowser(this, -1, wxT("Preset Browser"));
+	}
+
+	_presetBrowser->refreshState();
+
+	_presetBrowser->Show(true);
+}
+
 void FTmainwin::OnPresetBlend (wxCommandEvent &event)
 {
 	// popup our preset blend dialog
@@ -3282,6 +3304,7 @@ void FTmainwin::cleanup ()
 {
 	// save default preset
 	_configManager.storeSettings ("", true);
+	_configManager.waitForSaves();
 	
 	//printf ("cleaning up\n");
 	FTioSupport::instance()->close();
@@ -3307,6 +3330,54 @@ void FTmainwin::checkEvents()
 
 void FTmainwin::checkRefreshes()
 {
+	// a staged recall the engines have swapped to
+	if (_configManager.finishRecall()) {
+		presetLoaded (_recallName);
+		_recallName = wxT("");
+	}
+	
+	// chains replaced by a staged recall
+	_configManager.reclaimStaged();
+
+	// stores the writer finished
+	list<string> stored, failed;
+	_configManager.takeStored (stored, failed);
+	
+	for (list<string>::iterator name = stored.begin(); name != stored.end(); ++name) {
+		if (!name->empty()) {
+			SetStatusText (wxT("Stored ") + wxString::FromAscii (name->c_str()), 0);
+		}
+	}
+	for (list<string>::iterator name = failed.begin(); name != failed.end(); ++name) {
+		SetStatusText (wxT("Failed to store ")
+			       + (name->empty() ? wxString (wxT("the last setting")) : wxString::FromAscii (name->c_str())), 0);
+	}
+
+	// stores the audio thread replaced, and buffers for its writes
+	for (int i=0; i < _pathCount; i++)
+	{
+		if (!_processPath[i]) continue;
+
+		vector<FTprocI *> procmods;
+		_processPath[i]->getSpectralEngine()->getProcessorModules (procmods);
+
+		for (unsigned int n=0; n < procmods.size(); ++n)
+		{
+			vector<FTspectrumModifier *> filts;
+			procmods[n]->getFilters (filts);
+
+			for (unsigned int m=0; m < filts.size(); ++m) {
+				filts[m]->reclaim();
+			}
+		}
+	}
+
+	// so a crash loses at most FT_AUTOSAVE_INTERVAL
+	if (_configManager.autosaveDue()) {
+		updateAllExtra();
+		_configManager.autosave();
+	}
+	
 	// TODO smartness
 	updateGraphs(0, ALL_SPECMOD, true);
 }
@@ -3416,7 +3487,13 @@ void FTmainwin::handleStoreButton (wxCommandEvent &event)
 
 	DEBUGOUT ("store button pressed" << std::endl);
 	
-	_configManager.storeSettings (std::string (_presetCombo->GetValue().mb_str()));
+	if (_configManager.storeSettings (std::string (_presetCombo->GetValue().mb_str()))) {
+		// checkRefreshes() says once it is written
+		SetStatusText (wxT("Storing ") + _presetCombo->GetValue(), 0);
+	}
+	else {
+		SetStatusText (wxT("Failed to store ") + _presetCombo->GetValue(), 0);
+	}
 
 	if (_blendDialog && _blendDialog->IsShown()) {
 		_blendDialog->refreshState();
@@ -3434,36 +3511,107 @@ void FTmainwin::handleLoadButton (wxCommandEvent &event)
 }
 
 
-void FTmainwin::loadPreset (const wxString &name, bool uselast)
+void FTmainwin::handlePresetCombo (wxCommandEvent &event)
 {
-	suspendProcessing();
+	// a summary from the preset index, without loading it
+	const FTpresetIndex::Entry * info = _configManager.getSettingsInfo (std::string (_presetCombo->GetValue().mb_str()));
+
+	if (!info) {
+		SetStatusText(wxT("FreqTweak"), 0);
+		return;
+	}
+
+	wxString summary = wxString::Format (wxT("%d ch, %d bins:"), info->channels, info->fft_size / 2);
+
+	for (unsigned int n=0; n < info->chain.size(); ++n) {
+		summary += wxT(" ") + wxString::FromAscii (info->chain[n].c_str());
+	}
+
+	for (unsigned int n=0; n < info->tags.size(); ++n) {
+		summary += (n ? wxT(", ") : wxT("  [")) + wxString::FromAscii (info->tags[n].c_str());
+	}
+	if (!info->tags.empty()) {
+		summary += wxT("]");
+	}
 	
-	bool success = _configManager.loadSettings (std::string (name.mb_str()), _restorePortsCheck->GetValue(), uselast);
+	SetStatusText(summary, 0);
+}
+
+void FTmainwin::loadPreset (const wxString &name, bool uselast)
+{
+	std::string sname (name.mb_str());
+	bool restoreports = _restorePortsCheck->GetValue();
 
+	// a staged preset is swapped in without stopping, it has no ports
+	bool staged = !uselast && !restoreports && _configManager.recallStaged (sname);
+	bool success = staged;
+	
+	if (!staged) {
+		suspendProcessing();
+		success = _configManager.loadSettings (sname, restoreports, uselast);
+	}
+	
 	if (success) {
 		_presetCombo->SetValue(name);
 		rebuildPresetCombo();
+	}
 
+	if (staged) {
+		// rebuilt once the engines swapped, see checkRefreshes()
+		_recallName = name;
+	}
+	else {
+		_recallName = wxT("");
+		
+		if (success) {
+			presetLoaded (name);
+		}
+		
+		restoreProcessing();
+	}
 
-		// this rebuilds
-		changePathCount ( FTioSupport::instance()->getActivePathCount() , true, true);
+	if (success) {
+		stageNextPresets (uselast ? wxString() : name);
+	}
+}
 
-		if (_procmodDialog && _procmodDialog->IsShown()) {
-			_procmodDialog->refreshState();
-		}
+void FTmainwin::presetLoaded (const wxString &name)
+{
+	// this rebuilds
+	changePathCount ( FTioSupport::instance()->getActivePathCount() , true, true);
 
-		if (_modulatorDialog && _modulatorDialog->IsShown()) {
-			// _modulatorDialog->refreshState();
-		}
-		
-		if (_blendDialog && _blendDialog->IsShown()) {
-			_blendDialog->refreshState(name, true, wxT(""), true);
-		}
+	if (_procmodDialog && _procmodDialog->IsShown()) {
+		_procmodDialog->refreshState();
+	}
+
+	if (_modulatorDialog && _modulatorDialog->IsShown()) {
+		// _modulatorDialog->refreshState();
+	}
 		
+	if (_blendDialog && _blendDialog->IsShown()) {
+		_blendDialog->refreshState(name, true, wxT(""), true);
 	}
+}
+
+void FTmainwin::stageNextPresets (const wxString &name)
+{
+	// the ones after name in the preset list are the likely next ones
+	list<string> namelist = _configManager.getSettingsNames();
 	
-	restoreProcessing();
-	
+	std::string sname (name.mb_str());
+	list<string>::iterator iter = namelist.begin();
+
+	if (!sname.empty()) {
+		iter = find (namelist.begin(), namelist.end(), sname);
+		if (iter != namelist.end()) ++iter;
+	}
+
+	list<string> next;
+	for (; iter != namelist.end() && (int) next.size() < FT_STAGED_PRESETS; ++iter) {
+		next.push_back (*iter);
+	}
+
+	_configManager.stageSettings (next);
 }
 
 
@@ -3484,6 +3632,10 @@ void FTmainwin::rebuildPresetCombo()
 	if ( _presetCombo->FindString(selected) >= 0) {
 		_presetCombo->SetValue(selected);
 	}
+
+	if (_presetBrowser && _presetBrowser->IsShown()) {
+		_presetBrowser->refreshState();
+	}
 }
 
 void FTmainwin::suspendProcessing()
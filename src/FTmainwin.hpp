@@ -51,6 +51,7 @@ class FTrefreshTimer;
 class FTlinkMenu;
 class FTprocOrderDialog;
 class FTpresetBlendDialog;
+class FTpresetBrowser;
 class FTmodulatorDialog;
 
 namespace JLCui {
@@ -136,6 +137,10 @@ class FTmainwin : public wxFrame, public SigC::Object
 	void updatePosition(const wxString &freqstr, const wxString &valstr); 
 
 	void loadPreset (const wxString & name, bool uselast=false);
+	// rebuilds for the preset just loaded
+	void presetLoaded (const wxString & name);
+	// builds the presets after name ahead of time, for loadPreset()
+	void stageNextPresets (const wxString & name);
 
 	void cleanup ();
 
@@ -192,11 +197,13 @@ class FTmainwin : public wxFrame, public SigC::Object
 
 	void handleStoreButton (wxCommandEvent &event);
 	void handleLoadButton (wxCommandEvent &event);
+	void handlePresetCombo (wxCommandEvent &event);
 
 	void handleIOButtons (wxCommandEvent &event);
 
 	void OnProcMod (wxCommandEvent &event);
 	void OnPresetBlend (wxCommandEvent &event);
+	void OnPresetBrowser (wxCommandEvent &event);
 	void OnModulatorDialog (wxCommandEvent &event);
 
 	void handleTitleMenuCmd (FTtitleMenuEvent & ev);
@@ -433,6 +440,8 @@ class FTmainwin : public wxFrame, public SigC::Object
 	int _rowCount;
 
 	FTconfigManager _configManager;
+	// staged recall waiting on the engines, see checkRefreshes()
+	wxString _recallName;
 
 	wxComboBox * _presetCombo;
 	wxChoice * _plotSpeedChoice;
@@ -452,6 +461,7 @@ class FTmainwin : public wxFrame, public SigC::Object
 	FTprocOrderDialog * _procmodDialog;
 	FTpresetBlendDialog * _blendDialog;
 	FTmodulatorDialog *   _modulatorDialog;
+	FTpresetBrowser * _presetBrowser;
 	
 	int _bwidth;
 	int _labwidth;
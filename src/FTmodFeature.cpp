@@ -0,0 +1,226 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#include "FTmodFeature.hpp"
+#include "FTspectralFeatures.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace std;
+using namespace PBD;
+
+// band energy below this many dB is 0
+#define FT_FEATURE_FLOOR_DB -80.0f
+// centroids are scaled on a log axis from here up to nyquist
+#define FT_FEATURE_LOW_HZ 20.0f
+
+
+FTmodFeature::FTmodFeature (nframes_t samplerate, unsigned int fftn)
+	: FTmodulatorI ("FeatureFollow", "Feature Follow", samplerate, fftn)
+{
+}
+
+FTmodFeature::FTmodFeature (const FTmodFeature & other)
+	: FTmodulatorI ("FeatureFollow", "Feature Follow", other._sampleRate, other._fftN)
+{
+}
+
+void FTmodFeature::initialize()
+{
+	_envelope = 0.0f;
+	
+	_feature = new Control (Control::EnumType, "feature", "Feature", "");
+	_feature->_enumList.push_back("Band Energy");
+	_feature->_enumList.push_back("Centroid");
+	_feature->_enumList.push_back("Flux");
+	_feature->_enumList.push_back("Onset");
+	_feature->setValue (string("Band Energy"));
+	_controls.push_back (_feature);
+
+	_bandmin = new Control (Control::FloatType, "band_min", "Band Min", "Hz");
+	_bandmin->_floatLB = 0.0;
+	_bandmin->_floatUB = _sampleRate / 2;
+	_bandmin->setValue (_bandmin->_floatLB);
+	_controls.push_back (_bandmin);
+
+	_bandmax = new Control (Control::FloatType, "band_max", "Band Max", "Hz");
+	_bandmax->_floatLB = 0.0;
+	_bandmax->_floatUB = _sampleRate / 2;
+	_bandmax->setValue (_bandmax->_floatUB);
+	_controls.push_back (_bandmax);
+
+	_attack = new Control (Control::FloatType, "attack", "Attack", "ms");
+	_attack->_floatLB = 0.0;
+	_attack->_floatUB = 1000.0;
+	_attack->setValue (10.0f);
+	_controls.push_back (_attack);
+
+	_release = new Control (Control::FloatType, "release", "Release", "ms");
+	_release->_floatLB = 0.0;
+	_release->_floatUB = 5000.0;
+	_release->setValue (200.0f);
+	_controls.push_back (_release);
+
+	_depth = new Control (Control::FloatType, "depth", "Depth", "%");
+	_depth->_floatLB = -100.0;
+	_depth->_floatUB = 100.0;
+	_depth->setValue (0.0f);
+	_controls.push_back (_depth);
+
+	_minfreq = new Control (Control::FloatType, "min_freq", "Min Freq", "Hz");
+	_minfreq->_floatLB = 0.0;
+	_minfreq->_floatUB = _sampleRate / 2;
+	_minfreq->setValue (_minfreq->_floatLB);
+	_controls.push_back (_minfreq);
+
+	_maxfreq = new Control (Control::FloatType, "max_freq", "Max Freq", "Hz");
+	_maxfreq->_floatLB = 0.0;
+	_maxfreq->_floatUB = _sampleRate / 2;
+	_maxfreq->setValue (_maxfreq->_floatUB);
+	_controls.push_back (_maxfreq);
+	
+	attachControls();
+	_snapshot.read (_params);
+	
+	_inited = true;
+}
+
+FTmodFeature::~FTmodFeature()
+{
+	if (!_inited) return;
+
+	_controls.clear();
+
+	delete _feature;
+	delete _bandmin;
+	delete _bandmax;
+	delete _attack;
+	delete _release;
+	delete _depth;
+	delete _minfreq;
+	delete _maxfreq;
+}
+
+
+void FTmodFeature::controlsChanged()
+{
+	Params params;
+
+	_bandmin->getValue (params.bandmin);
+	_bandmax->getValue (params.bandmax);
+	_attack->getValue (params.attack);
+	_release->getValue (params.release);
+	_depth->getValue (params.depth);
+	_minfreq->getValue (params.minfreq);
+	_maxfreq->getValue (params.maxfreq);
+
+	string feature;
+	_feature->getValue (feature);
+	if (feature == "Centroid") {
+		params.feature = FEATURE_CENTROID;
+	}
+	else if (feature == "Flux") {
+		params.feature = FEATURE_FLUX;
+	}
+	else if (feature == "Onset") {
+		params.feature = FEATURE_ONSET;
+	}
+	else {
+		params.feature = FEATURE_BAND_ENERGY;
+	}
+	
+	_snapshot.publish (params);
+}
+
+float FTmodFeature::featureValue()
+{
+	float val;
+	
+	switch (_params.feature) {
+	case FEATURE_CENTROID:
+		val = _features->getCentroid();
+		if (val <= FT_FEATURE_LOW_HZ) return 0.0f;
+		val = logf (val / FT_FEATURE_LOW_HZ) / logf (_sampleRate * 0.5f / FT_FEATURE_LOW_HZ);
+		break;
+	case FEATURE_FLUX:
+		val = _features->getFlux();
+		break;
+	case FEATURE_ONSET:
+		val = _features->getOnset();
+		break;
+	default:
+		val = _features->getBandEnergy (_params.bandmin, _params.bandmax);
+		if (val <= 0.0f) return 0.0f;
+		val = 1.0f - (10.0f * log10f (val)) / FT_FEATURE_FLOOR_DB;
+		break;
+	}
+
+	if (val < 0.0f) return 0.0f;
+	if (val > 1.0f) return 1.0f;
+	return val;
+}
+
+void FTmodFeature::modulate (nframes_t current_frame, fft_data * fftdata, unsigned int fftn, sample_t * timedata, nframes_t nframes)
+{
+	if (!_inited || _bypassed || !_features) return;
+
+	// pick up any control changes
+	_snapshot.read (_params);
+
+	float tmplb, tmpub;
+	int len;
+	unsigned int minbin, maxbin;
+	float offset;
+	
+	if (_params.minfreq >= _params.maxfreq) {
+		return;
+	}
+
+	// follow the feature
+	float target = featureValue();
+	float ms = (target > _envelope) ? _params.attack : _params.release;
+
+	if (ms > 0.0f) {
+		_envelope += (target - _envelope) * (1.0f - expf (-_features->getHopTime() * 1000.0f / ms));
+	}
+	else {
+		_envelope = target;
+	}
+	
+	TargetArray * tarray = beginTargets();
+	
+	for (unsigned int n = 0; n < tarray->count; ++n)
+	{
+		FTspectrumModifier * sm = tarray->targets[n].specmod;
+		if (sm->getBypassed()) continue;
+
+		sm->getRange(tmplb, tmpub);
+
+		len = (int) sm->getLength();
+		minbin = (int) ((_params.minfreq*2/ _sampleRate) * len);
+		maxbin = (int) ((_params.maxfreq*2/ _sampleRate) * len);
+
+		// the filter adds it on top of its values
+		offset = _envelope * (tmpub - tmplb) * (_params.depth * 0.01f) * tarray->targets[n].depth;
+		sm->setRoute (this, minbin, maxbin, offset);
+	}
+
+	endTargets();
+}
@@ -0,0 +1,88 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#ifndef __FTMODFEATURE_HPP__
+#define __FTMODFEATURE_HPP__
+
+#include "FTmodulatorI.hpp"
+
+#include <vector>
+
+// Shifts the target values by an envelope following one of the input
+// spectrum features (band energy, centroid, flux or onset)
+class FTmodFeature
+	: public FTmodulatorI
+{
+  public:
+
+	FTmodFeature(nframes_t samplerate, unsigned int fftn);
+	FTmodFeature (const FTmodFeature & other);
+
+	virtual ~FTmodFeature();
+
+	FTmodulatorI * clone() { return new FTmodFeature(*this); }
+	void initialize();
+	
+	void modulate (nframes_t current_frame, fft_data * fftdata, unsigned int fftn, sample_t * timedata, nframes_t nframes);
+
+	bool usesFeatures() { return _inited && !_bypassed; }
+
+	enum Feature {
+		FEATURE_BAND_ENERGY = 0,
+		FEATURE_CENTROID,
+		FEATURE_FLUX,
+		FEATURE_ONSET
+	};
+	
+  protected:
+
+	void controlsChanged();
+
+	// the feature scaled to 0..1
+	float featureValue();
+	
+	Control * _feature;
+	Control * _bandmin;
+	Control * _bandmax;
+	Control * _attack;
+	Control * _release;
+	Control * _depth;
+	Control * _minfreq;
+	Control * _maxfreq;
+	
+	// compiled from the controls
+	struct Params {
+		Feature feature;
+		float bandmin;
+		float bandmax;
+		float attack;
+		float release;
+		float depth;
+		float minfreq;
+		float maxfreq;
+	};
+
+	Snapshot<Params> _snapshot;
+	Params _params;
+
+	float _envelope;
+	
+};
+
+#endif
@@ -0,0 +1,172 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#include "FTmodMorph.hpp"
+#include "FTmorphSpace.hpp"
+
+#include <cmath>
+
+using namespace std;
+using namespace PBD;
+
+FTmodMorph::FTmodMorph (nframes_t samplerate, unsigned int fftn)
+	: FTmodulatorI ("PresetMorph", "Preset Morph", samplerate, fftn)
+{
+}
+
+FTmodMorph::FTmodMorph (const FTmodMorph & other)
+	: FTmodulatorI ("PresetMorph", "Preset Morph", other._sampleRate, other._fftN)
+{
+}
+
+void FTmodMorph::initialize()
+{
+	_lastx = -1.0f;
+	_lasty = -1.0f;
+	_lastspace = 0;
+	_lasttargets = 0;
+	_blended = false;
+	
+	_xpos = new Control (Control::FloatType, "x", "X", "");
+	_xpos->_floatLB = 0.0;
+	_xpos->_floatUB = 1.0;
+	_xpos->setValue (0.0f);
+	_controls.push_back (_xpos);
+
+	_ypos = new Control (Control::FloatType, "y", "Y", "");
+	_ypos->_floatLB = 0.0;
+	_ypos->_floatUB = 1.0;
+	_ypos->setValue (0.0f);
+	_controls.push_back (_ypos);
+
+	_radius = new Control (Control::FloatType, "radius", "Radius", "");
+	_radius->_floatLB = 0.0;
+	_radius->_floatUB = 0.5;
+	_radius->setValue (0.0f);
+	_controls.push_back (_radius);
+
+	_rate = new Control (Control::FloatType, "rate", "Rate", "Hz");
+	_rate->_floatLB = 0.0;
+	_rate->_floatUB = 20.0;
+	_rate->setValue (0.0f);
+	_controls.push_back (_rate);
+	
+	attachControls();
+	_snapshot.read (_params);
+	
+	_inited = true;
+}
+
+FTmodMorph::~FTmodMorph()
+{
+	if (!_inited) return;
+
+	_controls.clear();
+
+	delete _xpos;
+	delete _ypos;
+	delete _radius;
+	delete _rate;
+}
+
+
+void FTmodMorph::controlsChanged()
+{
+	Params params;
+
+	_xpos->getValue (params.x);
+	_ypos->getValue (params.y);
+	_radius->getValue (params.radius);
+	_rate->getValue (params.rate);
+
+	_snapshot.publish (params);
+}
+
+float FTmodMorph::getUpdateRate()
+{
+	_snapshot.read (_params);
+
+	if (_params.rate == 0.0f || _params.radius == 0.0f) {
+		// only following the controls and the gui
+		return 30.0f;
+	}
+	
+	float rate = _params.rate * 32.0f;
+	return rate > 30.0f ? rate : 30.0f;
+}
+
+void FTmodMorph::modulate (nframes_t current_frame, fft_data * fftdata, unsigned int fftn, sample_t * timedata, nframes_t nframes)
+{
+	if (!_inited || _bypassed) return;
+
+	// pick up any control changes
+	_snapshot.read (_params);
+
+	float x = _params.x;
+	float y = _params.y;
+
+	if (_params.rate > 0.0f && _params.radius > 0.0f) {
+		double phase = 2.0 * M_PI * fmod (current_frame * (double) _params.rate / _sampleRate, 1.0);
+		x += _params.radius * (float) cos (phase);
+		y += _params.radius * (float) sin (phase);
+	}
+
+	unsigned int spacever, targetsver;
+	const FTmorphSpace * space = FTmorphSpace::acquire (&spacever);
+	TargetArray * tarray = beginTargets (&targetsver);
+
+	bool missed = false;
+	
+	if (space && (!_blended || spacever != _lastspace || targetsver != _lasttargets
+		      || x != _lastx || y != _lasty))
+	{
+		float weights[FT_MAX_MORPH_PRESETS];
+		space->computeWeights (x, y, weights);
+		
+		for (unsigned int n = 0; n < tarray->count; ++n)
+		{
+			FTspectrumModifier * sm = tarray->targets[n].specmod;
+			if (sm->getBypassed()) continue;
+
+			int filt = space->findFilter (sm);
+			if (filt < 0) continue;
+
+			// only if it lost its stores to sharing, and
+			// the gui hasn't topped it up yet
+			float * values = sm->beginWrite();
+			if (!values) {
+				missed = true;
+				continue;
+			}
+			
+			space->blend (filt, weights, values, sm->getLength());
+			sm->endWrite();
+		}
+	}
+
+	// try the ones we missed again next hop
+	_blended = space && !missed;
+	_lastspace = spacever;
+	_lasttargets = targetsver;
+	_lastx = x;
+	_lasty = y;
+	
+	endTargets();
+	FTmorphSpace::release();
+}
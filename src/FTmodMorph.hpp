@@ -0,0 +1,75 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#ifndef __FTMODMORPH_HPP__
+#define __FTMODMORPH_HPP__
+
+#include "FTmodulatorI.hpp"
+
+class FTmorphSpace;
+
+// Moves its filters around the Preset Blend morph (see FTmorphSpace),
+// circling the X, Y spot by Radius at Rate
+class FTmodMorph
+	: public FTmodulatorI
+{
+  public:
+
+	FTmodMorph(nframes_t samplerate, unsigned int fftn);
+	FTmodMorph (const FTmodMorph & other);
+
+	virtual ~FTmodMorph();
+
+	FTmodulatorI * clone() { return new FTmodMorph(*this); }
+	void initialize();
+	
+	void modulate (nframes_t current_frame, fft_data * fftdata, unsigned int fftn, sample_t * timedata, nframes_t nframes);
+
+	float getUpdateRate();
+
+  protected:
+
+	void controlsChanged();
+
+	Control * _xpos;
+	Control * _ypos;
+	Control * _radius;
+	Control * _rate;
+	
+	// compiled from the controls
+	struct Params {
+		float x;
+		float y;
+		float radius;
+		float rate;
+	};
+
+	Snapshot<Params> _snapshot;
+	Params _params;
+
+	// what was last blended, to skip it when nothing moved
+	float _lastx;
+	float _lasty;
+	// versions, not the pointers, those can be reused
+	unsigned int _lastspace;
+	unsigned int _lasttargets;
+	bool _blended;
+};
+
+#endif
@@ -18,6 +18,7 @@
 */
 
 #include "FTmodRandomize.hpp"
+#include "FTutils.hpp"
 #include <cstdlib>
 #include <cstdio>
 #include <iostream>
@@ -69,9 +70,31 @@ void FTmodRandomize::initialize()
 	_maxfreq->setValue (_maxfreq->_floatUB);
 	_controls.push_back (_maxfreq);
 
+	_mode = new Control (Control::EnumType, "mode", "Mode", "");
+	_mode->_enumList.push_back("Uniform");
+	_mode->_enumList.push_back("Walk");
+	_mode->_enumList.push_back("Smooth");
+	_mode->setValue (string("Uniform"));
+	_controls.push_back (_mode);
+
+	_width = new Control (Control::FloatType, "width", "Width", "Hz");
+	_width->_floatLB = 0.0;
+	_width->_floatUB = _sampleRate / 2;
+	_width->setValue (1000.0f);
+	_controls.push_back (_width);
+
+	_seed = new Control (Control::IntegerType, "seed", "Seed", "");
+	_seed->_intLB = 0;
+	_seed->_intUB = 99999;
+	_seed->setValue (0);
+	_controls.push_back (_seed);
 	
-	
-	srand(0);
+	_events = 0;
+	_lastseed = 0;
+	_knots = new float[FT_MAX_FFT_SIZE_HALF + 2];
+
+	attachControls();
+	_snapshot.read (_params);
 	
 	_inited = true;
 }
@@ -87,21 +110,108 @@ FTmodRandomize::~FTmodRandomize()
 	delete _maxfreq;
 	delete _minval;
 	delete _maxval;
+	delete _mode;
+	delete _width;
+	delete _seed;
+
+	delete [] _knots;
 	
 }
 
+void FTmodRandomize::controlsChanged()
+{
+	Params params;
+
+	_rate->getValue (params.rate);
+	_minval->getValue (params.minval);
+	_maxval->getValue (params.maxval);
+	_minfreq->getValue (params.minfreq);
+	_maxfreq->getValue (params.maxfreq);
+	_width->getValue (params.width);
+	_seed->getValue (params.seed);
+
+	string mode;
+	_mode->getValue (mode);
+	if (mode == "Walk") {
+		params.mode = MODE_WALK;
+	}
+	else if (mode == "Smooth") {
+		params.mode = MODE_SMOOTH;
+	}
+	else {
+		params.mode = MODE_UNIFORM;
+	}
+	
+	_snapshot.publish (params);
+}
+
+void FTmodRandomize::fill (float * filter, int count, uint32_t key, float lb, float ub, float widthbins)
+{
+	int i;
+	
+	if (widthbins < 1.0f) {
+		widthbins = 1.0f;
+	}
+	
+	if (_params.mode == MODE_WALK)
+	{
+		// steps first, then walk them bouncing off the bounds
+		float step = (ub - lb) / widthbins;
+		float val = lb + (ub - lb) * (FTutils::hash_random (key, count) >> 8) * (1.0f / 16777216.0f);
+		
+		FTutils::vector_random_fill (filter, count, key, 0, -step, step);
+
+		for (i=0; i < count; ++i) {
+			val += filter[i];
+			if (val > ub) val = 2*ub - val;
+			else if (val < lb) val = 2*lb - val;
+			filter[i] = val;
+		}
+	}
+	else if (_params.mode == MODE_SMOOTH)
+	{
+		// random knots widthbins apart joined with smoothstep
+		int nknots = (int) (count / widthbins) + 2;
+		float pos, frac;
+		int k;
+		
+		FTutils::vector_random_fill (_knots, nknots, key, 0, lb, ub);
+
+		for (i=0; i < count; ++i) {
+			pos = i / widthbins;
+			k = (int) pos;
+			frac = pos - k;
+			frac = frac * frac * (3.0f - 2.0f * frac);
+			filter[i] = _knots[k] + (_knots[k+1] - _knots[k]) * frac;
+		}
+	}
+	else {
+		FTutils::vector_random_fill (filter, count, key, 0, lb, ub);
+	}
+}
+
+float FTmodRandomize::getUpdateRate()
+{
+	_snapshot.read (_params);
+
+	// new values land within an eighth of their period
+	float rate = _params.rate * 8.0f;
+	return rate > FT_MOD_IDLE_RATE ? rate : FT_MOD_IDLE_RATE;
+}
+
 void FTmodRandomize::modulate (nframes_t current_frame, fft_data * fftdata, unsigned int fftn, sample_t * timedata, nframes_t nframes)
 {
-	TentativeLockMonitor lm (_specmodLock, __LINE__, __FILE__);
+	if (!_inited || _bypassed) return;
 
-	if (!lm.locked() || !_inited || _bypassed) return;
+	// pick up any control changes
+	_snapshot.read (_params);
 
 	float rate = 1.0;
 	float ub,lb, tmplb, tmpub;
 	float * filter;
 	unsigned int len;
 	
-	_rate->getValue (rate);
+	rate = _params.rate;
 
 	if (rate == 0.0)
 		return;
@@ -112,32 +222,44 @@ void FTmodRandomize::modulate (nframes_t current_frame, fft_data * fftdata, unsi
 	
 	double samps = _sampleRate / rate;
 
-	_minval->getValue (minval);
-	_maxval->getValue (maxval);
+	minval = _params.minval;
+	maxval = _params.maxval;
 
 	if (minval > maxval) {
 		minval = maxval;
 	}
 
-	_minfreq->getValue (minfreq);
-	_maxfreq->getValue (maxfreq);
+	minfreq = _params.minfreq;
+	maxfreq = _params.maxfreq;
 
 	if (minfreq >= maxfreq) {
 		return;
 	}
 
+	if (_params.seed != _lastseed) {
+		// start the sequence over
+		_lastseed = _params.seed;
+		_events = 0;
+	}
+	
 	double delta = current_frame - _lastframe;
 	
 	if (delta >= samps) 
 	{
+		uint32_t eventkey = FTutils::hash_random ((uint32_t) _params.seed, _events);
+		uint32_t n;
+		
+
 		// fprintf (stderr, "randomize at %lu :  samps=%g  s*c=%g  s*e=%g \n", (unsigned long) current_frame, samps, (current_frame/samps), ((current_frame + nframes)/samps) );
 		
-		for (SpecModList::iterator iter = _specMods.begin(); iter != _specMods.end(); ++iter)
+		TargetArray * tarray = beginTargets();
+		bool missed = false;
+		
+		for (n = 0; n < tarray->count; ++n)
 		{
-			FTspectrumModifier * sm = (*iter);
+			FTspectrumModifier * sm = tarray->targets[n].specmod;
 			if (sm->getBypassed()) continue;
 
-			filter = sm->getValues();
 			sm->getRange(tmplb, tmpub);
 			len = sm->getLength();
 
@@ -152,14 +274,30 @@ void FTmodRandomize::modulate (nframes_t current_frame, fft_data * fftdata, unsi
 			minbin = (int) ((minfreq*2/ _sampleRate) * len);
 			maxbin = (int) ((maxfreq*2/ _sampleRate) * len);
 			
-			// crap random
-			for (unsigned int i=minbin; i < maxbin; ++i) {
-				filter[i] = lb + (float) ((ub-lb) * rand() / (RAND_MAX+1.0));
+			if (maxbin <= minbin) {
+				continue;
 			}
 
-			sm->setDirty(true);
+			// only if it lost its stores to sharing, and
+			// the gui hasn't topped it up yet
+			if (!(filter = sm->beginWrite())) {
+				missed = true;
+				continue;
+			}
+			
+			fill (filter + minbin, maxbin - minbin, FTutils::hash_random (eventkey, n),
+			      lb, ub, _params.width * 2 * len / _sampleRate);
+
+			sm->endWrite();
 		}
 
+		endTargets();
+
+		// the same event again next hop, the values only depend
+		// on the key so the ones already written stay as they are
+		if (missed) return;
+		
 		_lastframe = current_frame;
+		++_events;
 	}
 }
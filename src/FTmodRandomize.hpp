@@ -22,6 +22,8 @@
 
 #include "FTmodulatorI.hpp"
 
+#include <stdint.h>
+
 class FTmodRandomize
 	: public FTmodulatorI
 {
@@ -37,17 +39,52 @@ class FTmodRandomize
 	
 	void modulate (nframes_t current_frame, fft_data * fftdata, unsigned int fftn, sample_t * timedata, nframes_t nframes);
 
+	float getUpdateRate();
+
+	enum Mode {
+		MODE_UNIFORM = 0,  // every bin independent
+		MODE_WALK,         // random walk from bin to bin
+		MODE_SMOOTH        // random points Width apart, smoothly joined
+	};
 	
   protected:
 
+	void controlsChanged();
+	void fill (float * filter, int count, uint32_t key, float lb, float ub, float widthbins);
+
 	Control * _rate;
 	Control * _minfreq;
 	Control * _maxfreq;
 	Control * _minval;
 	Control * _maxval;
+	Control * _mode;
+	Control * _width;
+	Control * _seed;
+
+	// compiled from the controls
+	struct Params {
+		float rate;
+		float minval;
+		float maxval;
+		float minfreq;
+		float maxfreq;
+		Mode mode;
+		float width;
+		int seed;
+	};
 
+	Snapshot<Params> _snapshot;
+	Params _params;
+	
 	nframes_t _lastframe;
 
+	// randomizations since the seed was set, the generator is keyed
+	// by seed and this count so a given seed always replays
+	uint32_t _events;
+	int _lastseed;
+
+	float * _knots;
+
 };
 
 #endif
@@ -19,6 +19,7 @@
 
 #include "FTmodRotate.hpp"
 #include <cstdlib>
+#include <cmath>
 #include <cstdio>
 #include <iostream>
 
@@ -64,8 +65,9 @@ void FTmodRotate::initialize()
 // 	_dimension->_enumList.push_back("Value");
 // 	_dimension->setValue ("Frequency");
 // 	_controls.push_back (_dimension);
-	
-	_tmpfilt = new float[_fftN];
+
+	attachControls();
+	_snapshot.read (_params);
 	
 	_inited = true;
 }
@@ -81,38 +83,45 @@ FTmodRotate::~FTmodRotate()
 	delete _maxfreq;
 }
 
-void FTmodRotate::setFFTsize (unsigned int fftn)
+void FTmodRotate::controlsChanged()
 {
-	_fftN = fftn;
+	Params params;
 
-	if (_inited) {
-		delete _tmpfilt;
-		_tmpfilt = new float[_fftN];
-	}
-	
+	_rate->getValue (params.rate);
+	_minfreq->getValue (params.minfreq);
+	_maxfreq->getValue (params.maxfreq);
+
+	_snapshot.publish (params);
 }
 
+float FTmodRotate::getUpdateRate()
+{
+	_snapshot.read (_params);
+
+	// about a bin per call
+	float binspersec = fabsf (_params.rate) * _fftN / _sampleRate;
+	return binspersec > FT_MOD_IDLE_RATE ? binspersec : FT_MOD_IDLE_RATE;
+}
 
 void FTmodRotate::modulate (nframes_t current_frame, fft_data * fftdata, unsigned int fftn, sample_t * timedata, nframes_t nframes)
 {
-	TentativeLockMonitor lm (_specmodLock, __LINE__, __FILE__);
+	if (!_inited || _bypassed) return;
 
-	if (!lm.locked() || !_inited || _bypassed) return;
+	// pick up any control changes
+	_snapshot.read (_params);
 
 	float rate = 1.0;
 	float ub,lb;
-	float * filter;
 	int len;
-	int i,j;
 	float minfreq, maxfreq;
 	int minbin, maxbin;
 	double hzperbin;
 	
 	// in hz/sec
-	_rate->getValue (rate);
+	rate = _params.rate;
 	
-	_minfreq->getValue (minfreq);
-	_maxfreq->getValue (maxfreq);
+	minfreq = _params.minfreq;
+	maxfreq = _params.maxfreq;
 
 	if (minfreq >= maxfreq) {
 		return;
@@ -131,9 +140,11 @@ void FTmodRotate::modulate (nframes_t current_frame, fft_data * fftdata, unsigne
 		// fprintf (stderr, "shift at %lu :  samps=%g  s*c=%g  s*e=%g \n", (unsigned long) current_frame, samps, (current_frame/samps), ((current_frame + nframes)/samps) );
 
 		
-		for (SpecModList::iterator iter = _specMods.begin(); iter != _specMods.end(); ++iter)
+		TargetArray * tarray = beginTargets();
+		
+		for (unsigned int n = 0; n < tarray->count; ++n)
 		{
-			FTspectrumModifier * sm = (*iter);
+			FTspectrumModifier * sm = tarray->targets[n].specmod;
 			if (sm->getBypassed()) continue;
 
 // 			cerr << "shiftval is: " << shiftval
@@ -141,7 +152,6 @@ void FTmodRotate::modulate (nframes_t current_frame, fft_data * fftdata, unsigne
 // 			     << " rate:   " << rate << endl;
 			
 			
-			filter = sm->getValues();
 			sm->getRange(lb, ub);
 			len = (int) sm->getLength();
 			minbin = (int) ((minfreq*2/ _sampleRate) * len);
@@ -159,44 +169,12 @@ void FTmodRotate::modulate (nframes_t current_frame, fft_data * fftdata, unsigne
 			
 			// fprintf(stderr, "shifting %d  %d:%d  at %lu\n", shiftbins, minbin, maxbin, (unsigned long) current_frame);
 			
-			if (shiftbins > 0) {
-				// shiftbins is POSITIVE, shift right
-				// store last shiftbins
-				for (i=maxbin-shiftbins; i < maxbin; i++) {
-					_tmpfilt[i] = filter[i];
-				}
-				
-				
-				for ( i=maxbin-1; i >= minbin + shiftbins; i--) {
-					filter[i] = filter[i-shiftbins];
-				}
-				
-				for (j=maxbin-shiftbins, i=minbin; i < minbin + shiftbins; i++, j++) {
-					filter[i] = _tmpfilt[j];
-				}
-			}
-			else if (shiftbins < 0) {
-				// shiftbins is NEGATIVE, shift left
-				// store last shiftbins
-
-				// store first shiftbins
-				for (i=minbin; i < minbin-shiftbins; i++) {
-					_tmpfilt[i] = filter[i];
-				}
-			
-				for (i=minbin; i < maxbin + shiftbins; i++) {
-					filter[i] = filter[i-shiftbins];
-				}
-
-				for (j=minbin, i=maxbin+shiftbins; i < maxbin; i++, j++) {
-					filter[i] = _tmpfilt[j];
-				}
-			}
-			
-			
-			sm->setDirty(true);
+			// just an offset, the filter keeps track of it
+			sm->rotate (minbin, maxbin, shiftbins);
 		}
 
+		endTargets();
+
 		_lastframe = current_frame;
 	}
 }
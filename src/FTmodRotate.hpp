@@ -37,17 +37,29 @@ class FTmodRotate
 	
 	void modulate (nframes_t current_frame, fft_data * fftdata, unsigned int fftn, sample_t * timedata, nframes_t nframes);
 
-	void setFFTsize (unsigned int fftn);
+	float getUpdateRate();
+
 	
 	
   protected:
 
+	void controlsChanged();
+
 	Control * _rate;
 	Control * _minfreq;
 	Control * _maxfreq;
 	
+	// compiled from the controls
+	struct Params {
+		float rate;
+		float minfreq;
+		float maxfreq;
+	};
+
+	Snapshot<Params> _snapshot;
+	Params _params;
+	
 	nframes_t _lastframe;
-	float * _tmpfilt;
 };
 
 #endif
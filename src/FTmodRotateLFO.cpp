@@ -21,6 +21,7 @@
 #include "FTutils.hpp"
 
 #include <cstdlib>
+#include <cmath>
 #include <cstdio>
 #include <iostream>
 
@@ -73,10 +74,8 @@ void FTmodRotateLFO::initialize()
 	_maxfreq->setValue (_maxfreq->_floatUB);
 	_controls.push_back (_maxfreq);
 
-	
-	
-	
-	_tmpfilt = new float[_fftN];
+	attachControls();
+	_snapshot.read (_params);
 	
 	_inited = true;
 }
@@ -94,46 +93,58 @@ FTmodRotateLFO::~FTmodRotateLFO()
 	delete _maxfreq;
 }
 
-void FTmodRotateLFO::setFFTsize (unsigned int fftn)
+void FTmodRotateLFO::controlsChanged()
 {
-	_fftN = fftn;
+	Params params;
 
-	if (_inited) {
-		delete _tmpfilt;
-		_tmpfilt = new float[_fftN];
-	}
-	
+	_rate->getValue (params.rate);
+	_depth->getValue (params.depth);
+	_minfreq->getValue (params.minfreq);
+	_maxfreq->getValue (params.maxfreq);
+
+	string shape;
+	_lfotype->getValue (shape);
+	params.shape = getLFOShape (shape);
+
+	_snapshot.publish (params);
 }
 
+float FTmodRotateLFO::getUpdateRate()
+{
+	_snapshot.read (_params);
+
+	// about a bin per call at the steepest part of the lfo
+	float binspersec = (float) M_PI * _params.rate * _params.depth * _fftN / _sampleRate;
+	return binspersec > FT_MOD_IDLE_RATE ? binspersec : FT_MOD_IDLE_RATE;
+}
 
 void FTmodRotateLFO::modulate (nframes_t current_frame, fft_data * fftdata, unsigned int fftn, sample_t * timedata, nframes_t nframes)
 {
-	TentativeLockMonitor lm (_specmodLock, __LINE__, __FILE__);
+	if (!_inited || _bypassed) return;
 
-	if (!lm.locked() || !_inited || _bypassed) return;
+	// pick up any control changes
+	_snapshot.read (_params);
 
 	float rate = 1.0;
 	double currdev = 0.0;
 	float ub,lb;
-	float * filter;
 	int len;
-	int i,j;
 	float minfreq, maxfreq;
 	float depth = 1.0;
 	int minbin, maxbin;
 	double hzperbin;
 	double current_secs;
-	string shape;
+	LFOShape shape;
 	
 	// in hz
-	_rate->getValue (rate);
-	_lfotype->getValue (shape);
+	rate = _params.rate;
+	shape = _params.shape;
 
 	// in hz
-	_depth->getValue (depth);
+	depth = _params.depth;
 	
-	_minfreq->getValue (minfreq);
-	_maxfreq->getValue (maxfreq);
+	minfreq = _params.minfreq;
+	maxfreq = _params.maxfreq;
 
 	if (minfreq >= maxfreq) {
 		return;
@@ -146,24 +157,12 @@ void FTmodRotateLFO::modulate (nframes_t current_frame, fft_data * fftdata, unsi
 
 	int shiftval = 0;
 	
-	if (shape == "Sine")
-	{
-		currdev = (double) (FTutils::sine_wave (current_secs, (double) rate) * (depth * 0.5 / hzperbin));
-
-	} else if (shape == "Square")
-	{
-		currdev = (double) (FTutils::square_wave (current_secs, (double) rate) * (depth * 0.5 / hzperbin));
-
-	}
-	else if (shape == "Triangle")
-	{
-		currdev = (double) (FTutils::triangle_wave (current_secs, (double) rate) * (depth * 0.5 / hzperbin));
-
-	}
-	else {
+	if (shape == LFO_NONE) {
 		return;
 	}
 
+	currdev = lfoValue (shape, current_secs, (double) rate) * (depth * 0.5 / hzperbin);
+
 
 	shiftval = (int) (currdev - _lastshift);		
 		
@@ -175,9 +174,11 @@ void FTmodRotateLFO::modulate (nframes_t current_frame, fft_data * fftdata, unsi
 		// fprintf (stderr, "shift at %lu :  samps=%g  s*c=%g  s*e=%g \n", (unsigned long) current_frame, samps, (current_frame/samps), ((current_frame + nframes)/samps) );
 
 		
-		for (SpecModList::iterator iter = _specMods.begin(); iter != _specMods.end(); ++iter)
+		TargetArray * tarray = beginTargets();
+		
+		for (unsigned int n = 0; n < tarray->count; ++n)
 		{
-			FTspectrumModifier * sm = (*iter);
+			FTspectrumModifier * sm = tarray->targets[n].specmod;
 			if (sm->getBypassed()) continue;
 
 // 			cerr << "shiftval is: " << shiftval
@@ -185,7 +186,6 @@ void FTmodRotateLFO::modulate (nframes_t current_frame, fft_data * fftdata, unsi
 // 			     << " rate:   " << rate << endl;
 			
 			
-			filter = sm->getValues();
 			sm->getRange(lb, ub);
 			len = (int) sm->getLength();
 			minbin = (int) ((minfreq*2/ _sampleRate) * len);
@@ -203,44 +203,12 @@ void FTmodRotateLFO::modulate (nframes_t current_frame, fft_data * fftdata, unsi
 			
 			// fprintf(stderr, "shifting %d  %d:%d  at %lu\n", shiftbins, minbin, maxbin, (unsigned long) current_frame);
 			
-			if (shiftbins > 0) {
-				// shiftbins is POSITIVE, shift right
-				// store last shiftbins
-				for (i=maxbin-shiftbins; i < maxbin; i++) {
-					_tmpfilt[i] = filter[i];
-				}
-				
-				
-				for ( i=maxbin-1; i >= minbin + shiftbins; i--) {
-					filter[i] = filter[i-shiftbins];
-				}
-				
-				for (j=maxbin-shiftbins, i=minbin; i < minbin + shiftbins; i++, j++) {
-					filter[i] = _tmpfilt[j];
-				}
-			}
-			else if (shiftbins < 0) {
-				// shiftbins is NEGATIVE, shift left
-				// store last shiftbins
-
-				// store first shiftbins
-				for (i=minbin; i < minbin-shiftbins; i++) {
-					_tmpfilt[i] = filter[i];
-				}
-			
-				for (i=minbin; i < maxbin + shiftbins; i++) {
-					filter[i] = filter[i-shiftbins];
-				}
-
-				for (j=minbin, i=maxbin+shiftbins; i < maxbin; i++, j++) {
-					filter[i] = _tmpfilt[j];
-				}
-			}
-			
-			
-			sm->setDirty(true);
+			// just an offset, the filter keeps track of it
+			sm->rotate (minbin, maxbin, shiftbins);
 		}
 
+		endTargets();
+
 		_lastframe = current_frame;
 		_lastshift = (int) currdev;
 	}
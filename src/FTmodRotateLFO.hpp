@@ -37,22 +37,36 @@ class FTmodRotateLFO
 	
 	void modulate (nframes_t current_frame, fft_data * fftdata, unsigned int fftn, sample_t * timedata, nframes_t nframes);
 
-	void setFFTsize (unsigned int fftn);
+	float getUpdateRate();
+
 	
 	
   protected:
 
+	void controlsChanged();
+
 	Control * _rate;
 	Control * _depth;
 	Control * _lfotype;
 	Control * _minfreq;
 	Control * _maxfreq;
 	
+	// compiled from the controls
+	struct Params {
+		float rate;
+		float depth;
+		float minfreq;
+		float maxfreq;
+		LFOShape shape;
+	};
+
+	Snapshot<Params> _snapshot;
+	Params _params;
+	
 	nframes_t _lastframe;
 
 	int _lastshift;
 	
-	float * _tmpfilt;
 };
 
 #endif
@@ -27,6 +27,10 @@
 using namespace std;
 using namespace PBD;
 
+// updates within a target's smoothing time, enough for the ramps
+// between them to join up into a curve
+#define FT_LFO_STEPS_PER_SMOOTHING 4.0f
+
 FTmodValueLFO::FTmodValueLFO (nframes_t samplerate, unsigned int fftn)
 	: FTmodulatorI ("ValueLFO", "Value LFO", samplerate, fftn)
 {
@@ -76,7 +80,8 @@ void FTmodValueLFO::initialize()
 	
 	
 	
-	_tmpfilt = new float[_fftN];
+	attachControls();
+	_snapshot.read (_params);
 	
 	_inited = true;
 }
@@ -95,76 +100,87 @@ FTmodValueLFO::~FTmodValueLFO()
 }
 
 
-void FTmodValueLFO::addSpecMod (FTspectrumModifier * specmod)
+void FTmodValueLFO::controlsChanged()
 {
-	{
-		LockMonitor pmlock(_specmodLock, __LINE__, __FILE__);
-		_lastshifts[specmod] = 0.0;
-	}
+	Params params;
 
-	FTmodulatorI::addSpecMod (specmod);
-}
+	_rate->getValue (params.rate);
+	_depth->getValue (params.depth);
+	_minfreq->getValue (params.minfreq);
+	_maxfreq->getValue (params.maxfreq);
 
-void FTmodValueLFO::removeSpecMod (FTspectrumModifier * specmod)
-{
-	FTmodulatorI::removeSpecMod (specmod);
+	string shape;
+	_lfotype->getValue (shape);
+	params.shape = getLFOShape (shape);
 
-	LockMonitor pmlock(_specmodLock, __LINE__, __FILE__);
-	_lastshifts.erase(specmod);
+	_snapshot.publish (params);
 }
 
-void FTmodValueLFO::clearSpecMods ()
+float FTmodValueLFO::getUpdateRate()
 {
-	FTmodulatorI::clearSpecMods();
-
-	LockMonitor pmlock(_specmodLock, __LINE__, __FILE__);
-	_lastshifts.clear();
-}
+	_snapshot.read (_params);
 
+	if (_params.rate <= 0.0f || _params.shape == LFO_NONE) {
+		// standing still, only following the controls
+		return FT_MOD_IDLE_RATE;
+	}
 
-void FTmodValueLFO::setFFTsize (unsigned int fftn)
-{
-	_fftN = fftn;
-
-	if (_inited) {
-		delete _tmpfilt;
-		_tmpfilt = new float[_fftN];
+	// enough steps per cycle for a smooth curve, and a slow one still
+	// has to step often enough for each filter's smoothing to join
+	// the steps up.  an unsmoothed filter gets every hop
+	float rate = _params.rate * 64.0f;
+	
+	TargetArray * tarray = beginTargets();
+	
+	for (unsigned int n = 0; n < tarray->count; ++n)
+	{
+		float secs = tarray->targets[n].specmod->getSmoothingTime();
+		float need = (secs > 0.0f) ? FT_LFO_STEPS_PER_SMOOTHING / secs : 0.0f;
+		
+		if (need == 0.0f) {
+			rate = 0.0f;
+			break;
+		}
+		rate = need > rate ? need : rate;
 	}
 	
-}
+	endTargets();
 
+	if (rate == 0.0f) {
+		return 0.0f;
+	}
+	return rate > FT_MOD_IDLE_RATE ? rate : FT_MOD_IDLE_RATE;
+}
 
 void FTmodValueLFO::modulate (nframes_t current_frame, fft_data * fftdata, unsigned int fftn, sample_t * timedata, nframes_t nframes)
 {
-	TentativeLockMonitor lm (_specmodLock, __LINE__, __FILE__);
+	if (!_inited || _bypassed) return;
 
-	if (!lm.locked() || !_inited || _bypassed) return;
+	// pick up any control changes
+	_snapshot.read (_params);
 
 	float rate = 1.0;
 	double currdev = 0.0;
 	float ub,lb, tmplb, tmpub;
-	float * filter;
 	int len;
 	float minfreq, maxfreq;
 	float depth = 1.0;
 	unsigned int minbin, maxbin;
-	float shiftval = 0;
 	double current_secs;
-	double lastshift;
-	string shape;
+	LFOShape shape;
 	
 	// in hz
-	_rate->getValue (rate);
+	rate = _params.rate;
 
-	_lfotype->getValue (shape);
+	shape = _params.shape;
 
 	// in %
-	_depth->getValue (depth);
+	depth = _params.depth;
 	
-	_minfreq->getValue (minfreq);
-	_maxfreq->getValue (maxfreq);
+	minfreq = _params.minfreq;
+	maxfreq = _params.maxfreq;
 
-	if (minfreq >= maxfreq) {
+	if (minfreq >= maxfreq || shape == LFO_NONE) {
 		return;
 	}
 
@@ -176,16 +192,17 @@ void FTmodValueLFO::modulate (nframes_t current_frame, fft_data * fftdata, unsig
 		// fprintf (stderr, "shift at %lu :  samps=%g  s*c=%g  s*e=%g \n", (unsigned long) current_frame, samps, (current_frame/samps), ((current_frame + nframes)/samps) );
 
 		
-		for (SpecModList::iterator iter = _specMods.begin(); iter != _specMods.end(); ++iter)
+		TargetArray * tarray = beginTargets();
+		
+		for (unsigned int n = 0; n < tarray->count; ++n)
 		{
-			FTspectrumModifier * sm = (*iter);
+			FTspectrumModifier * sm = tarray->targets[n].specmod;
 			if (sm->getBypassed()) continue;
 
 // 			cerr << "shiftval is: " << shiftval
 // 			     << " hz/bin: " << hzperbin
 // 			     << " rate:   " << rate << endl;
 			
-			filter = sm->getValues();
 			sm->getRange(tmplb, tmpub);
 			len = (int) sm->getLength();
 			minbin = (int) ((minfreq*2/ _sampleRate) * len);
@@ -202,37 +219,14 @@ void FTmodValueLFO::modulate (nframes_t current_frame, fft_data * fftdata, unsig
 				continue;
 			}
 
-			if (shape == "Sine")
-			{
-				currdev = (double) (FTutils::sine_wave (current_secs, (double) rate) * ( (ub-lb)* (depth * 0.01) * 0.5 ));
-				
-			} else if (shape == "Square")
-			{
-				currdev = (double) (FTutils::square_wave (current_secs, (double) rate) * ( (ub-lb)* (depth * 0.01) * 0.5 ));
-				
-			}
-			else if (shape == "Triangle")
-			{
-				currdev = (double) (FTutils::triangle_wave (current_secs, (double) rate) * ( (ub-lb)* (depth * 0.01) * 0.5 ));
-			}
-			else {
-				continue;
-			}
-			
-			lastshift = _lastshifts[sm];
-			shiftval = (float) (currdev - lastshift);		
+			currdev = lfoValue (shape, current_secs, (double) rate) * ( (ub-lb)* (depth * 0.01) * 0.5 );
 		
-			// fprintf(stderr, "shifting %d  %d:%d  at %lu\n", shiftbins, minbin, maxbin, (unsigned long) current_frame);
-
-			for (unsigned int i=minbin; i < maxbin; ++i) {
-				filter[i] += shiftval;
-			}
-			
-			sm->setDirty(true);
-
-			_lastshifts[sm] = currdev;
+			// the filter adds it on top of its values
+			sm->setRoute (this, minbin, maxbin, (float) (currdev * tarray->targets[n].depth));
 		}
 
+		endTargets();
+
 		_lastframe = current_frame;
 	}
 }
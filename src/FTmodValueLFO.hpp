@@ -22,7 +22,7 @@
 
 #include "FTmodulatorI.hpp"
 
-#include <map>
+#include <vector>
 
 class FTmodValueLFO
 	: public FTmodulatorI
@@ -39,25 +39,32 @@ class FTmodValueLFO
 	
 	void modulate (nframes_t current_frame, fft_data * fftdata, unsigned int fftn, sample_t * timedata, nframes_t nframes);
 
-	void setFFTsize (unsigned int fftn);
-	
-	void addSpecMod (FTspectrumModifier * specmod);
-	void removeSpecMod (FTspectrumModifier * specmod);
-	void clearSpecMods ();
-	
+	float getUpdateRate();
+
   protected:
 
+	void controlsChanged();
+
 	Control * _rate;
 	Control * _depth;
 	Control * _lfotype;
 	Control * _minfreq;
 	Control * _maxfreq;
 	
-	nframes_t _lastframe;
+	// compiled from the controls
+	struct Params {
+		float rate;
+		float depth;
+		float minfreq;
+		float maxfreq;
+		LFOShape shape;
+	};
 
-	std::map<FTspectrumModifier *, double> _lastshifts;
+	Snapshot<Params> _snapshot;
+	Params _params;
 	
-	float * _tmpfilt;
+	nframes_t _lastframe;
+
 };
 
 #endif
@@ -47,7 +47,8 @@ enum {
 	ID_EditMenuItem,
 	ID_RemoveMenuItem,
 	ID_ChannelList,
-	ID_ClearButton
+	ID_ClearButton,
+	ID_CostTimer
 };
 
 
@@ -66,6 +67,7 @@ BEGIN_EVENT_TABLE(FTmodulatorDialog, wxFrame)
 	EVT_PAINT (FTmodulatorDialog::onPaint)
 
 	EVT_BUTTON (ID_ClearButton, FTmodulatorDialog::onClearButton)
+	EVT_TIMER (ID_CostTimer, FTmodulatorDialog::onCostTimer)
 
 	EVT_COMMAND_RANGE(ID_AddModulatorChannelBase, ID_AddModulatorChannelMax, wxEVT_COMMAND_BUTTON_CLICKED, FTmodulatorDialog::onAddButton)
 	
@@ -93,10 +95,15 @@ FTmodulatorDialog::FTmodulatorDialog(FTmainwin * parent, wxWindowID id,
 {
 
 	init();
+
+	_costTimer = new wxTimer(this, ID_CostTimer);
+	_costTimer->Start(1000);
 }
 
 FTmodulatorDialog::~FTmodulatorDialog()
 {
+	_costTimer->Stop();
+	delete _costTimer;
 }
 
 
@@ -338,6 +345,15 @@ void FTmodulatorDialog::OnIdle(wxIdleEvent &ev)
 	ev.Skip();
 }
 
+void FTmodulatorDialog::onCostTimer (wxTimerEvent &ev)
+{
+	if (!IsShown()) return;
+	
+	for (map<FTmodulatorI*, FTmodulatorGui*>::iterator iter = _modulatorGuis.begin(); iter != _modulatorGuis.end(); ++iter) {
+		(*iter).second->refreshCost();
+	}
+}
+
 void FTmodulatorDialog::onModulatorDeath (FTmodulatorI * mod)
 {
 	//cerr << "mod death: " << mod->getName() << endl;
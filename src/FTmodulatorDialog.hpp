@@ -70,6 +70,8 @@ class FTmodulatorDialog : public wxFrame, public SigC::Object
 
 	void onModulatorAdded (FTmodulatorI * mod, int channel);
 
+	void onCostTimer (wxTimerEvent &ev);
+
 
 	void appendModGui(FTmodulatorI * mod, bool layout=true);
 	
@@ -96,6 +98,9 @@ class FTmodulatorDialog : public wxFrame, public SigC::Object
 
 	std::list<FTmodulatorGui *> _deadGuis;
 
+	// refreshes the shown modulator costs
+	wxTimer * _costTimer;
+	
 	bool _justResized;
 	int _lastSelected;
 private:
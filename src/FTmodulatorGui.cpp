@@ -17,6 +17,8 @@
 **  
 */
 
+#include <math.h>
+
 #include <wx/wx.h>
 
 #include "FTmodulatorGui.hpp"
@@ -36,7 +38,10 @@ enum
 	ID_DetachAll,
 	ID_AttachAll,
 	ID_ModUserName,
-	ID_BypassCheck
+	ID_BypassCheck,
+	ID_DepthChoice,
+	ID_DepthSlider,
+	ID_DepthText
 };
 
 
@@ -90,6 +95,10 @@ BEGIN_EVENT_TABLE(FTmodulatorGui, wxPanel)
 	EVT_CHECKBOX(ID_BypassCheck, FTmodulatorGui::onBypassButton)
 	
 	EVT_TEXT_ENTER (ID_ModUserName, FTmodulatorGui::onTextEnter)
+	EVT_TEXT_ENTER (ID_DepthText, FTmodulatorGui::onTextEnter)
+
+	EVT_CHOICE (ID_DepthChoice, FTmodulatorGui::onDepthChoice)
+	EVT_COMMAND_SCROLL (ID_DepthSlider, FTmodulatorGui::onDepthSlider)
 	
 	EVT_MENU (ID_AttachAll, FTmodulatorGui::onAttachMenu)
 	EVT_MENU (ID_DetachAll, FTmodulatorGui::onAttachMenu)
@@ -103,7 +112,8 @@ FTmodulatorGui::FTmodulatorGui (FTioSupport * iosup, FTmodulatorI *mod, wxWindow
 				const wxString& name)
 
 	: wxPanel(parent, id, pos, size, style, name),
-	  _modulator (mod), _iosup(iosup), _popupMenu(0), _channelPopupMenu(0)
+	  _modulator (mod), _iosup(iosup), _popupMenu(0), _channelPopupMenu(0),
+	  _depthChoice(0), _depthSlider(0), _depthText(0)
 {
 
 	init();
@@ -136,6 +146,10 @@ void FTmodulatorGui::init()
 	_nameText = new wxTextCtrl (this, ID_ModUserName, wxString::FromAscii(_modulator->getUserName().c_str()), wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
 	topSizer->Add (_nameText, 1, wxALL|wxALIGN_CENTRE_VERTICAL, 2);
 
+	_costText = new wxStaticText(this, -1, wxT("0 cyc/hop"), wxDefaultPosition, wxSize(-1, -1));
+	_costText->SetToolTip (wxT("Average cycles spent per hop"));
+	topSizer->Add (_costText, 0, wxALL|wxALIGN_CENTRE_VERTICAL, 2);
+
 	wxCheckBox * bypassCheck = new wxCheckBox(this, ID_BypassCheck, wxT("Bypass"));
 	bypassCheck->SetValue(_modulator->getBypassed());
 	topSizer->Add (bypassCheck, 0, wxTOP|wxBOTTOM|wxALIGN_CENTRE_VERTICAL, 2);
@@ -333,6 +347,25 @@ void FTmodulatorGui::init()
 	//		  1, wxEXPAND|wxALL, 2);
 
 
+	// how much of it each attached filter gets
+	rowsizer = new wxBoxSizer(wxHORIZONTAL);
+	stattext = new wxStaticText(this, -1, wxT("Filter depth [%]"));
+	rowsizer->Add (stattext, 0, wxALL|wxALIGN_CENTRE_VERTICAL, 2);
+
+	_depthChoice = new wxChoice(this, ID_DepthChoice, wxDefaultPosition, wxDefaultSize, 0, 0);
+	rowsizer->Add (_depthChoice, 0, wxALL|wxALIGN_CENTRE_VERTICAL, 2);
+
+	_depthSlider = new wxSlider(this, ID_DepthSlider, 100, -200, 200);
+	rowsizer->Add (_depthSlider, 1, wxALL|wxALIGN_CENTRE_VERTICAL, 2);
+
+	_depthText = new wxTextCtrl (this, ID_DepthText, wxT("100"), wxDefaultPosition, wxSize(textwidth, -1),
+				     wxTE_PROCESS_ENTER|wxTE_RIGHT);
+	rowsizer->Add (_depthText, 0, wxALL|wxALIGN_CENTRE_VERTICAL, 2);
+
+	controlSizer->Add (rowsizer, 0, wxEXPAND|wxALL, 2);
+
+	refreshDepths();
+
 	_modulator->GoingAway.connect ( slot (*this, &FTmodulatorGui::onModulatorDeath));
 	
 	mainSizer->Add (controlSizer, 1, wxEXPAND|wxALL, 2);
@@ -344,6 +377,78 @@ void FTmodulatorGui::init()
 }
 
 
+void FTmodulatorGui::refreshCost()
+{
+	_costText->SetLabel (wxString::Format(wxT("%.0f cyc/hop"), _modulator->getCost()));
+}
+
+void FTmodulatorGui::refreshDepths()
+{
+	FTspectrumModifier * selected = 0;
+	int sel = _depthChoice->GetSelection();
+	if (sel >= 0 && sel < (int) _depthTargets.size()) {
+		selected = _depthTargets[sel];
+	}
+	
+	FTmodulatorI::SpecModList mods;
+	_modulator->getSpecMods (mods);
+	
+	_depthChoice->Clear();
+	_depthTargets.clear();
+	sel = 0;
+	
+	for (FTmodulatorI::SpecModList::iterator iter = mods.begin(); iter != mods.end(); ++iter)
+	{
+		FTspectrumModifier * specmod = *iter;
+
+		if (specmod == selected) {
+			sel = _depthTargets.size();
+		}
+		
+		_depthChoice->Append (wxString::Format(wxT("%d: "), specmod->getId() + 1)
+				      + wxString::FromAscii (specmod->getName().c_str()));
+		_depthTargets.push_back (specmod);
+	}
+
+	if (!_depthTargets.empty()) {
+		_depthChoice->SetSelection (sel);
+	}
+
+	showDepth();
+}
+
+void FTmodulatorGui::showDepth()
+{
+	int sel = _depthChoice->GetSelection();
+	bool any = (_modulator && sel >= 0 && sel < (int) _depthTargets.size());
+	
+	_depthChoice->Enable (any);
+	_depthSlider->Enable (any);
+	_depthText->Enable (any);
+
+	float depth = any ? _modulator->getRouteDepth (_depthTargets[sel]) * 100.0f : 100.0f;
+
+	_depthSlider->SetValue ((int) floorf (depth + 0.5f));
+	_depthText->SetValue (wxString::Format(wxT("%.6g"), depth));
+}
+
+void FTmodulatorGui::onDepthChoice (wxCommandEvent &ev)
+{
+	showDepth();
+}
+
+void FTmodulatorGui::onDepthSlider (wxScrollEvent &ev)
+{
+	int sel = _depthChoice->GetSelection();
+
+	if (_modulator && sel >= 0 && sel < (int) _depthTargets.size()) {
+		int currval = _depthSlider->GetValue();
+
+		_modulator->setRouteDepth (_depthTargets[sel], currval * 0.01f);
+		_depthText->SetValue (wxString::Format(wxT("%d"), currval));
+	}
+}
+
 void FTmodulatorGui::refreshMenu()
 {
 	if (_popupMenu) {
@@ -461,6 +566,7 @@ void FTmodulatorGui::onAttachMenu (wxCommandEvent & ev)
 		}
 	}
 
+	refreshDepths();
 }
 
 void FTmodulatorGui::onRemoveButton (wxCommandEvent & ev)
@@ -661,6 +767,18 @@ void FTmodulatorGui::onTextEnter (wxCommandEvent &ev)
 		_modulator->setUserName (name);
 		// cerr << "name changed to :" << name << endl;
 	}
+	else if (ev.GetId() == ID_DepthText)
+	{
+		int sel = _depthChoice->GetSelection();
+		double tmpfloat;
+
+		if (sel >= 0 && sel < (int) _depthTargets.size()
+		    && _depthText->GetValue().ToDouble (&tmpfloat))
+		{
+			_modulator->setRouteDepth (_depthTargets[sel], (float) tmpfloat * 0.01f);
+		}
+		showDepth();
+	}
 	else {
 
 		FTmodControlObject * cobj = (FTmodControlObject *) ev.m_callbackUserData;
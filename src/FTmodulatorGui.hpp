@@ -51,6 +51,9 @@ class FTmodulatorGui
 
 
 	SigC::Signal0<void> RemovalRequest;
+
+	// updates the shown cost from the modulator
+	void refreshCost();
 	
    protected:
 
@@ -64,6 +67,8 @@ class FTmodulatorGui
 	void onChannelButton (wxCommandEvent & ev);
 	void onTextEnter (wxCommandEvent &ev);
 	void onBypassButton (wxCommandEvent &ev);
+	void onDepthChoice (wxCommandEvent &ev);
+	void onDepthSlider (wxScrollEvent &ev);
 	
 
 	void onModulatorDeath (FTmodulatorI * mod);
@@ -74,15 +79,25 @@ class FTmodulatorGui
 	
 	void refreshMenu();
 	void refreshChannelMenu();
+	// lists the attached filters for the depth control
+	void refreshDepths();
+	void showDepth();
 	
 	FTmodulatorI * _modulator;
 	FTioSupport * _iosup;
 	
 	wxTextCtrl *   _nameText;
+	wxStaticText * _costText;
 
 	wxMenu *       _popupMenu;
 
 	wxMenu *       _channelPopupMenu;
+
+	// per filter depth, see FTmodulatorI::setRouteDepth()
+	wxChoice *     _depthChoice;
+	wxSlider *     _depthSlider;
+	wxTextCtrl *   _depthText;
+	std::vector<FTspectrumModifier *> _depthTargets;
 	
 	// std::map<wxWindow *, FTmodulatorI::Control *> _controlMap;
 
@@ -23,27 +23,131 @@
 
 
 #include "FTmodulatorI.hpp"
+#include "FTutils.hpp"
 #include <algorithm>
+#include <unistd.h>
 
 using namespace std;
 using namespace PBD;
 
 FTmodulatorI::FTmodulatorI(string confname, string name, nframes_t samplerate, unsigned int fftn)
 	: _inited(false), _name(name), _confname(confname), _userName("Unnamed"), _bypassed(false),
-	  _sampleRate(samplerate), _fftN(fftn)
+	  _sampleRate(samplerate), _fftN(fftn), _features(0), _hopOffset(0), _cost(0.0f)
 {
+	_targetArray = new TargetArray;
+	_targetArray->count = 0;
+	_targetArray->targets = 0;
+	_readers = 0;
+	_targetsVersion = 0;
 }
 
 FTmodulatorI::~FTmodulatorI()
 {
 	clearSpecMods();
 	GoingAway(this); // emit
+
+	// nobody is modulating with us by now
+	_retiredArrays.push_back ((TargetArray *) _targetArray);
+	for (vector<TargetArray *>::iterator iter = _retiredArrays.begin(); iter != _retiredArrays.end(); ++iter) {
+		delete [] (*iter)->targets;
+		delete (*iter);
+	}
+}
+
+FTmodulatorI::TargetArray FTmodulatorI::_noTargets = { 0, 0 };
+
+void FTmodulatorI::publishTargets()
+{
+	TargetArray * tarray = new TargetArray;
+	tarray->count = _specMods.size();
+	tarray->targets = new Target[tarray->count];
+
+	unsigned int n = 0;
+	for (SpecModList::iterator iter = _specMods.begin(); iter != _specMods.end(); ++iter, ++n)
+	{
+		tarray->targets[n].specmod = (*iter);
+
+		map<FTspectrumModifier *, float>::iterator found = _routeDepths.find (*iter);
+		tarray->targets[n].depth = (found != _routeDepths.end()) ? found->second : 1.0f;
+	}
+
+	__sync_synchronize();
+	
+	_retiredArrays.push_back ((TargetArray *) _targetArray);
+	_targetArray = tarray;
+
+	// after the array, see beginTargets()
+	__sync_synchronize();
+	__sync_add_and_fetch (&_targetsVersion, 1);
+}
+
+void FTmodulatorI::reclaimTargets (bool wait)
+{
+	while (_readers > 0) {
+		if (!wait) return;
+		usleep (500);
+	}
+
+	// any modulate() from here on sees _targetArray
+	for (vector<TargetArray *>::iterator iter = _retiredArrays.begin(); iter != _retiredArrays.end(); ++iter) {
+		delete [] (*iter)->targets;
+		delete (*iter);
+	}
+
+	_retiredArrays.clear();
+}
+
+void FTmodulatorI::attachControls()
+{
+	for (ControlList::iterator iter = _controls.begin(); iter != _controls.end(); ++iter)
+	{
+		(*iter)->_owner = this;
+	}
+
+	controlsChanged();
+}
+
+FTmodulatorI::LFOShape FTmodulatorI::getLFOShape (const string & name)
+{
+	if (name == "Sine") {
+		return LFO_SINE;
+	}
+	else if (name == "Triangle") {
+		return LFO_TRIANGLE;
+	}
+	else if (name == "Square") {
+		return LFO_SQUARE;
+	}
+
+	return LFO_NONE;
+}
+
+double FTmodulatorI::lfoValue (LFOShape shape, double secs, double rate)
+{
+	switch (shape) {
+	case LFO_SINE:
+		return FTutils::sine_wave (secs, rate);
+	case LFO_TRIANGLE:
+		return FTutils::triangle_wave (secs, rate);
+	case LFO_SQUARE:
+		return FTutils::square_wave (secs, rate);
+	default:
+		break;
+	}
+
+	return 0.0;
 }
 
 void FTmodulatorI::goingAway(FTspectrumModifier * ft)
 {
 	LockMonitor pmlock(_specmodLock, __LINE__, __FILE__);
 	_specMods.remove (ft);
+	_routeDepths.erase (ft);
+	publishTargets();
+
+	// ft is deleted when we return, make sure modulate() is done
+	// with the array that still had it
+	reclaimTargets (true);
 }
 
 	
@@ -56,6 +160,8 @@ void FTmodulatorI::addSpecMod (FTspectrumModifier * specmod)
 	{
 		specmod->registerListener(this);
 		_specMods.push_back (specmod);
+		publishTargets();
+		reclaimTargets (false);
 	}
 }
 
@@ -64,20 +170,32 @@ void FTmodulatorI::removeSpecMod (FTspectrumModifier * specmod)
 	if (!specmod) return;
 	LockMonitor pmlock(_specmodLock, __LINE__, __FILE__);
 	_specMods.remove (specmod);
+	_routeDepths.erase (specmod);
 	specmod->unregisterListener(this);
 	specmod->setDirty(false);
+	publishTargets();
+	// the caller may delete it next
+	reclaimTargets (true);
+	specmod->clearRoute (this);
 }
 
 void FTmodulatorI::clearSpecMods ()
 {
 	LockMonitor pmlock(_specmodLock, __LINE__, __FILE__);
 
-	for (SpecModList::iterator iter = _specMods.begin(); iter != _specMods.end(); ++iter)
+	SpecModList oldmods;
+	oldmods.swap (_specMods);
+	_routeDepths.clear();
+	
+	publishTargets();
+	reclaimTargets (true);
+	
+	for (SpecModList::iterator iter = oldmods.begin(); iter != oldmods.end(); ++iter)
 	{
 		(*iter)->unregisterListener(this);
 		(*iter)->setDirty(false);
+		(*iter)->clearRoute (this);
 	}
-	_specMods.clear();
 }
 
 void FTmodulatorI::getSpecMods (SpecModList & mods)
@@ -86,6 +204,54 @@ void FTmodulatorI::getSpecMods (SpecModList & mods)
 	mods.insert (mods.begin(), _specMods.begin(), _specMods.end());
 }
 
+void FTmodulatorI::setRouteDepth (FTspectrumModifier * specmod, float depth)
+{
+	LockMonitor pmlock(_specmodLock, __LINE__, __FILE__);
+
+	if (find(_specMods.begin(), _specMods.end(), specmod) == _specMods.end()) {
+		return;
+	}
+	
+	if (depth == 1.0f) {
+		_routeDepths.erase (specmod);
+	}
+	else {
+		_routeDepths[specmod] = depth;
+	}
+
+	publishTargets();
+	reclaimTargets (false);
+}
+
+float FTmodulatorI::getRouteDepth (FTspectrumModifier * specmod)
+{
+	LockMonitor pmlock(_specmodLock, __LINE__, __FILE__);
+
+	map<FTspectrumModifier *, float>::iterator found = _routeDepths.find (specmod);
+	return (found != _routeDepths.end()) ? found->second : 1.0f;
+}
+
+void FTmodulatorI::setBypassed (bool byp)
+{
+	_bypassed = byp;
+	__sync_synchronize();
+	__sync_add_and_fetch (&_targetsVersion, 1);
+
+	if (byp) {
+		// before looking for readers, see beginTargets()
+		__sync_synchronize();
+		
+		LockMonitor pmlock(_specmodLock, __LINE__, __FILE__);
+
+		// once a running modulate() is done nothing puts them back
+		reclaimTargets (true);
+		
+		for (SpecModList::iterator iter = _specMods.begin(); iter != _specMods.end(); ++iter) {
+			(*iter)->clearRoute (this);
+		}
+	}
+}
+
 bool FTmodulatorI::hasSpecMod (FTspectrumModifier *specmod)
 {
 	LockMonitor pmlock(_specmodLock, __LINE__, __FILE__);
@@ -23,6 +23,8 @@
 #include "FTtypes.hpp"
 #include <string>
 #include <list>
+#include <vector>
+#include <map>
 #include <algorithm>
 #include <sigc++/sigc++.h>
 #include <iostream>
@@ -31,6 +33,12 @@
 #include "LockMonitor.hpp"
 #include "FTspectrumModifier.hpp"
 
+class FTspectralFeatures;
+class FTspectralEngine;
+
+// how often a modulator with nothing to do still looks at its controls
+#define FT_MOD_IDLE_RATE 2.0f
+
 
 class FTmodulatorI
 	: public FTspectrumModifier::Listener
@@ -54,6 +62,11 @@ class FTmodulatorI
 	virtual void clearSpecMods ();
 	virtual void getSpecMods (SpecModList & mods);
 	virtual bool hasSpecMod (FTspectrumModifier *specmod);
+
+	// scales what this modulator does to one target, 1 is the
+	// modulator's own depth
+	void setRouteDepth (FTspectrumModifier * specmod, float depth);
+	float getRouteDepth (FTspectrumModifier * specmod);
 	
 	virtual std::string getUserName() { return _userName; }
 	virtual void setUserName (std::string username) { _userName = username; }
@@ -69,10 +82,71 @@ class FTmodulatorI
 
 
 	virtual bool getBypassed() { return _bypassed; }
-	virtual void setBypassed(bool byp) { _bypassed = byp; }
+	virtual void setBypassed(bool byp);
+
+	// the engine running us hands over its input features, which
+	// it only computes while some modulator says it uses them
+	void setFeatures (const FTspectralFeatures * features) { _features = features; }
+	virtual bool usesFeatures() { return false; }
+
+	// how often modulate() needs to be called, in Hz.  The engine
+	// spreads slower modulators across hops, 0 means every hop
+	virtual float getUpdateRate() { return 0.0f; }
+
+	// average cycles spent in modulate() per hop, hops it was
+	// skipped count as free.  kept by the engine
+	float getCost() { return _cost; }
 
 	SigC::Signal1<void, FTmodulatorI *> GoingAway;
 
+	enum LFOShape {
+		LFO_SINE = 0,
+		LFO_TRIANGLE,
+		LFO_SQUARE,
+		LFO_NONE
+	};
+
+	static LFOShape getLFOShape (const std::string & name);
+	static double lfoValue (LFOShape shape, double secs, double rate);
+
+	
+	// A small POD parameter block published by the gui thread and
+	// picked up by the audio thread without a lock.  read() retries
+	// when it races a publish and leaves val alone if it still can't
+	// get a clean copy, so the caller just keeps its last one.
+	template <class T>
+	class Snapshot
+	{
+	  public:
+		Snapshot() : _seq(0) {}
+
+		void publish (const T & val) {
+			__sync_add_and_fetch (&_seq, 1);
+			_val = val;
+			__sync_add_and_fetch (&_seq, 1);
+		}
+
+		bool read (T & val) const {
+			for (int tries = 0; tries < 4; ++tries) {
+				unsigned int seq = _seq;
+				__sync_synchronize();
+				if (seq == 0) return false;
+				if (seq & 1) continue;
+				T tmp = _val;
+				__sync_synchronize();
+				if (seq == _seq) {
+					val = tmp;
+					return true;
+				}
+			}
+			return false;
+		}
+		
+	  private:
+		volatile unsigned int _seq;
+		T _val;
+	};
+
 
 	
 	class Control
@@ -86,7 +160,7 @@ class FTmodulatorI
 			EnumType
 		};
 
-		Control (Type t, std::string confname, std::string name, std::string units) : _type(t), _confname(confname), _name(name), _units(units) {}
+		Control (Type t, std::string confname, std::string name, std::string units) : _type(t), _confname(confname), _name(name), _units(units), _owner(0) {}
 		
 		Type getType() { return _type; }
 		std::string getConfName() { return _confname; }
@@ -130,6 +204,9 @@ class FTmodulatorI
 		int    _intVal;
 		bool   _boolVal;
 
+		// told about every change once attached
+		FTmodulatorI * _owner;
+		inline void changed();
 	};
 
 	typedef std::list<Control *> ControlList;
@@ -142,20 +219,78 @@ class FTmodulatorI
    protected:
 
 	FTmodulatorI(std::string confname, std::string name, nframes_t samplerate, unsigned int fftn);
+
+	// modulators call this at the end of initialize(), from then on
+	// controlsChanged() is called whenever one of _controls is set
+	void attachControls();
+
+	// compile the controls into a parameter Snapshot here so the
+	// audio thread never has to look at them
+	virtual void controlsChanged() {}
+
+	// The targets as modulate() sees them.  The gui side keeps
+	// _specMods under _specmodLock and publishes a fresh array after
+	// every change, an array is never changed once published.
+	struct Target {
+		FTspectrumModifier * specmod;
+		float depth;
+	};
+	
+	struct TargetArray {
+		unsigned int count;
+		Target * targets;
+	};
+
+	// modulate() brackets its use of the targets with these, the
+	// array stays valid until endTargets().  While bypassed there are
+	// none: _bypassed is looked at after counting ourselves in, so
+	// setBypassed() either waits for us or we see it.  version, if
+	// given, changes whenever what it returns might have (a freed
+	// array's address can come back, so don't compare those)
+	TargetArray * beginTargets (unsigned int * version = 0) {
+		__sync_add_and_fetch (&_readers, 1);
+		if (version) {
+			*version = _targetsVersion;
+			__sync_synchronize();
+		}
+		return _bypassed ? &_noTargets : _targetArray;
+	}
+	void endTargets() { __sync_sub_and_fetch (&_readers, 1); }
+
+	// gui side, call with _specmodLock held
+	void publishTargets();
+	// frees the old arrays once no modulate() can be looking at
+	// them.  with wait it waits for a running modulate() instead of
+	// leaving them for next time
+	void reclaimTargets (bool wait);
 	
 	ControlList _controls;
 
 	SpecModList _specMods;
 	PBD::NonBlockingLock _specmodLock;
+	std::map<FTspectrumModifier *, float> _routeDepths;
+
+	TargetArray * volatile _targetArray;
+	static TargetArray _noTargets;
+	volatile int _readers;
+	// bumped after every publishTargets() and setBypassed()
+	volatile unsigned int _targetsVersion;
+	std::vector<TargetArray *> _retiredArrays;
 
 	bool _inited;
 	std::string _name;
 	std::string _confname;
 	std::string _userName;
-	bool _bypassed;
+	volatile bool _bypassed;
 	nframes_t _sampleRate;
 	unsigned int _fftN;
+	const FTspectralFeatures * _features;
 	int _id;
+
+	// the engine's scheduling state
+	friend class FTspectralEngine;
+	unsigned int _hopOffset;
+	float _cost;
 };
 
 
@@ -213,10 +348,18 @@ inline bool FTmodulatorI::Control::getBounds(float & lb, float & ub)
 }
 
 
+inline void FTmodulatorI::Control::changed()
+{
+	if (_owner) {
+		_owner->controlsChanged();
+	}
+}
+
 inline bool FTmodulatorI::Control::setValue(bool val)
 {
 	if (_type != BooleanType) return false;
 	_boolVal = val;
+	changed();
 	return true;
 }
 
@@ -224,6 +367,7 @@ inline bool FTmodulatorI::Control::setValue(int val)
 {
 	if (_type != IntegerType) return false;
 	_intVal = val;
+	changed();
 	return true;
 }
 
@@ -231,6 +375,7 @@ inline bool FTmodulatorI::Control::setValue(float val)
 {
 	if (_type != FloatType) return false;
 	_floatVal = val;
+	changed();
 	return true;
 }
 
@@ -239,10 +384,12 @@ inline bool FTmodulatorI::Control::setValue(const std::string & val)
 {
 	if (_type == StringType) {
 		_stringVal = val;
+		changed();
 		return true;
 	}
 	else if (_type == EnumType && std::find(_enumList.begin(), _enumList.end(), val) != _enumList.end()) {
 		_stringVal = val;
+		changed();
 		return true;
 	}
 
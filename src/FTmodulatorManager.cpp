@@ -25,6 +25,8 @@
 #include "FTmodRotate.hpp"
 #include "FTmodRotateLFO.hpp"
 #include "FTmodValueLFO.hpp"
+#include "FTmodFeature.hpp"
+#include "FTmodMorph.hpp"
 
 FTmodulatorManager * FTmodulatorManager::_instance = 0;
 
@@ -48,6 +50,12 @@ FTmodulatorManager::FTmodulatorManager()
 	 procmod = new FTmodRandomize (samprate, fftn);
 	_prototypes.push_back (procmod);
 
+	procmod = new FTmodFeature (samprate, fftn);
+	_prototypes.push_back (procmod);
+
+	procmod = new FTmodMorph (samprate, fftn);
+	_prototypes.push_back (procmod);
+
 	
 }
 
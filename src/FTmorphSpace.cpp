@@ -0,0 +1,270 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#include <cstring>
+#include <cmath>
+#include <unistd.h>
+
+#include "FTmorphSpace.hpp"
+#include "FTspectrumModifier.hpp"
+#include "FTutils.hpp"
+
+FTmorphSpace * volatile FTmorphSpace::_current = 0;
+volatile int FTmorphSpace::_readers = 0;
+volatile unsigned int FTmorphSpace::_version = 0;
+vector<FTmorphSpace *> FTmorphSpace::_retired;
+
+
+FTmorphSpace::FTmorphSpace (unsigned int presets)
+	: _presets (presets > FT_MAX_MORPH_PRESETS ? FT_MAX_MORPH_PRESETS : presets)
+{
+}
+
+FTmorphSpace::~FTmorphSpace()
+{
+	for (vector<Filter>::iterator iter = _filters.begin(); iter != _filters.end(); ++iter) {
+		delete [] (*iter).rows;
+	}
+}
+
+void FTmorphSpace::computeWeights (float x, float y, float * weights) const
+{
+	unsigned int n;
+	
+	x = x < 0.0f ? 0.0f : (x > 1.0f ? 1.0f : x);
+	y = y < 0.0f ? 0.0f : (y > 1.0f ? 1.0f : y);
+
+	if (_presets == 1) {
+		weights[0] = 1.0f;
+	}
+	else if (_presets == 2) {
+		weights[0] = 1.0f - x;
+		weights[1] = x;
+	}
+	else if (_presets == 3) {
+		// barycentric in (0,0) (1,0) (0.5,1), outside it goes to
+		// the nearest edge
+		weights[2] = y;
+		weights[1] = x - 0.5f * y;
+		weights[0] = 1.0f - x - 0.5f * y;
+
+		float sum = 0.0f;
+		for (n=0; n < 3; n++) {
+			if (weights[n] < 0.0f) weights[n] = 0.0f;
+			sum += weights[n];
+		}
+		for (n=0; n < 3; n++) {
+			weights[n] /= sum;
+		}
+	}
+	else if (_presets == 4) {
+		// bilinear across the corners
+		weights[0] = (1.0f - x) * (1.0f - y);
+		weights[1] = x * (1.0f - y);
+		weights[2] = (1.0f - x) * y;
+		weights[3] = x * y;
+	}
+	else if (_presets > 4) {
+		// inverse distance squared to points around a circle
+		float sum = 0.0f;
+		
+		for (n=0; n < _presets; n++) {
+			float angle = 2.0f * (float) M_PI * n / _presets;
+			float dx = x - (0.5f + 0.5f * sinf (angle));
+			float dy = y - (0.5f - 0.5f * cosf (angle));
+			float dist = dx*dx + dy*dy;
+
+			if (dist < 1e-6f) {
+				// right on it
+				memset (weights, 0, _presets * sizeof(float));
+				weights[n] = 1.0f;
+				return;
+			}
+
+			weights[n] = 1.0f / dist;
+			sum += weights[n];
+		}
+		
+		for (n=0; n < _presets; n++) {
+			weights[n] /= sum;
+		}
+	}
+}
+
+int FTmorphSpace::addFilter (FTspectrumModifier * target, int length)
+{
+	Filter filt;
+
+	filt.target = target;
+	filt.length = length;
+
+	switch (target ? target->getModifierType() : FTspectrumModifier::NULL_MODIFIER)
+	{
+	case FTspectrumModifier::GAIN_MODIFIER:
+	case FTspectrumModifier::POS_GAIN_MODIFIER:
+		filt.domain = DOMAIN_DB;
+		break;
+	case FTspectrumModifier::RATIO_MODIFIER:
+	case FTspectrumModifier::SEMITONE_MODIFIER:
+		filt.domain = DOMAIN_LOG;
+		break;
+	case FTspectrumModifier::FREQ_MODIFIER:
+		filt.domain = DOMAIN_LOGFREQ;
+		break;
+	default:
+		// DB_MODIFIER is in dB already
+		filt.domain = DOMAIN_LINEAR;
+		break;
+	}
+	
+	filt.stride = (length + 3) & ~3;
+	// new[] is 16 byte aligned for floats here
+	filt.rows = new float[filt.stride * (_presets > 0 ? _presets : 1)];
+	memset (filt.rows, 0, filt.stride * _presets * sizeof(float));
+
+	_filters.push_back (filt);
+
+	return (int) _filters.size() - 1;
+}
+
+void FTmorphSpace::setRow (int filter, unsigned int preset, const float * values, int length)
+{
+	if (filter < 0 || filter >= (int) _filters.size() || preset >= _presets || length <= 0) return;
+
+	Filter & filt = _filters[filter];
+	float * row = filt.rows + preset * filt.stride;
+
+	if (length == filt.length) {
+		memcpy (row, values, length * sizeof(float));
+	}
+	else {
+		// stored at another size
+		FTutils::vector_resample (values, length, row, filt.length);
+	}
+
+	// once here instead of on every blend
+	toDomain (filt.domain, row, filt.length);
+}
+
+int FTmorphSpace::findFilter (const FTspectrumModifier * target) const
+{
+	for (unsigned int n=0; n < _filters.size(); n++) {
+		if (_filters[n].target == target) {
+			return (int) n;
+		}
+	}
+
+	return -1;
+}
+
+void FTmorphSpace::blend (int filter, const float * weights, float * dest, int length) const
+{
+	const Filter & filt = _filters[filter];
+
+	if (length > filt.length) {
+		length = filt.length;
+	}
+
+	FTutils::vector_weighted_sum (filt.rows, filt.stride, weights, _presets, dest, length);
+	fromDomain (filt.domain, dest, length);
+}
+
+void FTmorphSpace::toDomain (Domain domain, float * values, int length)
+{
+	int i;
+	
+	switch (domain)
+	{
+	case DOMAIN_DB:
+		for (i=0; i < length; i++) {
+			values[i] = values[i] > 0.0f ? 20.0f * log10f (values[i]) : FT_MORPH_DB_FLOOR;
+			if (values[i] < FT_MORPH_DB_FLOOR) values[i] = FT_MORPH_DB_FLOOR;
+		}
+		break;
+	case DOMAIN_LOG:
+		for (i=0; i < length; i++) {
+			values[i] = logf (values[i] > 1e-6f ? values[i] : 1e-6f);
+		}
+		break;
+	case DOMAIN_LOGFREQ:
+		for (i=0; i < length; i++) {
+			values[i] = logf (1.0f + (values[i] > 0.0f ? values[i] : 0.0f));
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void FTmorphSpace::fromDomain (Domain domain, float * values, int length)
+{
+	int i;
+	// 10^(dB/20) as one exp
+	const float dbscale = (float) (M_LN10 / 20.0);
+	
+	switch (domain)
+	{
+	case DOMAIN_DB:
+		for (i=0; i < length; i++) {
+			values[i] = values[i] <= FT_MORPH_DB_FLOOR + 0.5f ? 0.0f : expf (values[i] * dbscale);
+		}
+		break;
+	case DOMAIN_LOG:
+		for (i=0; i < length; i++) {
+			values[i] = expf (values[i]);
+		}
+		break;
+	case DOMAIN_LOGFREQ:
+		for (i=0; i < length; i++) {
+			values[i] = expf (values[i]) - 1.0f;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void FTmorphSpace::publish (FTmorphSpace * space)
+{
+	FTmorphSpace * old = __sync_lock_test_and_set (&_current, space);
+	// after the space, see acquire()
+	__sync_synchronize();
+	__sync_add_and_fetch (&_version, 1);
+
+	if (old) {
+		_retired.push_back (old);
+	}
+
+	reclaim (false);
+}
+
+void FTmorphSpace::reclaim (bool wait)
+{
+	while (_readers > 0) {
+		if (!wait) return;
+		usleep (500);
+	}
+
+	// anyone acquiring from here on gets _current
+	for (vector<FTmorphSpace *>::iterator iter = _retired.begin(); iter != _retired.end(); ++iter) {
+		delete (*iter);
+	}
+
+	_retired.clear();
+}
@@ -0,0 +1,120 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#ifndef __FTMORPHSPACE_HPP__
+#define __FTMORPHSPACE_HPP__
+
+#include "FTtypes.hpp"
+
+#include <vector>
+using namespace std;
+
+class FTspectrumModifier;
+
+// most presets a morph can span
+#define FT_MAX_MORPH_PRESETS 8
+// gains are blended in dB, this and below is silence
+#define FT_MORPH_DB_FLOOR -90.0f
+
+
+// The presets of a blend packed for morphing.  For every filter the
+// blend covers, each preset's bins are one row of a contiguous block
+// so a morph is just a weighted sum of rows.  The rows are kept in the
+// domain that filter's type sounds even in (dB for gains, log for
+// ratios and frequencies) and blend() maps the sum back, so halfway
+// sounds like halfway.  A space is not changed once it is published,
+// FTpresetBlender builds a new one instead.
+class FTmorphSpace
+{
+  public:
+
+	FTmorphSpace (unsigned int presets);
+	~FTmorphSpace();
+
+	unsigned int getPresetCount() const { return _presets; }
+
+	// The weights of each preset for a spot on the xy pad, both
+	// 0 to 1, summing to 1.  2 presets go left to right, 3 are a
+	// triangle with the third at the top, 4 the corners of the pad
+	// (1 and 2 along the bottom), more are spread around a circle
+	void computeWeights (float x, float y, float * weights) const;
+
+	// adds the live filter target with its rows zeroed, returns its
+	// index.  its modifier type picks the blend domain
+	int addFilter (FTspectrumModifier * target, int length);
+	// fills in a row, resampling values from length bins
+	void setRow (int filter, unsigned int preset, const float * values, int length);
+
+	int findFilter (const FTspectrumModifier * target) const;
+	int getFilterCount() const { return (int) _filters.size(); }
+	FTspectrumModifier * getTarget (int filter) const { return _filters[filter].target; }
+	int getLength (int filter) const { return _filters[filter].length; }
+
+	// dest = the weighted sum of the filter's rows, length bins,
+	// mapped back from its blend domain
+	void blend (int filter, const float * weights, float * dest, int length) const;
+
+	// The space the Preset Morph modulator sees.  publish() hands one
+	// over (0 for none), the audio side brackets its use with
+	// acquire() and release().  reclaim() deletes the replaced ones
+	// once nothing can be using them.  version, if given, changes
+	// with every publish(), a new space can reuse an old one's address
+	static void publish (FTmorphSpace * space);
+	static const FTmorphSpace * acquire (unsigned int * version = 0) {
+		__sync_add_and_fetch (&_readers, 1);
+		if (version) {
+			*version = _version;
+			__sync_synchronize();
+		}
+		return _current;
+	}
+	static void release() { __sync_sub_and_fetch (&_readers, 1); }
+	static void reclaim (bool wait);
+	
+  protected:
+
+	enum Domain {
+		DOMAIN_LINEAR = 0,
+		DOMAIN_DB,      // linear gain as dB
+		DOMAIN_LOG,     // ratios
+		DOMAIN_LOGFREQ  // bin numbers, log (1 + bin)
+	};
+
+	static void toDomain (Domain domain, float * values, int length);
+	static void fromDomain (Domain domain, float * values, int length);
+	
+	struct Filter {
+		FTspectrumModifier * target;
+		Domain domain;
+		int length;
+		// rows start on 16 byte boundaries
+		int stride;
+		float * rows;
+	};
+
+	vector<Filter> _filters;
+	unsigned int _presets;
+
+	static FTmorphSpace * volatile _current;
+	static volatile int _readers;
+	static volatile unsigned int _version;
+	static vector<FTmorphSpace *> _retired;
+};
+
+#endif
@@ -0,0 +1,86 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+/**
+ *  I/O support for tools that only work on presets, no audio
+ */
+
+#ifndef __FTOFFLINESUPPORT_HPP__
+#define __FTOFFLINESUPPORT_HPP__
+
+#include "FTtypes.hpp"
+#include "FTioSupport.hpp"
+
+// what jack reports before it is connected
+#define FT_OFFLINE_SAMPLE_RATE 44100
+
+
+// Has no process paths or ports and never processes, it is only
+// there for the sample rate
+class FTofflineSupport
+	: public FTioSupport
+{
+  public:
+	FTofflineSupport(nframes_t samplerate = FT_OFFLINE_SAMPLE_RATE)
+		: _sampleRate(samplerate) {}
+
+	virtual ~FTofflineSupport() {}
+
+	bool init() { return true; }
+	bool reinit(bool rebuild=true) { return true; }
+	bool isInited() { return true; }
+
+	FTprocessPath * setProcessPathActive(int index, bool flag) { return 0; }
+	FTprocessPath * getProcessPath(int index) { return 0; }
+	int getActivePathCount () { return 0; }
+
+	bool startProcessing() { return false; }
+	bool stopProcessing() { return true; }
+	bool close() { return true; }
+
+    	bool connectPathInput (int index, const char *inname) { return false; }
+        bool connectPathOutput (int index, const char *outname) { return false; }
+    	bool disconnectPathInput (int index, const char *inname) { return false; }
+        bool disconnectPathOutput (int index, const char *outname) { return false; }
+
+	const char ** getConnectedInputPorts(int index) { return 0; }
+	const char ** getConnectedOutputPorts(int index) { return 0; }
+
+	const char ** getInputConnectablePorts(int index) { return 0; }
+	const char ** getOutputConnectablePorts(int index) { return 0; }
+
+	const char ** getPhysicalInputPorts() { return 0; }
+	const char ** getPhysicalOutputPorts() { return 0; }
+
+	const char * getInputPortName(int index) { return ""; }
+	const char * getOutputPortName(int index) { return ""; }
+
+	nframes_t getSampleRate() { return _sampleRate; }
+	nframes_t getTransportFrame() { return 0; }
+	bool getPortsChanged() { return false; }
+
+        void setProcessingBypassed (bool val) {}
+
+  protected:
+
+	nframes_t _sampleRate;
+};
+
+
+#endif
@@ -39,7 +39,10 @@ using namespace std;
 enum {
 	ID_PriPresetCombo=2000,
 	ID_SecPresetCombo,
+	ID_TerPresetCombo,
+	ID_QuaPresetCombo,
 	ID_MasterSlider,
+	ID_MasterYSlider,
 	ID_FilterBlendSlider
 };
 
@@ -52,10 +55,13 @@ BEGIN_EVENT_TABLE(FTpresetBlendDialog, wxFrame)
 	EVT_PAINT (FTpresetBlendDialog::onPaint)
 
 	EVT_COMMAND_SCROLL (ID_MasterSlider, FTpresetBlendDialog::onSliders)
+	EVT_COMMAND_SCROLL (ID_MasterYSlider, FTpresetBlendDialog::onSliders)
 	EVT_COMMAND_SCROLL (ID_FilterBlendSlider, FTpresetBlendDialog::onSliders)
 
 	EVT_COMBOBOX (ID_PriPresetCombo, FTpresetBlendDialog::onCombo)
 	EVT_COMBOBOX (ID_SecPresetCombo, FTpresetBlendDialog::onCombo)
+	EVT_COMBOBOX (ID_TerPresetCombo, FTpresetBlendDialog::onCombo)
+	EVT_COMBOBOX (ID_QuaPresetCombo, FTpresetBlendDialog::onCombo)
 	
 	
 END_EVENT_TABLE()
@@ -146,6 +152,43 @@ void FTpresetBlendDialog::init()
 	comboSizer->Add( tmpsizer, 0, wxALL|wxALIGN_LEFT, 1);
 
 	
+	mainsizer->Add (comboSizer, 0, wxEXPAND|wxALL, 2);
+
+	// optional third and fourth, the blend spans whichever are set
+	comboSizer = new wxBoxSizer(wxHORIZONTAL);
+
+	tmpsizer = new wxBoxSizer(wxVERTICAL);
+	tmpsizer2 = new wxBoxSizer(wxHORIZONTAL);
+	
+	stattext = new wxStaticText(this, -1, wxT("Preset 3: "), wxDefaultPosition, wxSize(-1, -1));
+	tmpsizer2->Add(stattext, 0, wxALL|wxEXPAND, 1);
+
+	_terStatus = new wxStaticText(this, -1, wxT("not set"), wxDefaultPosition, wxSize(-1, -1));
+	tmpsizer2->Add(_terStatus, 0, wxALL, 1);
+	tmpsizer->Add (tmpsizer2, 0, wxALL|wxEXPAND, 1);
+	
+	_terPresetBox = new wxComboBox (this, ID_TerPresetCombo, wxT(""),  wxDefaultPosition, wxSize(175,-1), 0, 0, wxCB_READONLY|wxCB_SORT);
+	tmpsizer->Add( _terPresetBox, 0, wxALL|wxEXPAND|wxALIGN_LEFT, 1);
+	
+	comboSizer->Add( tmpsizer, 0, wxALL|wxALIGN_LEFT, 1);
+
+	comboSizer->Add(1,-1,1);
+
+	tmpsizer = new wxBoxSizer(wxVERTICAL);
+	tmpsizer2 = new wxBoxSizer(wxHORIZONTAL);
+	
+	stattext = new wxStaticText(this, -1, wxT("Preset 4: "), wxDefaultPosition, wxSize(-1, -1));
+	tmpsizer2->Add(stattext, 0, wxALL|wxEXPAND, 1);
+
+	_quaStatus = new wxStaticText(this, -1, wxT("not set"), wxDefaultPosition, wxSize(-1, -1));
+	tmpsizer2->Add(_quaStatus, 0, wxALL|wxEXPAND, 1);
+	tmpsizer->Add (tmpsizer2, 0, wxALL|wxEXPAND, 1);
+	
+	_quaPresetBox = new wxComboBox (this, ID_QuaPresetCombo, wxT(""),  wxDefaultPosition, wxSize(175,-1),  0, 0, wxCB_READONLY|wxCB_SORT);
+	tmpsizer->Add( _quaPresetBox, 0, wxALL|wxEXPAND|wxALIGN_LEFT, 1);
+
+	comboSizer->Add( tmpsizer, 0, wxALL|wxALIGN_LEFT, 1);
+
 	mainsizer->Add (comboSizer, 0, wxEXPAND|wxALL, 2);
 
 	tmpsizer = new wxBoxSizer(wxHORIZONTAL);
@@ -157,6 +200,16 @@ void FTpresetBlendDialog::init()
 	_masterBlend = new wxSlider(this, ID_MasterSlider, 0, 0, 1000);
 	tmpsizer->Add (_masterBlend, 1, wxALL|wxALIGN_CENTRE_VERTICAL, 3);
 	
+	mainsizer->Add (tmpsizer, 0, wxEXPAND|wxALL, 5);
+
+	tmpsizer = new wxBoxSizer(wxHORIZONTAL);
+	stattext = new wxStaticText(this, -1, wxT("Master Y"), wxDefaultPosition, wxSize(_namewidth, -1));
+	stattext->SetSize(_namewidth, -1);
+	
+	tmpsizer->Add (stattext, 0, wxALL|wxALIGN_CENTRE_VERTICAL, 1);
+	_masterY = new wxSlider(this, ID_MasterYSlider, 0, 0, 1000);
+	tmpsizer->Add (_masterY, 1, wxALL|wxALIGN_CENTRE_VERTICAL, 3);
+	
 	mainsizer->Add (tmpsizer, 0, wxEXPAND|wxALL, 5);
 	mainsizer->Add (2,5);
 
@@ -206,14 +259,20 @@ void FTpresetBlendDialog::refreshState(const wxString & defname, bool usefirst,
 
 	wxString origfirst = _priPresetBox->GetValue();
 	wxString origsec = _secPresetBox->GetValue();
+	wxString origter = _terPresetBox->GetValue();
+	wxString origqua = _quaPresetBox->GetValue();
 
 	_priPresetBox->Clear();
 	_secPresetBox->Clear();
+	_terPresetBox->Clear();
+	_quaPresetBox->Clear();
 
 	for (list<string>::iterator name=presetlist.begin(); name != presetlist.end(); ++name)
 	{
 		_priPresetBox->Append(wxString::FromAscii ((*name).c_str()));
 		_secPresetBox->Append(wxString::FromAscii ((*name).c_str()));
+		_terPresetBox->Append(wxString::FromAscii ((*name).c_str()));
+		_quaPresetBox->Append(wxString::FromAscii ((*name).c_str()));
 	}
 
 	_priPresetBox->SetValue(defname.c_str());
@@ -272,45 +331,35 @@ void FTpresetBlendDialog::refreshState(const wxString & defname, bool usefirst,
 	_procSizer->Layout();
 	
 	// try to load them up
-	if (usefirst) {
-		if (_presetBlender->setPreset (static_cast<const char *> (defname.mb_str()), 0)) {
-			_priPresetBox->SetValue (wxString(defname.c_str()));
-			_priStatus->SetLabel (wxT("ready"));
-		}
-		else {
-			_priStatus->SetLabel (wxT("not set or invalid"));
-		}
-	}
-	else {
-		if (_presetBlender->setPreset (static_cast<const char *> (origfirst.mb_str()), 0)) {
-			_priPresetBox->SetValue (origfirst);
-			_priStatus->SetLabel (wxT("ready"));
-		}
-		else {
-			_priStatus->SetLabel (wxT("not set or invalid"));
-		}
-	}
-	
-	if (usesec) {
-		if (_presetBlender->setPreset (static_cast<const char *> (defsec.mb_str()), 1)) {
-			_secPresetBox->SetValue (wxString(defsec.c_str()));
-			_secStatus->SetLabel (wxT("ready"));
-		}
-		else {
-			_secStatus->SetLabel (wxT("not set or invalid"));
-		}
-		
-	}
-	else {
-		if (_presetBlender->setPreset (static_cast<const char *> (origsec.mb_str()), 1)) {
-			_secPresetBox->SetValue (origsec);
-			_secStatus->SetLabel (wxT("ready"));
-		}
-		else {
-			_secStatus->SetLabel (wxT("not set or invalid"));
-		}
+	setPresetSlot (0, _priPresetBox, _priStatus, usefirst ? defname : origfirst);
+	setPresetSlot (1, _secPresetBox, _secStatus, usesec ? defsec : origsec);
+	setPresetSlot (2, _terPresetBox, _terStatus, origter);
+	setPresetSlot (3, _quaPresetBox, _quaStatus, origqua);
+}
+
+bool FTpresetBlendDialog::setPresetSlot (int index, wxComboBox * box, wxStaticText * status, const wxString & name)
+{
+	if (_presetBlender->setPreset (static_cast<const char *> (name.mb_str()), index)) {
+		box->SetValue (name);
+		status->SetLabel (name.empty() ? wxT("not set") : wxT("ready"));
+		return true;
 	}
-	
+
+	// display error message
+	printf ("error could not load preset %s\n", static_cast<const char *> (name.mb_str()));
+	box->SetSelection(-1);
+	box->SetValue(wxT(""));
+	status->SetLabel (wxT("not set or invalid"));
+
+	return false;
+}
+
+float FTpresetBlendDialog::getSliderPos (wxSlider * slider)
+{
+	float max = (float) slider->GetMax();
+	float min = (float) slider->GetMin(); 
+
+	return (slider->GetValue() - min) / (max - min);
 }
 
 
@@ -331,44 +380,25 @@ void FTpresetBlendDialog::onClose(wxCloseEvent & ev)
 
 void FTpresetBlendDialog::onCombo(wxCommandEvent &ev)
 {
-	if (ev.GetId() == ID_PriPresetCombo) {
-
-		wxString name = _priPresetBox->GetStringSelection();
+	wxComboBox * box = (wxComboBox *) ev.GetEventObject();
+	wxString name = box->GetStringSelection();
 
-		if (!name.empty()) {
-
-			if (!_presetBlender->setPreset(static_cast<const char *> (name.mb_str()), 0)) {
-				// display error message
-				printf ("error could not load preset %s\n", static_cast<const char *> (name.mb_str()));
-				_priPresetBox->SetSelection(-1);
-				_priPresetBox->SetValue(wxT(""));
-				_priStatus->SetLabel (wxT("not set or invalid"));
-
-			}
-			else {
-				_priStatus->SetLabel (wxT("ready"));
-			}
-		}
+	if (name.empty()) {
+		return;
+	}
+	
+	if (ev.GetId() == ID_PriPresetCombo) {
+		setPresetSlot (0, _priPresetBox, _priStatus, name);
 	}
 	else if (ev.GetId() == ID_SecPresetCombo) {
-
-		wxString name = _secPresetBox->GetStringSelection();
-
-		if (!name.empty()) {
-
-			if (!_presetBlender->setPreset(static_cast<const char *> (name.mb_str()), 1)) {
-				// display error message
-				printf ("error could not load preset %s\n", static_cast<const char *> (name.mb_str()));
-				_secPresetBox->SetSelection(-1);
-				_secPresetBox->SetValue(wxT(""));
-				_secStatus->SetLabel (wxT("not set or invalid"));
-			}
-			else {
-				_secStatus->SetLabel (wxT("ready"));
-			}
-		}
+		setPresetSlot (1, _secPresetBox, _secStatus, name);
+	}
+	else if (ev.GetId() == ID_TerPresetCombo) {
+		setPresetSlot (2, _terPresetBox, _terStatus, name);
+	}
+	else if (ev.GetId() == ID_QuaPresetCombo) {
+		setPresetSlot (3, _quaPresetBox, _quaStatus, name);
 	}
-
 }
 
 
@@ -381,32 +411,34 @@ void FTpresetBlendDialog::onSliders(wxScrollEvent &ev)
 	static bool ignoreevent = false;
 
 	if (ignoreevent) return;
+
+	// x along the sliders, y from Master Y for every filter
+	float ypos = getSliderPos (_masterY);
 	
 	for (unsigned int i=0; i < _blendSliders.size(); ++i)
 	{
 		if (_masterBlend == source) {
 			ProcPair & ppair = _blendPairs[i];
 
-			float max = (float) _masterBlend->GetMax();
-			float min = (float) _masterBlend->GetMin(); 
-			float newval = (((float)_masterBlend->GetValue() - min) / (max-min));
-				
-			_presetBlender->setBlend (ppair.first, ppair.second, 1.0 - newval);
+			_presetBlender->setPosition (ppair.first, ppair.second, getSliderPos (_masterBlend), ypos);
 
 			ignoreevent = true;
 			_blendSliders[i]->SetValue(_masterBlend->GetValue());
 			
 			updateall = true;
 		}
+		else if (_masterY == source) {
+			ProcPair & ppair = _blendPairs[i];
+
+			_presetBlender->setPosition (ppair.first, ppair.second, getSliderPos (_blendSliders[i]), ypos);
+
+			updateall = true;
+		}
 		else if (_blendSliders[i] == source) {
 
 			ProcPair & ppair = _blendPairs[i];
 
-			float max = (float) _blendSliders[i]->GetMax();
-			float min = (float) _blendSliders[i]->GetMin(); 
-			float newval = ((_blendSliders[i]->GetValue() - min) / (max-min));
-				
-			_presetBlender->setBlend (ppair.first, ppair.second, 1.0 - newval);
+			_presetBlender->setPosition (ppair.first, ppair.second, getSliderPos (_blendSliders[i]), ypos);
 
 			_mainwin->updateGraphs(0, _filtRefs[i]->getSpecModifierType());
 				
@@ -422,4 +454,3 @@ void FTpresetBlendDialog::onSliders(wxScrollEvent &ev)
 		}
 	}
 }
-
@@ -65,17 +65,28 @@ class FTpresetBlendDialog
 
 	void onSliders(wxScrollEvent &ev);
 	void onCombo(wxCommandEvent &ev);
+
+	// loads name into blender slot index, showing how it went
+	bool setPresetSlot (int index, wxComboBox * box, wxStaticText * status, const wxString & name);
+	// a slider as 0 to 1
+	float getSliderPos (wxSlider * slider);
 	
 	wxBoxSizer * _procSizer;
 	wxWindow * _procPanel;
 	
 	wxComboBox * _priPresetBox;
 	wxComboBox * _secPresetBox;
+	wxComboBox * _terPresetBox;
+	wxComboBox * _quaPresetBox;
 
 	wxStaticText * _priStatus;
 	wxStaticText * _secStatus;
+	wxStaticText * _terStatus;
+	wxStaticText * _quaStatus;
 	
 	wxSlider *    _masterBlend;
+	// y of the morph for every filter, with 3 or 4 presets
+	wxSlider *    _masterY;
 	vector<wxSlider*> _blendSliders;
 
 	typedef pair<unsigned int, unsigned int> ProcPair; 
@@ -26,7 +26,7 @@
 #include "FTspectrumModifier.hpp"
 
 FTpresetBlender::FTpresetBlender(FTconfigManager * confman)
-	: _configMan(confman)
+	: _space(0), _configMan(confman)
 {
 	// add two elements both intially null
 	_presetList.push_back(0);
@@ -38,6 +38,11 @@ FTpresetBlender::FTpresetBlender(FTconfigManager * confman)
 
 FTpresetBlender::~FTpresetBlender()
 {
+	// the modulator can't be using it once this returns
+	FTmorphSpace::publish (0);
+	FTmorphSpace::reclaim (true);
+	_space = 0;
+	
 	for (unsigned int n=0; n < _presetList.size(); ++n) {
 
 		if (_presetList[n]) {
@@ -55,15 +60,26 @@ bool FTpresetBlender::setPreset(const string & name, int index)
 	// try to load it up and compare the resulting FTprocs to the
 	// currently active ones
 
-	if (index >= (int) _presetList.size()) {
+	if (index < 0 || index >= FT_MAX_MORPH_PRESETS) {
 		return false;
 	}
 
+	while (index >= (int) _presetList.size()) {
+		_presetList.push_back(0);
+		_presetNames.push_back("");
+	}
+	
 	// delete old one no matter what
 	if (_presetList[index]) {
 		delete _presetList[index];
 		_presetList[index] = 0;
 	}
+	_presetNames[index] = "";
+
+	if (name.empty()) {
+		rebuildSpace();
+		return true;
+	}
 	
 	vector<vector <FTprocI *> > * procvec = new vector<vector<FTprocI*> > ();
 		
@@ -71,6 +87,7 @@ bool FTpresetBlender::setPreset(const string & name, int index)
 
 	if (!succ) {
 		delete procvec;
+		rebuildSpace();
 		return false;
 	}
 	
@@ -78,6 +95,7 @@ bool FTpresetBlender::setPreset(const string & name, int index)
 
 	if ((int)procvec->size() != iosup->getActivePathCount()) {
 		delete procvec;
+		rebuildSpace();
 		return false;
 	}
 	
@@ -86,6 +104,7 @@ bool FTpresetBlender::setPreset(const string & name, int index)
 		FTprocessPath * procpath = iosup->getProcessPath(i);
 		if (!procpath) {
 			delete procvec;
+			rebuildSpace();
 			return false; // shouldnt happen
 
 		}
@@ -102,8 +121,9 @@ bool FTpresetBlender::setPreset(const string & name, int index)
 			// compare the proctype
 
 			if (pvec.size() <= n ||  pm->getName() != pvec[n]->getName()) {
-				fprintf (stderr, "mismatch at %d %d: %s   %u\n", i, n, pm->getName().c_str(), pvec.size());
+				fprintf (stderr, "mismatch at %d %d: %s   %u\n", i, n, pm->getName().c_str(), (unsigned int) pvec.size());
 				delete procvec;
+				rebuildSpace();
 				return false;
 			}
 		}
@@ -113,86 +133,211 @@ bool FTpresetBlender::setPreset(const string & name, int index)
 
 	_presetList[index]  = procvec;
 	_presetNames[index] = name;
+
+	rebuildSpace();
 	
 	return true;
 }
 
 string FTpresetBlender::getPreset(int index)
 {
-	if (index < (int) _presetNames.size()) {
+	if (index >= 0 && index < (int) _presetNames.size()) {
 		return _presetNames[index];
 	}
 
 	return "";
 }
 
-bool FTpresetBlender::setBlend (unsigned int specmod_n, unsigned int filt_n, float val)
+unsigned int FTpresetBlender::getPresetCount()
 {
-	// for the given filter given by specmod_n, filt_n, set the ratio to use
-	// and adjust the active filters accordingly
-	// TODO: support more than 2 presets
+	return _space ? _space->getPresetCount() : 0;
+}
 
-	// Assume that both proc lists have the same structure
+void FTpresetBlender::rebuildSpace()
+{
+	vector<vector<vector <FTprocI *> > *> presets;
 
-	if (!_presetList[0] || !_presetList[1]) {
-		return false;
+	for (unsigned int n=0; n < _presetList.size(); ++n) {
+		if (_presetList[n]) {
+			presets.push_back (_presetList[n]);
+		}
 	}
 
+	if (presets.empty()) {
+		_space = 0;
+		FTmorphSpace::publish (0);
+		return;
+	}
+	
 	FTioSupport * iosup = FTioSupport::instance();
+	FTmorphSpace * space = new FTmorphSpace (presets.size());
 	
-	vector<vector <FTprocI *> > * procvec0 = _presetList[0];
-	vector<vector <FTprocI *> > * procvec1 = _presetList[1];
-
-	for (unsigned int chan=0; chan < procvec0->size(); ++chan)
+	for (int chan=0; chan < iosup->getActivePathCount(); ++chan)
 	{
-		vector<FTprocI*> & procvec0_p = (*procvec0)[chan];
-		vector<FTprocI*> & procvec1_p = (*procvec1)[chan];
-
-		FTprocessPath * procpath = iosup->getProcessPath((int) chan);
+		FTprocessPath * procpath = iosup->getProcessPath(chan);
 		if (!procpath) continue; // shouldnt happen
-		
-		FTspectralEngine *engine = procpath->getSpectralEngine();
+
 		vector<FTprocI *> procmods;
-		engine->getProcessorModules (procmods);
+		procpath->getSpectralEngine()->getProcessorModules (procmods);
 
-		
-		if (specmod_n < procvec0_p.size() && specmod_n < procvec1_p.size()
-			&& specmod_n < procmods.size())
+		for (unsigned int modpos=0; modpos < procmods.size(); ++modpos)
 		{
-			FTspectrumModifier * targFilt = procmods[specmod_n]->getFilter(filt_n);
-			FTspectrumModifier * filt0 = procvec0_p[specmod_n]->getFilter(filt_n);
-			FTspectrumModifier * filt1 = procvec1_p[specmod_n]->getFilter(filt_n);
-
-			if (targFilt && filt0 && filt1)
+			FTspectrumModifier * target;
+			
+			for (unsigned int filt=0; (target = procmods[modpos]->getFilter(filt)) != 0; ++filt)
 			{
-				// do the blend
-				blendFilters (targFilt, filt0, filt1, val);
+				int idx = space->addFilter (target, target->getLength());
+
+				for (unsigned int p=0; p < presets.size(); ++p)
+				{
+					vector<vector <FTprocI *> > & procvec = *presets[p];
+					FTspectrumModifier * pfilt = 0;
+					
+					if ((unsigned int) chan < procvec.size() && modpos < procvec[chan].size()) {
+						pfilt = procvec[chan][modpos]->getFilter(filt);
+					}
+
+					// the chain changed since, hold that one where it is
+					if (!pfilt) pfilt = target;
+					
+					int length = 0;
+					const float * values = pfilt->getSourceValues (length);
+					space->setRow (idx, p, values, length);
+				}
 			}
 		}
 	}
+
+	_space = space;
+	FTmorphSpace::publish (space);
+}
+
+bool FTpresetBlender::setPosition (unsigned int specmod_n, unsigned int filt_n, float x, float y)
+{
+	if (!_space) {
+		return false;
+	}
+
+	float weights[FT_MAX_MORPH_PRESETS];
+	_space->computeWeights (x, y, weights);
+
+	_positions[FilterPos(specmod_n, filt_n)] = pair<float,float> (x, y);
 	
+	return blendFilters (specmod_n, filt_n, weights);
+}
+
+bool FTpresetBlender::setPosition (float x, float y)
+{
+	if (!_space) {
+		return false;
+	}
 
+	// every filter of channel 1, the others match it
+	FTprocessPath * procpath = FTioSupport::instance()->getProcessPath(0);
+	if (!procpath) {
+		return false;
+	}
 	
+	vector<FTprocI *> procmods;
+	procpath->getSpectralEngine()->getProcessorModules (procmods);
+
+	for (unsigned int modpos=0; modpos < procmods.size(); ++modpos)
+	{
+		for (unsigned int filt=0; procmods[modpos]->getFilter(filt); ++filt)
+		{
+			setPosition (modpos, filt, x, y);
+		}
+	}
+
 	return true;
 }
 
+bool FTpresetBlender::setWeights (unsigned int specmod_n, unsigned int filt_n, const vector<float> & weights)
+{
+	if (!_space) {
+		return false;
+	}
+
+	unsigned int presets = _space->getPresetCount();
+	float norm[FT_MAX_MORPH_PRESETS];
+	float sum = 0.0f;
+	
+	for (unsigned int n=0; n < presets; ++n) {
+		norm[n] = (n < weights.size() && weights[n] > 0.0f) ? weights[n] : 0.0f;
+		sum += norm[n];
+	}
+
+	if (sum <= 0.0f) {
+		return false;
+	}
+
+	for (unsigned int n=0; n < presets; ++n) {
+		norm[n] /= sum;
+	}
+	
+	return blendFilters (specmod_n, filt_n, norm);
+}
+
+bool FTpresetBlender::setBlend (unsigned int specmod_n, unsigned int filt_n, float val)
+{
+	// val is the weight of the first, along the bottom edge of the pad
+	// or wherever the filter's y was left
+	float y = 0.0f;
+
+	map<FilterPos, pair<float,float> >::iterator pos = _positions.find (FilterPos(specmod_n, filt_n));
+	if (pos != _positions.end()) {
+		y = pos->second.second;
+	}
+	
+	return setPosition (specmod_n, filt_n, 1.0f - val, y);
+}
+
 float FTpresetBlender::getBlend (unsigned int specmod_n, unsigned int filt_n)
 {
+	map<FilterPos, pair<float,float> >::iterator pos = _positions.find (FilterPos(specmod_n, filt_n));
 
+	if (pos != _positions.end()) {
+		return 1.0f - pos->second.first;
+	}
+	
 	return 0.0;
 }
 
-void FTpresetBlender::blendFilters (FTspectrumModifier * targFilt, FTspectrumModifier *filt0, FTspectrumModifier *filt1, float val)
+bool FTpresetBlender::blendFilters (unsigned int specmod_n, unsigned int filt_n, const float * weights)
 {
+	FTioSupport * iosup = FTioSupport::instance();
+	bool blended = false;
+	
+	for (int chan=0; chan < iosup->getActivePathCount(); ++chan)
+	{
+		FTprocessPath * procpath = iosup->getProcessPath(chan);
+		if (!procpath) continue; // shouldnt happen
+		
+		vector<FTprocI *> procmods;
+		procpath->getSpectralEngine()->getProcessorModules (procmods);
 
-	float * targvals = targFilt->getValues();
-	float * filt0vals = filt0->getValues();
-	float * filt1vals = filt1->getValues();
+		if (specmod_n >= procmods.size()) continue;
 
+		FTspectrumModifier * targFilt = procmods[specmod_n]->getFilter(filt_n);
+		if (!targFilt) continue;
 
-	for (int i=0; i < targFilt->getLength(); ++i)
-	{
-		targvals[i] = val*filt0vals[i] + (1.0-val)*filt1vals[i];
+		int idx = _space->findFilter (targFilt);
+
+		if (idx >= 0 && _space->getLength(idx) != targFilt->getLength()) {
+			// the fft size changed under us
+			rebuildSpace();
+			idx = _space->findFilter (targFilt);
+		}
+
+		if (idx < 0) continue;
+		
+		// the blend goes over to the audio thread in one piece
+		float * targvals = targFilt->beginEdit();
+		_space->blend (idx, weights, targvals, targFilt->getLength());
+		targFilt->commitEdit();
+
+		blended = true;
 	}
-}
 
+	return blended;
+}
@@ -26,12 +26,18 @@
 #include <string>
 #include <list>
 #include <vector>
+#include <map>
 using namespace std;
 
+#include "FTmorphSpace.hpp"
+
 class FTprocI;
 class FTconfigManager;
 class FTspectrumModifier;
 
+// Morphs the active filters between up to FT_MAX_MORPH_PRESETS
+// presets.  The preset filters are packed into an FTmorphSpace, which
+// is also published for the Preset Morph modulator to run at hop rate
 class FTpresetBlender
 {
    public:
@@ -40,24 +46,41 @@ class FTpresetBlender
 	virtual ~FTpresetBlender();
 	
 
+	// an empty name clears that slot
 	bool setPreset(const string & name, int index);
 	string getPreset(int index);
+	// the presets set, in slot order, that the morph spans
+	unsigned int getPresetCount();
+
+	// a spot on the xy pad (see FTmorphSpace::computeWeights()) for
+	// one filter or all of them
+	bool setPosition (unsigned int specmod_n, unsigned int filt_n, float x, float y);
+	bool setPosition (float x, float y);
+	// or the weights of each preset directly, normalized here
+	bool setWeights (unsigned int specmod_n, unsigned int filt_n, const vector<float> & weights);
 
+	// for two presets, val is the weight of the first
 	bool setBlend (unsigned int specmod_n, unsigned int filt_n, float val);
 	float getBlend (unsigned int specmod_n, unsigned int filt_n);
 	
    protected:
 
-	void blendFilters (FTspectrumModifier * targFilt, FTspectrumModifier *filt0, FTspectrumModifier *filt1, float val);
+	// repacks the presets against the active filters and publishes
+	void rebuildSpace();
+	// blends every channel's filter specmod_n, filt_n with weights
+	bool blendFilters (unsigned int specmod_n, unsigned int filt_n, const float * weights);
 	
 
 	vector <vector<vector <FTprocI*> > *> _presetList;
 
 	vector <string> _presetNames;
+
+	FTmorphSpace * _space;
+
+	typedef pair<unsigned int, unsigned int> FilterPos;
+	map<FilterPos, pair<float,float> > _positions;
 	
 	FTconfigManager * _configMan;
-
-	FTpresetBlender * _presetBlender;
 };
 
 #endif
@@ -0,0 +1,341 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string>
+#include <list>
+#include <vector>
+
+#include <wx/wx.h>
+
+#include "FTpresetBrowser.hpp"
+#include "FTmainwin.hpp"
+#include "FTconfigManager.hpp"
+
+using namespace std;
+
+enum {
+	ID_SearchText=8000,
+	ID_PresetList,
+	ID_TagsText,
+	ID_TagsButton,
+	ID_LoadButton
+};
+
+
+BEGIN_EVENT_TABLE(FTpresetBrowser, wxFrame)
+	EVT_CLOSE(FTpresetBrowser::onClose)
+
+	EVT_TEXT(ID_SearchText, FTpresetBrowser::onSearch)
+	EVT_LISTBOX(ID_PresetList, FTpresetBrowser::onSelect)
+	EVT_LISTBOX_DCLICK(ID_PresetList, FTpresetBrowser::onLoad)
+
+	EVT_TEXT_ENTER(ID_TagsText, FTpresetBrowser::onTags)
+	EVT_BUTTON(ID_TagsButton, FTpresetBrowser::onTags)
+	EVT_BUTTON(ID_LoadButton, FTpresetBrowser::onLoad)
+
+END_EVENT_TABLE()
+
+
+FTpresetBrowser::FTpresetBrowser(FTmainwin * parent, wxWindowID id,
+				 const wxString & title,
+				 const wxPoint& pos,
+				 const wxSize& size,
+				 long style,
+				 const wxString& name )
+
+	: wxFrame(parent, id, title, pos, size, style, name),
+	  _mainwin(parent)
+{
+
+	init();
+}
+
+FTpresetBrowser::~FTpresetBrowser()
+{
+}
+
+void FTpresetBrowser::init()
+{
+	wxBoxSizer * mainsizer = new wxBoxSizer(wxHORIZONTAL);
+
+	// search and the list
+	wxBoxSizer * listSizer = new wxBoxSizer(wxVERTICAL);
+	wxBoxSizer * rowsizer = new wxBoxSizer(wxHORIZONTAL);
+	wxStaticText * stattext;
+
+	stattext = new wxStaticText(this, -1, wxT("Search"), wxDefaultPosition, wxDefaultSize);
+	rowsizer->Add (stattext, 0, wxALL|wxALIGN_CENTRE_VERTICAL, 2);
+
+	_searchText = new wxTextCtrl(this, ID_SearchText, wxT(""), wxDefaultPosition, wxDefaultSize);
+	_searchText->SetToolTip(wxT("Name, tag or module, any case"));
+	rowsizer->Add (_searchText, 1, wxALL|wxALIGN_CENTRE_VERTICAL, 2);
+
+	listSizer->Add (rowsizer, 0, wxEXPAND|wxALL, 0);
+
+	_presetList = new wxListBox(this, ID_PresetList, wxDefaultPosition, wxSize(160,-1), 0, 0, wxLB_SINGLE|wxLB_SORT);
+	listSizer->Add (_presetList, 1, wxEXPAND|wxALL, 2);
+
+	mainsizer->Add (listSizer, 0, wxEXPAND|wxALL, 4);
+
+
+	// what is in the selected one
+	wxBoxSizer * infoSizer = new wxBoxSizer(wxVERTICAL);
+
+	_infoText = new wxStaticText(this, -1, wxT(""), wxDefaultPosition, wxDefaultSize);
+	infoSizer->Add (_infoText, 0, wxEXPAND|wxALL, 2);
+
+	_preview = new FTpresetPreview(this, -1, wxDefaultPosition, wxSize(300,200));
+	infoSizer->Add (_preview, 1, wxEXPAND|wxALL, 2);
+
+	rowsizer = new wxBoxSizer(wxHORIZONTAL);
+
+	stattext = new wxStaticText(this, -1, wxT("Tags"), wxDefaultPosition, wxDefaultSize);
+	rowsizer->Add (stattext, 0, wxALL|wxALIGN_CENTRE_VERTICAL, 2);
+
+	_tagsText = new wxTextCtrl(this, ID_TagsText, wxT(""), wxDefaultPosition, wxDefaultSize, wxTE_PROCESS_ENTER);
+	_tagsText->SetToolTip(wxT("Comma separated"));
+	rowsizer->Add (_tagsText, 1, wxALL|wxALIGN_CENTRE_VERTICAL, 2);
+
+	wxButton * butt = new wxButton(this, ID_TagsButton, wxT("Set"));
+	rowsizer->Add (butt, 0, wxALL|wxALIGN_CENTRE_VERTICAL, 2);
+
+	butt = new wxButton(this, ID_LoadButton, wxT("Load"));
+	rowsizer->Add (butt, 0, wxALL|wxALIGN_CENTRE_VERTICAL, 2);
+
+	infoSizer->Add (rowsizer, 0, wxEXPAND|wxALL, 0);
+
+	mainsizer->Add (infoSizer, 1, wxEXPAND|wxALL, 4);
+
+
+	refreshState();
+
+	SetAutoLayout( TRUE );
+	mainsizer->Fit( this );
+	mainsizer->SetSizeHints( this );
+	SetSizer( mainsizer );
+
+	this->SetSizeHints(300,200);
+}
+
+void FTpresetBrowser::refreshState()
+{
+	FTconfigManager & confman = _mainwin->getConfigManager();
+	std::string text (_searchText->GetValue().mb_str());
+	wxString selected = _presetList->GetStringSelection();
+
+	list<string> names = text.empty() ? confman.getSettingsNames() : confman.searchSettings (text);
+
+	_presetList->Clear();
+
+	for (list<string>::iterator name = names.begin(); name != names.end(); ++name) {
+		_presetList->Append (wxString::FromAscii (name->c_str()));
+	}
+
+	int found = selected.IsEmpty() ? -1 : _presetList->FindString (selected);
+	if (found >= 0) {
+		_presetList->SetSelection (found);
+		showEntry (confman.getSettingsInfo (std::string (selected.mb_str())));
+	}
+	else {
+		showEntry (0);
+	}
+}
+
+void FTpresetBrowser::showEntry (const FTpresetIndex::Entry * entry)
+{
+	_preview->setEntry (entry);
+
+	if (!entry) {
+		_infoText->SetLabel (wxT(""));
+		_tagsText->SetValue (wxT(""));
+		return;
+	}
+
+	wxString info = wxString::Format (wxT("%d ch, %d bins:"), entry->channels, entry->fft_size / 2);
+	for (unsigned int n=0; n < entry->chain.size(); ++n) {
+		info += wxT(" ") + wxString::FromAscii (entry->chain[n].c_str());
+	}
+	_infoText->SetLabel (info);
+
+	wxString tags;
+	for (unsigned int n=0; n < entry->tags.size(); ++n) {
+		tags += (n ? wxT(", ") : wxT("")) + wxString::FromAscii (entry->tags[n].c_str());
+	}
+	_tagsText->SetValue (tags);
+}
+
+void FTpresetBrowser::onClose(wxCloseEvent & ev)
+{
+	if (!ev.CanVeto()) {
+		Destroy();
+	}
+	else {
+		ev.Veto();
+		Show(false);
+	}
+}
+
+void FTpresetBrowser::onSearch(wxCommandEvent & ev)
+{
+	refreshState();
+}
+
+void FTpresetBrowser::onSelect(wxCommandEvent & ev)
+{
+	std::string name (_presetList->GetStringSelection().mb_str());
+
+	showEntry (name.empty() ? 0 : _mainwin->getConfigManager().getSettingsInfo (name));
+}
+
+void FTpresetBrowser::onLoad(wxCommandEvent & ev)
+{
+	wxString name = _presetList->GetStringSelection();
+
+	if (!name.IsEmpty()) {
+		_mainwin->loadPreset (name);
+	}
+}
+
+void FTpresetBrowser::onTags(wxCommandEvent & ev)
+{
+	std::string name (_presetList->GetStringSelection().mb_str());
+	if (name.empty()) return;
+
+	std::string text (_tagsText->GetValue().mb_str());
+	vector<string> tags;
+	string::size_type pos = 0;
+
+	while (pos <= text.size()) {
+		string::size_type comma = text.find (',', pos);
+		if (comma == string::npos) comma = text.size();
+
+		string tag = text.substr (pos, comma - pos);
+		string::size_type first = tag.find_first_not_of (" \t");
+		string::size_type last = tag.find_last_not_of (" \t");
+		if (first != string::npos) {
+			tags.push_back (tag.substr (first, last - first + 1));
+		}
+
+		pos = comma + 1;
+	}
+
+	_mainwin->getConfigManager().setSettingsTags (name, tags);
+
+	// it may not match the search anymore
+	refreshState();
+}
+
+
+// @@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@@
+
+BEGIN_EVENT_TABLE(FTpresetPreview, wxPanel)
+	EVT_PAINT(FTpresetPreview::onPaint)
+	EVT_SIZE(FTpresetPreview::onSize)
+END_EVENT_TABLE()
+
+FTpresetPreview::FTpresetPreview (wxWindow * parent, wxWindowID id,
+				  const wxPoint& pos, const wxSize& size)
+	: wxPanel(parent, id, pos, size, wxSUNKEN_BORDER)
+{
+	SetBackgroundColour(*wxBLACK);
+
+	_bgBrush.SetColour(wxColour(30,50,30));
+	_bgBrush.SetStyle(wxSOLID);
+
+	_linePen.SetColour(wxColour(0,200,240));
+	_linePen.SetStyle(wxSOLID);
+
+	_gridPen.SetColour(wxColour(70,80,70));
+	_gridPen.SetStyle(wxSOLID);
+}
+
+void FTpresetPreview::setEntry (const FTpresetIndex::Entry * entry)
+{
+	_entry = entry ? *entry : FTpresetIndex::Entry();
+	Refresh(FALSE);
+}
+
+void FTpresetPreview::onSize(wxSizeEvent &ev)
+{
+	Refresh(FALSE);
+	ev.Skip();
+}
+
+void FTpresetPreview::onPaint(wxPaintEvent &ev)
+{
+	wxPaintDC dc(this);
+
+	int width, height;
+	GetClientSize(&width, &height);
+
+	dc.SetBackground(*wxBLACK_BRUSH);
+	dc.Clear();
+
+	int count = (int) _entry.curves.size();
+	if (count == 0 || width < 2) return;
+
+	// a strip each, scaled to its own range since the filters
+	// don't share units
+	int striph = height / count;
+	if (striph < 4) return;
+
+	wxPoint points[FT_INDEX_CURVE_BINS];
+
+	for (int c=0; c < count; ++c)
+	{
+		const FTpresetIndex::Curve & curve = _entry.curves[c];
+		int top = c * striph;
+
+		dc.SetPen(*wxTRANSPARENT_PEN);
+		dc.SetBrush(_bgBrush);
+		dc.DrawRectangle(0, top + 1, width, striph - 2);
+
+		if (curve.values.size() != FT_INDEX_CURVE_BINS) continue;
+
+		float minval = curve.values[0], maxval = curve.values[0];
+		for (unsigned int n=1; n < curve.values.size(); ++n) {
+			if (curve.values[n] < minval) minval = curve.values[n];
+			if (curve.values[n] > maxval) maxval = curve.values[n];
+		}
+		float range = maxval - minval;
+
+		for (int n=0; n < FT_INDEX_CURVE_BINS; ++n) {
+			// a flat one goes through the middle
+			float pos = range > 0.0f ? (curve.values[n] - minval) / range : 0.5f;
+			points[n].x = n * (width - 1) / (FT_INDEX_CURVE_BINS - 1);
+			points[n].y = top + striph - 3 - (int) (pos * (striph - 6));
+		}
+
+		dc.SetPen(_gridPen);
+		dc.DrawLine(0, top + striph / 2, width, top + striph / 2);
+
+		dc.SetPen(_linePen);
+		dc.DrawLines(FT_INDEX_CURVE_BINS, points);
+
+		if (curve.modpos < _entry.chain.size()) {
+			dc.SetTextForeground(*wxWHITE);
+			dc.DrawText(wxString::FromAscii (_entry.chain[curve.modpos].c_str())
+				    + wxString::Format (wxT(" %u"), curve.filtpos + 1), 3, top + 1);
+		}
+	}
+}
@@ -0,0 +1,107 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#ifndef __FTPRESETBROWSER_HPP__
+#define __FTPRESETBROWSER_HPP__
+
+
+#include <wx/wx.h>
+
+#include "FTtypes.hpp"
+#include "FTpresetIndex.hpp"
+
+class FTmainwin;
+class FTpresetPreview;
+
+
+// Lists and searches the presets from the preset index, shows what
+// is in them and the thumbnails of their filters, and edits their
+// tags, none of it loading the presets
+class FTpresetBrowser : public wxFrame
+{
+  public:
+	// ctor(s)
+	FTpresetBrowser(FTmainwin * parent, wxWindowID id, const wxString& title,
+			const wxPoint& pos = wxDefaultPosition,
+			const wxSize& size = wxSize(520,360),
+			long style = wxDEFAULT_FRAME_STYLE,
+			const wxString& name = wxT("PresetBrowser"));
+
+	virtual ~FTpresetBrowser();
+
+	// lists them again, for when presets were stored
+	void refreshState();
+
+ protected:
+
+	void init();
+
+	void onClose(wxCloseEvent & ev);
+	void onSearch(wxCommandEvent & ev);
+	void onSelect(wxCommandEvent & ev);
+	void onLoad(wxCommandEvent & ev);
+	void onTags(wxCommandEvent & ev);
+
+	// of the selected one, 0 if none
+	void showEntry (const FTpresetIndex::Entry * entry);
+
+	wxTextCtrl * _searchText;
+	wxListBox * _presetList;
+	wxStaticText * _infoText;
+	wxTextCtrl * _tagsText;
+	FTpresetPreview * _preview;
+
+	FTmainwin * _mainwin;
+
+private:
+	// any class wishing to process wxWindows events must use this macro
+	DECLARE_EVENT_TABLE()
+
+};
+
+
+// draws an index entry's curves, one strip each
+class FTpresetPreview : public wxPanel
+{
+  public:
+	FTpresetPreview (wxWindow * parent, wxWindowID id,
+			 const wxPoint& pos = wxDefaultPosition,
+			 const wxSize& size = wxDefaultSize);
+
+	// copies what it draws, 0 to clear it
+	void setEntry (const FTpresetIndex::Entry * entry);
+
+  protected:
+
+	void onPaint(wxPaintEvent &ev);
+	void onSize(wxSizeEvent &ev);
+
+	FTpresetIndex::Entry _entry;
+
+	wxBrush _bgBrush;
+	wxPen _linePen;
+	wxPen _gridPen;
+
+private:
+	// any class wishing to process wxWindows events must use this macro
+	DECLARE_EVENT_TABLE()
+};
+
+
+#endif
@@ -0,0 +1,288 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "FTpresetFile.hpp"
+
+#define FT_PRESET_BYTEORDER 0x01020304
+
+// bins start on 16 byte boundaries so they can be used in place
+static inline uint32_t align16 (uint32_t off) { return (off + 15) & ~15u; }
+
+
+FTpresetFile::FTpresetFile()
+	: _map(0), _mapsize(0)
+{
+}
+
+FTpresetFile::~FTpresetFile()
+{
+	close();
+}
+
+void FTpresetFile::addFilter (unsigned int chan, unsigned int modpos, unsigned int filtpos,
+			      const float * values, unsigned int length)
+{
+	FilterEntry entry;
+	entry.chan = chan;
+	entry.modpos = modpos;
+	entry.filtpos = filtpos;
+	entry.length = length;
+	// relative to the first bins until written
+	entry.offset = _data.size() * sizeof(float);
+	_filters.push_back (entry);
+
+	_data.insert (_data.end(), values, values + length);
+	// keep the next one aligned
+	_data.resize (align16 (_data.size() * sizeof(float)) / sizeof(float), 0.0f);
+}
+
+bool FTpresetFile::write (const string & path)
+{
+	Header header;
+	memset (&header, 0, sizeof(header));
+	memcpy (header.magic, FT_PRESET_MAGIC, sizeof(header.magic));
+	header.version = FT_PRESET_VERSION;
+	header.byteorder = FT_PRESET_BYTEORDER;
+	header.config_offset = sizeof(Header);
+	header.config_size = _config.size();
+	header.table_offset = align16 (header.config_offset + header.config_size);
+	header.filter_count = _filters.size();
+
+	uint32_t dataoff = align16 (header.table_offset + _filters.size() * sizeof(FilterEntry));
+
+	vector<FilterEntry> table (_filters);
+	for (unsigned int n=0; n < table.size(); ++n) {
+		table[n].offset += dataoff;
+	}
+
+	// into a temporary first, a crash leaves the old file whole and
+	// anyone who has it mapped keeps reading the old one
+	string tmppath = path + ".tmp";
+	
+	FILE * out = fopen (tmppath.c_str(), "wb");
+	if (!out) {
+		fprintf (stderr, "Error opening %s for writing: %s\n", tmppath.c_str(), strerror(errno));
+		return false;
+	}
+
+	static const char zeros[16] = { 0 };
+	bool ok = fwrite (&header, sizeof(header), 1, out) == 1;
+	ok = ok && fwrite (_config.data(), 1, _config.size(), out) == _config.size();
+	ok = ok && fwrite (zeros, 1, header.table_offset - header.config_offset - header.config_size, out)
+		== header.table_offset - header.config_offset - header.config_size;
+	if (!table.empty()) {
+		ok = ok && fwrite (&table[0], sizeof(FilterEntry), table.size(), out) == table.size();
+	}
+	uint32_t pad = dataoff - header.table_offset - table.size() * sizeof(FilterEntry);
+	ok = ok && fwrite (zeros, 1, pad, out) == pad;
+	if (!_data.empty()) {
+		ok = ok && fwrite (&_data[0], sizeof(float), _data.size(), out) == _data.size();
+	}
+	
+	// on disk before it replaces anything
+	ok = ok && fflush (out) == 0 && fsync (fileno (out)) == 0;
+	
+	if (fclose (out) != 0) {
+		ok = false;
+	}
+
+	if (ok && rename (tmppath.c_str(), path.c_str()) != 0) {
+		ok = false;
+	}
+
+	// the rename only lasts once the directory is written
+	ok = ok && syncDirectory (path);
+	
+	if (!ok) {
+		fprintf (stderr, "Error writing %s: %s\n", path.c_str(), strerror(errno));
+		unlink (tmppath.c_str());
+	}
+	
+	return ok;
+}
+
+bool FTpresetFile::syncDirectory (const string & path)
+{
+	string::size_type slash = path.rfind ('/');
+	string dirpath = slash == string::npos ? "." : (slash == 0 ? "/" : path.substr (0, slash));
+	
+	int fd = ::open (dirpath.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	bool ok = fsync (fd) == 0;
+	
+	if (::close (fd) != 0) {
+		ok = false;
+	}
+
+	return ok;
+}
+
+uint32_t FTpresetFile::checksum() const
+{
+	// FNV-1a
+	uint32_t sum = 2166136261u;
+	const unsigned char * bytes = (const unsigned char *) _config.data();
+	size_t n, len = _config.size();
+
+	for (n=0; n < len; ++n) {
+		sum = (sum ^ bytes[n]) * 16777619u;
+	}
+
+	bytes = _data.empty() ? 0 : (const unsigned char *) &_data[0];
+	len = _data.size() * sizeof(float);
+	
+	for (n=0; n < len; ++n) {
+		sum = (sum ^ bytes[n]) * 16777619u;
+	}
+	
+	return sum;
+}
+
+bool FTpresetFile::open (const string & path)
+{
+	close();
+	
+	int fd = ::open (path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		fprintf (stderr, "Error opening %s: %s\n", path.c_str(), strerror(errno));
+		return false;
+	}
+
+	struct stat st;
+	if (fstat (fd, &st) < 0 || st.st_size < (off_t) sizeof(Header)) {
+		fprintf (stderr, "%s is not a preset file\n", path.c_str());
+		::close (fd);
+		return false;
+	}
+
+	_mapsize = st.st_size;
+	_map = mmap (0, _mapsize, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close (fd);
+
+	if (_map == MAP_FAILED) {
+		fprintf (stderr, "Error mapping %s: %s\n", path.c_str(), strerror(errno));
+		_map = 0;
+		_mapsize = 0;
+		return false;
+	}
+
+	const char * base = (const char *) _map;
+	Header header;
+	memcpy (&header, base, sizeof(header));
+
+	if (memcmp (header.magic, FT_PRESET_MAGIC, sizeof(header.magic)) != 0
+	    || header.byteorder != FT_PRESET_BYTEORDER)
+	{
+		fprintf (stderr, "%s is not a preset file for this machine\n", path.c_str());
+		close();
+		return false;
+	}
+
+	if (header.version > FT_PRESET_VERSION) {
+		fprintf (stderr, "%s is from a newer version (format %u)\n", path.c_str(), header.version);
+		close();
+		return false;
+	}
+	
+	if ((uint64_t) header.config_offset + header.config_size > _mapsize
+	    || (uint64_t) header.table_offset + (uint64_t) header.filter_count * sizeof(FilterEntry) > _mapsize)
+	{
+		fprintf (stderr, "%s is truncated\n", path.c_str());
+		close();
+		return false;
+	}
+
+	_config.assign (base + header.config_offset, header.config_size);
+
+	_filters.resize (header.filter_count);
+	if (header.filter_count) {
+		memcpy (&_filters[0], base + header.table_offset, header.filter_count * sizeof(FilterEntry));
+	}
+	
+	for (unsigned int n=0; n < _filters.size(); ++n) {
+		const FilterEntry & entry = _filters[n];
+		if ((entry.offset & 3) || (uint64_t) entry.offset + (uint64_t) entry.length * sizeof(float) > _mapsize) {
+			fprintf (stderr, "%s has a bad filter entry\n", path.c_str());
+			close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void FTpresetFile::close()
+{
+	if (_map) {
+		munmap (_map, _mapsize);
+		_map = 0;
+		_mapsize = 0;
+	}
+
+	_config.clear();
+	_filters.clear();
+	_data.clear();
+}
+
+const float * FTpresetFile::getFilter (unsigned int chan, unsigned int modpos, unsigned int filtpos,
+				       unsigned int & length) const
+{
+	// only a few dozen of them
+	for (unsigned int n=0; n < _filters.size(); ++n) {
+		const FilterEntry & entry = _filters[n];
+		if (entry.chan == chan && entry.modpos == modpos && entry.filtpos == filtpos) {
+			length = entry.length;
+			if (_map) {
+				return (const float *) ((const char *) _map + entry.offset);
+			}
+			// added, not written yet
+			return &_data[entry.offset / sizeof(float)];
+		}
+	}
+
+	return 0;
+}
+
+bool FTpresetFile::isPresetFile (const string & path)
+{
+	char magic[8];
+	FILE * in = fopen (path.c_str(), "rb");
+	if (!in) return false;
+
+	bool ours = fread (magic, 1, sizeof(magic), in) == sizeof(magic)
+		&& memcmp (magic, FT_PRESET_MAGIC, sizeof(magic)) == 0;
+	fclose (in);
+
+	return ours;
+}
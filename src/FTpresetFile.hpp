@@ -0,0 +1,107 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#ifndef __FTPRESETFILE_HPP__
+#define __FTPRESETFILE_HPP__
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+using namespace std;
+
+// magic and current version of the binary preset format
+#define FT_PRESET_MAGIC "FTPRESET"
+#define FT_PRESET_VERSION 1
+// file name extension
+#define FT_PRESET_EXT ".ftp"
+
+// A whole preset in one binary file: a header, the config xml (what
+// config.xml holds in the directory format, minus the filter files),
+// a table of filters and their bins as raw float32 arrays.  Reading
+// maps the file, getFilter() points straight into it.
+class FTpresetFile
+{
+  public:
+
+	struct FilterEntry {
+		uint32_t chan;
+		uint32_t modpos;
+		uint32_t filtpos;
+		uint32_t length;  // bins
+		uint32_t offset;  // of the bins from the start of the file
+	};
+	
+	FTpresetFile();
+	~FTpresetFile();
+
+	// writing
+	void setConfig (const string & xml) { _config = xml; }
+	void addFilter (unsigned int chan, unsigned int modpos, unsigned int filtpos,
+			const float * values, unsigned int length);
+	// goes to path.tmp and is renamed over path once it is all on
+	// disk, so path always holds a whole preset
+	bool write (const string & path);
+	// of what would be written, to tell if anything changed
+	uint32_t checksum() const;
+
+	// reading, the file stays mapped until close() or destruction
+	bool open (const string & path);
+	void close();
+
+	const string & getConfig() const { return _config; }
+
+	unsigned int getFilterCount() const { return _filters.size(); }
+	const FilterEntry & getFilterEntry (unsigned int n) const { return _filters[n]; }
+	
+	// 0 if the preset has no such filter.  works for added filters
+	// before writing too
+	const float * getFilter (unsigned int chan, unsigned int modpos, unsigned int filtpos,
+				 unsigned int & length) const;
+
+	// true if path starts like one of ours
+	static bool isPresetFile (const string & path);
+	// fsyncs the directory path is in, so a rename into it is on
+	// disk too
+	static bool syncDirectory (const string & path);
+	
+  protected:
+
+	struct Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t byteorder; // 0x01020304 as written
+		uint32_t config_offset;
+		uint32_t config_size;
+		uint32_t table_offset;
+		uint32_t filter_count;
+	};
+
+	string _config;
+	vector<FilterEntry> _filters;
+
+	// bins of added filters, until written
+	vector<float> _data;
+
+	void * _map;
+	size_t _mapsize;
+};
+
+#endif
@@ -0,0 +1,542 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <sstream>
+#include <algorithm>
+
+#include "FTpresetIndex.hpp"
+#include "FTpresetFile.hpp"
+#include "xml++.hpp"
+
+using namespace std;
+
+static const XMLNode * findChild (const XMLNode * node, const string & name)
+{
+	const XMLNodeList & nlist = node->children();
+
+	for (XMLNodeConstIterator niter = nlist.begin(); niter != nlist.end(); ++niter) {
+		if ((*niter)->name() == name) {
+			return *niter;
+		}
+	}
+
+	return 0;
+}
+
+static string getProp (const XMLNode * node, const string & name)
+{
+	const XMLProperty * prop = node->property (name);
+	return prop ? prop->value() : string();
+}
+
+static void splitList (const string & str, char sep, vector<string> & out)
+{
+	string::size_type start = 0, end;
+
+	while (start < str.size()) {
+		end = str.find (sep, start);
+		if (end == string::npos) end = str.size();
+		if (end > start) {
+			out.push_back (str.substr (start, end - start));
+		}
+		start = end + 1;
+	}
+}
+
+static string joinList (const vector<string> & in, char sep)
+{
+	string str;
+	for (unsigned int n=0; n < in.size(); ++n) {
+		if (n) str += sep;
+		str += in[n];
+	}
+	return str;
+}
+
+static string lowered (const string & str)
+{
+	string low (str);
+	for (string::size_type n=0; n < low.size(); ++n) {
+		low[n] = tolower (low[n]);
+	}
+	return low;
+}
+
+
+FTpresetIndex::FTpresetIndex (const string & presetdir, const string & indexpath)
+	: _presetDir (presetdir), _indexPath (indexpath), _dirMtime(0), _dirty(false)
+{
+}
+
+bool FTpresetIndex::load()
+{
+	struct stat st;
+	if (stat (_indexPath.c_str(), &st) != 0) {
+		return false;
+	}
+	
+	XMLTree indexdoc (_indexPath);
+	const XMLNode * rootNode = indexdoc.root();
+
+	if (!indexdoc.initialized() || !rootNode || rootNode->name() != "PresetIndex") {
+		fprintf (stderr, "Ignoring bad preset index %s\n", _indexPath.c_str());
+		return false;
+	}
+
+	_entries.clear();
+	_dirMtime = (time_t) strtol (getProp (rootNode, "dir_mtime").c_str(), 0, 10);
+	
+	XMLNodeList nlist = rootNode->children ("Preset");
+
+	for (XMLNodeConstIterator niter = nlist.begin(); niter != nlist.end(); ++niter)
+	{
+		const XMLNode * presetNode = *niter;
+		Entry entry;
+
+		entry.name = getProp (presetNode, "name");
+		if (entry.name.empty()) continue;
+		
+		entry.mtime = (time_t) strtol (getProp (presetNode, "mtime").c_str(), 0, 10);
+		entry.channels = atoi (getProp (presetNode, "channels").c_str());
+		entry.fft_size = atoi (getProp (presetNode, "fft_size").c_str());
+		splitList (getProp (presetNode, "chain"), ',', entry.chain);
+		splitList (getProp (presetNode, "tags"), ',', entry.tags);
+
+		XMLNodeList clist = presetNode->children ("Curve");
+		for (XMLNodeConstIterator citer = clist.begin(); citer != clist.end(); ++citer)
+		{
+			Curve curve;
+			curve.modpos = atoi (getProp (*citer, "modpos").c_str());
+			curve.filtpos = atoi (getProp (*citer, "filtpos").c_str());
+
+			string values = getProp (*citer, "values");
+			const char * str = values.c_str();
+			char * end;
+			
+			for (float val = strtof (str, &end); end != str; val = strtof (str, &end)) {
+				curve.values.push_back (val);
+				str = end;
+			}
+			
+			entry.curves.push_back (curve);
+		}
+
+		_entries[entry.name] = entry;
+	}
+
+	_dirty = false;
+	return true;
+}
+
+string FTpresetIndex::serialize()
+{
+	XMLNode * rootNode = new XMLNode ("PresetIndex");
+	char buf[32];
+
+	snprintf (buf, sizeof(buf), "%ld", (long) _dirMtime);
+	rootNode->add_property ("dir_mtime", buf);
+	
+	for (map<string, Entry>::iterator iter = _entries.begin(); iter != _entries.end(); ++iter)
+	{
+		const Entry & entry = iter->second;
+		XMLNode * presetNode = rootNode->add_child ("Preset");
+
+		presetNode->add_property ("name", entry.name);
+		snprintf (buf, sizeof(buf), "%ld", (long) entry.mtime);
+		presetNode->add_property ("mtime", buf);
+		snprintf (buf, sizeof(buf), "%d", entry.channels);
+		presetNode->add_property ("channels", buf);
+		snprintf (buf, sizeof(buf), "%d", entry.fft_size);
+		presetNode->add_property ("fft_size", buf);
+		presetNode->add_property ("chain", joinList (entry.chain, ','));
+		presetNode->add_property ("tags", joinList (entry.tags, ','));
+
+		for (vector<Curve>::const_iterator citer = entry.curves.begin(); citer != entry.curves.end(); ++citer)
+		{
+			XMLNode * curveNode = presetNode->add_child ("Curve");
+			
+			snprintf (buf, sizeof(buf), "%u", citer->modpos);
+			curveNode->add_property ("modpos", buf);
+			snprintf (buf, sizeof(buf), "%u", citer->filtpos);
+			curveNode->add_property ("filtpos", buf);
+
+			string values;
+			for (unsigned int n=0; n < citer->values.size(); ++n) {
+				snprintf (buf, sizeof(buf), n ? " %.4g" : "%.4g", citer->values[n]);
+				values += buf;
+			}
+			curveNode->add_property ("values", values);
+		}
+	}
+
+	XMLTree indexdoc;
+	indexdoc.set_root (rootNode);
+	_dirty = false;
+
+	return indexdoc.write_buffer();
+}
+
+void FTpresetIndex::scan()
+{
+	struct stat st;
+	if (stat (_presetDir.c_str(), &st) != 0) {
+		return;
+	}
+
+	if (st.st_mtime == _dirMtime) {
+		// nothing added or removed
+		return;
+	}
+	
+	DIR * dir = opendir (_presetDir.c_str());
+	if (!dir) {
+		return;
+	}
+
+	map<string, Entry> found;
+	struct dirent * dent;
+	const string ext (FT_PRESET_EXT);
+	
+	while ((dent = readdir (dir)) != 0)
+	{
+		string fname (dent->d_name);
+		string name;
+
+		if (fname[0] == '.') continue;
+		
+		if (fname.size() > ext.size() && fname.compare (fname.size() - ext.size(), ext.size(), ext) == 0) {
+			name = fname.substr (0, fname.size() - ext.size());
+		}
+		else {
+			// directories from older versions
+			struct stat fst;
+			if (stat ((_presetDir + "/" + fname).c_str(), &fst) != 0 || !S_ISDIR (fst.st_mode)) continue;
+			name = fname;
+		}
+
+		map<string, Entry>::iterator iter = _entries.find (name);
+		if (iter != _entries.end()) {
+			found[name] = iter->second;
+		}
+		else {
+			// filled in when asked for
+			found[name].name = name;
+		}
+	}
+
+	closedir (dir);
+
+	for (map<string, Entry>::iterator iter = _entries.begin(); iter != _entries.end(); ++iter) {
+		if (iter->second.unwritten && found.find (iter->first) == found.end()) {
+			found[iter->first] = iter->second;
+		}
+	}
+	
+	_entries.swap (found);
+	// a change later in the same second wouldn't move it, so look again next time
+	_dirMtime = st.st_mtime < time(0) ? st.st_mtime : 0;
+	_dirty = true;
+}
+
+void FTpresetIndex::getNames (list<string> & names)
+{
+	scan();
+
+	for (map<string, Entry>::iterator iter = _entries.begin(); iter != _entries.end(); ++iter) {
+		names.push_back (iter->first);
+	}
+}
+
+void FTpresetIndex::fillEntry (Entry & entry, const XMLNode * rootNode, const FTpresetFile * file)
+{
+	vector<string> tags;
+	
+	entry.channels = 0;
+	entry.fft_size = 0;
+	entry.chain.clear();
+	entry.curves.clear();
+	
+	splitList (getProp (rootNode, "tags"), ',', tags);
+	if (!tags.empty()) {
+		entry.tags = tags;
+	}
+	
+	const XMLNode * paramsNode = findChild (rootNode, "Params");
+	if (paramsNode) {
+		entry.fft_size = atoi (getProp (paramsNode, "fft_size").c_str());
+	}
+
+	const XMLNode * channelsNode = findChild (rootNode, "Channels");
+	if (!channelsNode) {
+		return;
+	}
+	
+	XMLNodeList chanlist = channelsNode->children ("Channel");
+	entry.channels = chanlist.size();
+
+	if (chanlist.empty()) {
+		return;
+	}
+	
+	const XMLNode * procmodsNode = findChild (chanlist.front(), "ProcMods");
+	if (!procmodsNode) {
+		return;
+	}
+
+	XMLNodeList pmlist = procmodsNode->children ("ProcMod");
+	unsigned int modpos = 0;
+	
+	for (XMLNodeConstIterator pmiter = pmlist.begin(); pmiter != pmlist.end(); ++pmiter, ++modpos)
+	{
+		entry.chain.push_back (getProp (*pmiter, "name"));
+
+		if (!file) continue;
+		
+		XMLNodeList filtlist = (*pmiter)->children ("Filter");
+		for (unsigned int filtpos=0; filtpos < filtlist.size(); ++filtpos)
+		{
+			addCurve (entry, modpos, filtpos, file);
+		}
+	}
+}
+
+void FTpresetIndex::fillEntry (Entry & entry, XMLReader & reader, const FTpresetFile * file)
+{
+	vector<string> tags;
+	string value;
+	
+	entry.channels = 0;
+	entry.fft_size = 0;
+	entry.chain.clear();
+	entry.curves.clear();
+
+	if (reader.property ("tags", value)) {
+		splitList (value, ',', tags);
+	}
+	if (!tags.empty()) {
+		entry.tags = tags;
+	}
+
+	int rootdepth = reader.depth();
+	
+	while (reader.next_child (rootdepth))
+	{
+		if (reader.name() == "Params") {
+			if (reader.property ("fft_size", value)) {
+				entry.fft_size = atoi (value.c_str());
+			}
+			continue;
+		}
+		else if (reader.name() != "Channels") {
+			continue;
+		}
+
+		int chansdepth = reader.depth();
+		
+		while (reader.next_child (chansdepth))
+		{
+			// only the first channel's chain
+			if (reader.name() != "Channel" || entry.channels++ > 0) continue;
+
+			int chandepth = reader.depth();
+
+			while (reader.next_child (chandepth))
+			{
+				if (reader.name() != "ProcMods") continue;
+
+				int pmsdepth = reader.depth();
+				unsigned int modpos = 0;
+				
+				while (reader.next_child (pmsdepth))
+				{
+					if (reader.name() != "ProcMod") continue;
+
+					entry.chain.push_back (reader.property ("name", value) ? value : string());
+
+					int pmdepth = reader.depth();
+					unsigned int filtpos = 0;
+					
+					while (reader.next_child (pmdepth))
+					{
+						if (reader.name() == "Filter" && file) {
+							addCurve (entry, modpos, filtpos++, file);
+						}
+					}
+					++modpos;
+				}
+			}
+		}
+	}
+}
+
+void FTpresetIndex::addCurve (Entry & entry, unsigned int modpos, unsigned int filtpos, const FTpresetFile * file)
+{
+	unsigned int length;
+	const float * values = file->getFilter (0, modpos, filtpos, length);
+	if (!values || length == 0) return;
+
+	Curve curve;
+	curve.modpos = modpos;
+	curve.filtpos = filtpos;
+	curve.values.resize (FT_INDEX_CURVE_BINS);
+
+	// average each run of bins
+	for (unsigned int n=0; n < FT_INDEX_CURVE_BINS; ++n) {
+		unsigned int start = n * length / FT_INDEX_CURVE_BINS;
+		unsigned int end = (n + 1) * length / FT_INDEX_CURVE_BINS;
+		if (end <= start) end = start + 1;
+		if (end > length) end = length;
+
+		float sum = 0.0f;
+		for (unsigned int i=start; i < end; ++i) {
+			sum += values[i];
+		}
+		curve.values[n] = sum / (end - start);
+	}
+	
+	entry.curves.push_back (curve);
+}
+
+void FTpresetIndex::update (const string & name, const XMLNode * root, const FTpresetFile & file)
+{
+	Entry & entry = _entries[name];
+
+	entry.name = name;
+	fillEntry (entry, root, &file);
+	// the file isn't written yet, its time is taken on the next refresh
+	entry.mtime = 0;
+	entry.unwritten = true;
+	_dirty = true;
+}
+
+bool FTpresetIndex::refresh (Entry & entry)
+{
+	struct stat st;
+	string path = _presetDir + "/" + entry.name + FT_PRESET_EXT;
+	bool binary = true;
+	
+	if (stat (path.c_str(), &st) != 0) {
+		path = _presetDir + "/" + entry.name;
+		binary = false;
+		
+		if (stat (path.c_str(), &st) != 0 || !S_ISDIR (st.st_mode)) {
+			// still on its way, or gone
+			return entry.unwritten;
+		}
+	}
+
+	if (entry.unwritten) {
+		// filled in by update(), this is the file it wrote
+		entry.unwritten = false;
+		entry.mtime = st.st_mtime;
+		_dirty = true;
+		return true;
+	}
+	
+	if (entry.mtime == st.st_mtime) {
+		return true;
+	}
+	
+	// streamed through, a scan reads a lot of these
+	FTpresetFile file;
+	XMLReader reader;
+	
+	if (binary) {
+		if (!file.open (path) || !reader.open_buffer (file.getConfig()) || !reader.next_child (-1)) {
+			return false;
+		}
+		fillEntry (entry, reader, &file);
+	}
+	else {
+		if (!reader.open (path + "/config.xml") || !reader.next_child (-1)) {
+			return false;
+		}
+		// no curves from the text filter files
+		fillEntry (entry, reader, 0);
+	}
+
+	entry.mtime = st.st_mtime;
+	_dirty = true;
+	
+	return true;
+}
+
+const FTpresetIndex::Entry * FTpresetIndex::lookup (const string & name)
+{
+	map<string, Entry>::iterator iter = _entries.find (name);
+
+	if (iter == _entries.end()) {
+		scan();
+		iter = _entries.find (name);
+		if (iter == _entries.end()) {
+			return 0;
+		}
+	}
+	
+	if (!refresh (iter->second)) {
+		return 0;
+	}
+
+	return &iter->second;
+}
+
+void FTpresetIndex::search (const string & text, list<string> & names)
+{
+	string low = lowered (text);
+
+	scan();
+	
+	for (map<string, Entry>::iterator iter = _entries.begin(); iter != _entries.end(); ++iter)
+	{
+		Entry & entry = iter->second;
+		bool match = lowered (entry.name).find (low) != string::npos;
+
+		if (!match && refresh (entry))
+		{
+			for (unsigned int n=0; !match && n < entry.tags.size(); ++n) {
+				match = lowered (entry.tags[n]).find (low) != string::npos;
+			}
+			for (unsigned int n=0; !match && n < entry.chain.size(); ++n) {
+				match = lowered (entry.chain[n]).find (low) != string::npos;
+			}
+		}
+
+		if (match) {
+			names.push_back (entry.name);
+		}
+	}
+}
+
+void FTpresetIndex::setTags (const string & name, const vector<string> & tags)
+{
+	map<string, Entry>::iterator iter = _entries.find (name);
+
+	if (iter != _entries.end()) {
+		iter->second.tags = tags;
+		_dirty = true;
+	}
+}
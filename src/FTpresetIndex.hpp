@@ -0,0 +1,118 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#ifndef __FTPRESETINDEX_HPP__
+#define __FTPRESETINDEX_HPP__
+
+#include <ctime>
+
+#include <string>
+#include <list>
+#include <map>
+#include <vector>
+using namespace std;
+
+class XMLNode;
+class XMLReader;
+class FTpresetFile;
+
+// bins in an index curve
+#define FT_INDEX_CURVE_BINS 32
+
+
+// What the preset browser needs to know about every preset without
+// loading them, kept in one file next to the presets directory.
+// Entries are filled in from the preset being stored, or read from
+// the preset file the first time they are asked for after it changed
+// on disk.  The directory itself is only listed again when its
+// modification time moves
+class FTpresetIndex
+{
+  public:
+
+	// the first channel's filter modpos, filtpos, averaged down to
+	// FT_INDEX_CURVE_BINS
+	struct Curve {
+		unsigned int modpos;
+		unsigned int filtpos;
+		vector<float> values;
+	};
+	
+	struct Entry {
+		Entry() : mtime(0), unwritten(false), channels(0), fft_size(0) {}
+		
+		string name;
+		// of the preset as indexed, 0 to read it again
+		time_t mtime;
+		// from update(), its file is still being written
+		bool unwritten;
+		int channels;
+		int fft_size;
+		// config names of the first channel's modules, in order
+		vector<string> chain;
+		vector<string> tags;
+		vector<Curve> curves;
+	};
+	
+	// presetdir holds the presets, the index is kept in indexpath
+	FTpresetIndex (const string & presetdir, const string & indexpath);
+
+	// reads the index file, false if there wasn't a usable one
+	bool load();
+	// the index file contents, for writing out
+	string serialize();
+	const string & getPath() const { return _indexPath; }
+	// anything changed since the last serialize()
+	bool isDirty() const { return _dirty; }
+	
+	// all presets, sorted
+	void getNames (list<string> & names);
+
+	// fills in name's entry from a preset being stored
+	void update (const string & name, const XMLNode * root, const FTpresetFile & file);
+
+	// 0 if there is no such preset
+	const Entry * lookup (const string & name);
+
+	// presets whose name, tags or modules contain text, any case
+	void search (const string & text, list<string> & names);
+
+	void setTags (const string & name, const vector<string> & tags);
+	
+  protected:
+
+	void scan();
+	// (re)reads an entry from its preset, false if it is gone
+	bool refresh (Entry & entry);
+	static void fillEntry (Entry & entry, const XMLNode * root, const FTpresetFile * file);
+	// the same from a reader on the root element, reading it through
+	static void fillEntry (Entry & entry, XMLReader & reader, const FTpresetFile * file);
+	// the thumbnail of the first channel's filter at modpos, filtpos
+	static void addCurve (Entry & entry, unsigned int modpos, unsigned int filtpos, const FTpresetFile * file);
+
+	string _presetDir;
+	string _indexPath;
+
+	map<string, Entry> _entries;
+	// of the presets directory as last listed, 0 to list it again
+	time_t _dirMtime;
+	bool _dirty;
+};
+
+#endif
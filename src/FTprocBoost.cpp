@@ -41,6 +41,9 @@ void FTprocBoost::initialize()
 	
 	_filterlist.push_back (_eqfilter);
 
+	FTspectrumModifier::reserveRanges (_storedRanges);
+	FTspectrumModifier::reserveRanges (_ranges);
+	
 	_inited = true;
 }
 
@@ -52,28 +55,61 @@ FTprocBoost::~FTprocBoost()
 	delete _eqfilter;
 }
 
+bool FTprocBoost::computeIdentity()
+{
+	if (_eqfilter->getBypassed()) {
+		return true;
+	}
+
+	return (_eqfilter->getActiveRanges (1.0, _storedRanges) == 0);
+}
+
+void FTprocBoost::viewChanged()
+{
+	FTspectrumModifier::Reader filter (_eqfilter);
+	filter.mapRanges (_storedRanges, _ranges);
+}
+
 void FTprocBoost::process (fft_data *data, unsigned int fftn)
 {
-	if (!_inited || _eqfilter->getBypassed()) {
+	if (isIdentity()) {
 		return;
 	}
 
+	int fftN2 = (fftn+1) >> 1;
 	
-	float *filter = _eqfilter->getValues();
+	processBins (data, fftn, 0, fftN2-1);
+}
+
+void FTprocBoost::processBins (fft_data *data, unsigned int fftn, int start, int end)
+{
+	FTspectrumModifier::Reader filter (_eqfilter);
 	float min = _eqfilter->getMin();
 	float max = _eqfilter->getMax();
 	float filt;
 
-	int fftN2 = (fftn+1) >> 1;
+	int rstart, rend;
 
-	filt = FTutils::f_clamp(filter[0], min, max);
-	data[0] *=  filt;
-	
-	for (int i = 1; i < fftN2-1; i++)
+	for (unsigned int r = 0; r < _ranges.size(); r++)
 	{
-		filt = FTutils::f_clamp(filter[i], min, max);
+		if (_ranges[r].end <= start) continue;
+		if (_ranges[r].start >= end) break;
+		
+		rstart = _ranges[r].start > start ? _ranges[r].start : start;
+		rend = _ranges[r].end < end ? _ranges[r].end : end;
+
+		if (rstart == 0) {
+			filt = FTutils::f_clamp (filter[0], min, max);
+			data[0] *= filt;
+			rstart = 1;
+		}
 		
-		data[i] *=  filt;
-		data[fftn-i] *=  filt;
+		for (int i = rstart; i < rend; i++)
+		{
+			filt = FTutils::f_clamp (filter[i], min, max);
+			
+			data[i] *=  filt;
+			data[fftn-i] *=  filt;
+		}
 	}
 }
@@ -37,12 +37,22 @@ class FTprocBoost
 	
 	void process (fft_data *data,  unsigned int fftn);
 
+	bool isFusible() { return true; }
+	void processBins (fft_data *data, unsigned int fftn, int start, int end);
+
 	virtual bool useAsDefault() { return false; }
 	
   protected:
 
+	bool computeIdentity();
+	void viewChanged();
+	
 	FTspectrumModifier * _eqfilter;
 
+	// bins that are not unity gain, as stored and as rotated
+	FTspectrumModifier::RangeList _storedRanges;
+	FTspectrumModifier::RangeList _ranges;
+
 };
 
 #endif
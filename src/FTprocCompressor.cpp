@@ -146,6 +146,11 @@ void FTprocCompressor::initialize()
 	for (unsigned int i=1; i<A_TBL; i++) {
 		_as[i] = expf(-1.0f / ((_sampleRate/(_oversamp*(float)_fftN)) * (float)i / (float)A_TBL));
 	}
+
+	FTspectrumModifier::reserveRanges (_ratioRanges);
+	FTspectrumModifier::reserveRanges (_makeupRanges);
+	FTspectrumModifier::reserveRanges (_tmpRanges);
+	FTspectrumModifier::reserveRanges (_ranges);
 	
 	_inited = true;
 }
@@ -224,17 +229,50 @@ FTprocCompressor::~FTprocCompressor()
 	delete _makeup_filter;
 }
 
+bool FTprocCompressor::computeIdentity()
+{
+	if (_thresh_filter->getBypassed()) {
+		return true;
+	}
+
+	// with a ratio of 1 the gain settles at unity, so only the bins
+	// with real ratios or makeup gain need any work
+	int covered = _ratio_filter->getActiveRanges (1.0, _ratioRanges);
+	covered += _makeup_filter->getActiveRanges (0.0, _makeupRanges);
+
+	return (covered == 0);
+}
+
+void FTprocCompressor::viewChanged()
+{
+	FTspectrumModifier::Reader ratio (_ratio_filter);
+	FTspectrumModifier::Reader makeup (_makeup_filter);
+	
+	ratio.mapRanges (_ratioRanges, _ranges);
+	makeup.mapRanges (_makeupRanges, _tmpRanges);
+
+	_ranges.insert (_ranges.end(), _tmpRanges.begin(), _tmpRanges.end());
+	FTspectrumModifier::mergeRanges (_ranges);
+}
+
 void FTprocCompressor::process (fft_data *data, unsigned int fftn)
 {
-	if (!_inited || _thresh_filter->getBypassed()) {
+	if (isIdentity()) {
 		return;
 	}
 	
-	float *threshold = _thresh_filter->getValues();
-	float *ratio = _ratio_filter->getValues();
-	float *attack = _attack_filter->getValues();
-	float *release = _release_filter->getValues();
-	float *makeup = _makeup_filter->getValues();
+	int fftN2 = (fftn+1) >> 1;
+
+	processBins (data, fftn, 0, fftN2-1);
+}
+
+void FTprocCompressor::processBins (fft_data *data, unsigned int fftn, int start, int end)
+{
+	FTspectrumModifier::Reader threshold (_thresh_filter);
+	FTspectrumModifier::Reader ratio (_ratio_filter);
+	FTspectrumModifier::Reader attack (_attack_filter);
+	FTspectrumModifier::Reader release (_release_filter);
+	FTspectrumModifier::Reader makeup (_makeup_filter);
 	
 	const float knee = 5.0;
 	float ga;
@@ -250,10 +288,18 @@ void FTprocCompressor::process (fft_data *data, unsigned int fftn)
 	float rat;
 	float att, rel;
 	
-	int fftN2 = (fftn+1) >> 1;
-	
-	for (int i = 0; i < fftN2-1; i++)
+	int rstart, rend;
+
+	for (unsigned int r = 0; r < _ranges.size(); r++)
 	{
+		if (_ranges[r].end <= start) continue;
+		if (_ranges[r].start >= end) break;
+		
+		rstart = _ranges[r].start > start ? _ranges[r].start : start;
+		rend = _ranges[r].end < end ? _ranges[r].end : end;
+
+		for (int i = rstart; i < rend; i++)
+		{
 // 		if (filter[i] > max) filt = max;
 // 		else if (filter[i] < min) filt = min;
 // 		else filt = filter[i];
@@ -261,27 +307,27 @@ void FTprocCompressor::process (fft_data *data, unsigned int fftn)
 // 		power = (data[i] * data[i]) + (data[fftn-i] * data[fftn-i]);
 // 		db = FTutils::powerLogScale (power, 0.0000000) + _dbAdjust; // total fudge factors
 
-		thresh = LIMIT(threshold[i], -60.0f, 0.0f) + _dbAdjust;
-		rat = LIMIT(ratio[i], 1.0f, 80.0f);
-		att = LIMIT(attack[i], 0.002f, 1.0f); 
-		rel = LIMIT(release[i], att, 1.0f);
+			thresh = LIMIT(threshold[i], -60.0f, 0.0f) + _dbAdjust;
+			rat = LIMIT(ratio[i], 1.0f, 80.0f);
+			att = LIMIT(attack[i], 0.002f, 1.0f); 
+			rel = LIMIT(release[i], att, 1.0f);
 		
-		ga = _as[f_round(att  * (float)(A_TBL-1))];
-		gr = _as[f_round(rel * (float)(A_TBL-1))];
-		rs = (rat - 1.0f) / rat;
-		mug = db2lin(LIMIT(makeup[i], 0.0f, 32.0f));
-		knee_min = db2lin(thresh - knee);
-		knee_max = db2lin(thresh + knee);
-		ef_a = ga * 0.25f;
-		ef_ai = 1.0f - ef_a;
+			ga = _as[f_round(att  * (float)(A_TBL-1))];
+			gr = _as[f_round(rel * (float)(A_TBL-1))];
+			rs = (rat - 1.0f) / rat;
+			mug = db2lin(LIMIT(makeup[i], 0.0f, 32.0f));
+			knee_min = db2lin(thresh - knee);
+			knee_max = db2lin(thresh + knee);
+			ef_a = ga * 0.25f;
+			ef_ai = 1.0f - ef_a;
 		
-		//_sum[i] += FTutils::fast_square_root((data[i] * data[i]) + (data[fftn-i] * data[fftn-i]));
-		if (i == 0) {
-			_sum[i] += (data[i] * data[i]);
-		}
-		else {
-			_sum[i] += (data[i] * data[i]) + (data[fftn-i] * data[fftn-i]);
-		}
+			//_sum[i] += FTutils::fast_square_root((data[i] * data[i]) + (data[fftn-i] * data[fftn-i]));
+			if (i == 0) {
+				_sum[i] += (data[i] * data[i]);
+			}
+			else {
+				_sum[i] += (data[i] * data[i]) + (data[fftn-i] * data[fftn-i]);
+			}
 
 // 		_sum[i] = FLUSH_TO_ZERO(_sum[i]);
 // 		_env[i] = FLUSH_TO_ZERO(_env[i]);
@@ -289,32 +335,33 @@ void FTprocCompressor::process (fft_data *data, unsigned int fftn)
 // 		_rms[i]->sum = FLUSH_TO_ZERO(_rms[i]->sum);
 //		_gain[i] = FLUSH_TO_ZERO(_gain[i]);
 		
-		if (_amp[i] > _env[i]) {
-			_env[i] = _env[i] * ga + _amp[i] * (1.0f - ga);
-		}
-		else {
-			_env[i] = _env[i] * gr + _amp[i] * (1.0f - gr);
-		}
-		if (_count[i]++ % 4 == 3)
-		{
-			_amp[i] = rms_env_process(_rms[i], _sum[i] * 0.25f);
-			_sum[i] = 0.0f;
-			if (_env[i] <= knee_min) {
-				_gain_t[i] = 1.0f;
-			} else if (_env[i] < knee_max) {
-				const float x = -(thresh - knee - lin2db(_env[i])) / knee;
-				_gain_t[i] = db2lin(-knee * rs * x * x * 0.25f);
-			} else {
-				_gain_t[i] = db2lin((thresh - lin2db(_env[i])) * rs);
+			if (_amp[i] > _env[i]) {
+				_env[i] = _env[i] * ga + _amp[i] * (1.0f - ga);
+			}
+			else {
+				_env[i] = _env[i] * gr + _amp[i] * (1.0f - gr);
+			}
+			if (_count[i]++ % 4 == 3)
+			{
+				_amp[i] = rms_env_process(_rms[i], _sum[i] * 0.25f);
+				_sum[i] = 0.0f;
+				if (_env[i] <= knee_min) {
+					_gain_t[i] = 1.0f;
+				} else if (_env[i] < knee_max) {
+					const float x = -(thresh - knee - lin2db(_env[i])) / knee;
+					_gain_t[i] = db2lin(-knee * rs * x * x * 0.25f);
+				} else {
+					_gain_t[i] = db2lin((thresh - lin2db(_env[i])) * rs);
+				}
 			}
-		}
 
-		_gain[i] = _gain[i] * ef_a + _gain_t[i] * ef_ai;
+			_gain[i] = _gain[i] * ef_a + _gain_t[i] * ef_ai;
 		
-		data[i] *=  _gain[i] * mug;
-		if (i > 0) {
-			data[fftn-i] *=  _gain[i] * mug;
-		}
+			data[i] *=  _gain[i] * mug;
+			if (i > 0) {
+				data[fftn-i] *=  _gain[i] * mug;
+			}
 
+		}
 	}
 }
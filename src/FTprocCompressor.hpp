@@ -48,6 +48,9 @@ class FTprocCompressor
 	
 	void process (fft_data *data,  unsigned int fftn);
 
+	bool isFusible() { return true; }
+	void processBins (fft_data *data, unsigned int fftn, int start, int end);
+
 	virtual void setFFTsize (unsigned int fftn);
 	virtual void setOversamp (int osamp);
 
@@ -59,6 +62,9 @@ class FTprocCompressor
 	
   protected:
 
+	bool computeIdentity();
+	void viewChanged();
+	
 	FTspectrumModifier * _thresh_filter;
 	FTspectrumModifier * _ratio_filter;
 	FTspectrumModifier * _attack_filter;
@@ -76,6 +82,12 @@ class FTprocCompressor
 	unsigned int * _count;
 	float * _as;
 	rms_env ** _rms;
+
+	// bins with a ratio above 1 or some makeup gain
+	FTspectrumModifier::RangeList _ratioRanges;
+	FTspectrumModifier::RangeList _makeupRanges;
+	FTspectrumModifier::RangeList _tmpRanges;
+	FTspectrumModifier::RangeList _ranges;
 	
 	float _dbAdjust;
 };
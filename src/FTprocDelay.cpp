@@ -18,21 +18,38 @@
 */
 
 #include "FTprocDelay.hpp"
-#include "RingBuffer.hpp"
 
-FTprocDelay::FTprocDelay (nframes_t samprate, unsigned int fftn)
+#include <string.h>
+#include <stdio.h>
+
+// above this many bytes of float frame storage the AUTO mode
+// switches to half precision (about 10 sec at 44.1k, 4x oversampling)
+#define FT_DELAY_FLOAT_BUDGET (1 << 24)
+
+
+FTprocDelay::FTprocDelay (nframes_t samprate, unsigned int fftn, DelayMode mode)
 	: FTprocI("Delay", samprate, fftn),
-	  _delayFilter(0), _feedbackFilter(0), _frameFifo(0), _maxDelay(2.5)
+	  _delayFilter(0), _feedbackFilter(0), _frames(0), _halfFrames(0),
+	  _frameCount(0), _frameLength(0), _currFrame(0), _idle(false), _idleHops(0),
+	  _storageMode(STORAGE_AUTO), _delayMode(mode), _maxDelay(2.5)
 {
-	_confname = "Delay";
+	if (_delayMode == DELAY_INTERPOLATED) {
+		_name = "Smooth Delay";
+		_confname = "SmoothDelay";
+	}
+	else {
+		_confname = "Delay";
+	}
 }
 
 FTprocDelay::FTprocDelay (const FTprocDelay & other)
 	: FTprocI (other._name, other._sampleRate, other._fftN),	
-	_delayFilter(0), _feedbackFilter(0), _frameFifo(0), _maxDelay(2.5)
+	_delayFilter(0), _feedbackFilter(0), _frames(0), _halfFrames(0),
+	_frameCount(0), _frameLength(0), _currFrame(0), _idle(false), _idleHops(0),
+	_storageMode(other._storageMode), _delayMode(other._delayMode), _maxDelay(2.5)
 
 {
-	_confname = "Delay";
+	_confname = other._confname;
 }
 
 void FTprocDelay::initialize()
@@ -45,19 +62,22 @@ void FTprocDelay::initialize()
 	_feedbackFilter = new FTspectrumModifier("D Feedback", "feedback", 1, FTspectrumModifier::UNIFORM_MODIFIER, FEEDB_SPECMOD, _fftN/2, 0.0);
 	_feedbackFilter->setRange(0.0, 1.0);
 
-	setMaxDelay(_maxDelay);
-
 	_filterlist.push_back(_delayFilter);
 	_filterlist.push_back(_feedbackFilter);
 
+	FTspectrumModifier::reserveRanges (_ranges);
+	
 	_inited = true;
+
+	setMaxDelay(_maxDelay);
 }
 
 FTprocDelay::~FTprocDelay()
 {
 	if (!_inited) return;
 	
-	delete _frameFifo;
+	delete [] _frames;
+	delete [] _halfFrames;
 	
         _filterlist.clear();
 	delete _delayFilter;
@@ -66,9 +86,12 @@ FTprocDelay::~FTprocDelay()
 
 void FTprocDelay::reset()
 {
-	// flush FIFOs
-	_frameFifo->reset();
-	_frameFifo->mem_set(0);
+	// flush all the frames
+	for (unsigned int n=0; n < _frameCount; ++n) {
+		clearFrame (n);
+	}
+	_currFrame = 0;
+	_idleHops = _frameCount;
 }
 
 void FTprocDelay::setMaxDelay(float secs)
@@ -76,24 +99,15 @@ void FTprocDelay::setMaxDelay(float secs)
 	// THIS MUST NOT BE CALLED WHILE WE ARE ACTIVATED!
 	if (secs <= 0.0) return;
 	
-	unsigned long maxsamples = 1;
-
 	_maxDelay = secs;
-	_maxDelaySamples = (unsigned long) (_maxDelay * _sampleRate) * sizeof(sample_t);
 
-	// we need to force this to the next bigger power of 2 for the memory allocation
-	while (maxsamples < _maxDelaySamples) {
-		maxsamples <<= 1;
+	if (!_inited) {
+		// initialize() will do the rest
+		return;
 	}
-	       
-	if (_frameFifo)
-		delete _frameFifo;
-
-	//printf ("using %lu for maxsamples\n", maxsamples);
-
-	// this is a big boy containing the frequency data frames over time
-	_frameFifo = new RingBuffer( maxsamples * sizeof(fft_data) );
 
+	allocateFrames();
+	
 	// adjust time filter
 	if (_delayFilter) {
 		_delayFilter->setRange (0.0, _maxDelay);
@@ -101,42 +115,172 @@ void FTprocDelay::setMaxDelay(float secs)
 	}
 }
 
+void FTprocDelay::setFFTsize (unsigned int fftn)
+{
+	FTprocI::setFFTsize (fftn);
+
+	if (_inited) {
+		allocateFrames();
+	}
+}
+
+void FTprocDelay::setOversamp (int osamp)
+{
+	FTprocI::setOversamp (osamp);
+
+	if (_inited) {
+		allocateFrames();
+	}
+}
+
+void FTprocDelay::setSampleRate (nframes_t rate)
+{
+	FTprocI::setSampleRate (rate);
+
+	if (_inited) {
+		allocateFrames();
+	}
+}
+
+void FTprocDelay::setStorageMode (StorageMode mode)
+{
+	_storageMode = mode;
+
+	if (_inited) {
+		allocateFrames();
+	}
+}
+
+void FTprocDelay::allocateFrames()
+{
+	// one slot per hop of the max delay, plus the current one.
+	// interpolation reads one frame past the max as well
+	double hops = _maxDelay * _sampleRate * _oversamp / (double) _fftN;
+	unsigned int count = (unsigned int) hops + (_delayMode == DELAY_INTERPOLATED ? 2 : 1);
+	unsigned long floatbytes = (unsigned long) count * _fftN * sizeof(float);
+
+	bool usehalf = (_storageMode == STORAGE_HALF)
+		|| (_storageMode == STORAGE_AUTO && floatbytes > FT_DELAY_FLOAT_BUDGET);
+
+	if (count == _frameCount && _fftN == _frameLength
+	    && usehalf == (_halfFrames != 0))
+	{
+		// same shape as before
+		return;
+	}
+
+	delete [] _frames;
+	delete [] _halfFrames;
+	_frames = 0;
+	_halfFrames = 0;
+
+	if (usehalf) {
+		_halfFrames = new uint16_t[(unsigned long) count * _fftN];
+	}
+	else {
+		_frames = new float[(unsigned long) count * _fftN];
+	}
+
+	//printf ("delay using %u frames of %u\n", count, _fftN);
+	
+	_frameCount = count;
+	_frameLength = _fftN;
+
+	reset();
+}
+
+void FTprocDelay::clearFrame (unsigned int frame)
+{
+	if (_delayMode == DELAY_INTERPOLATED) {
+		for (unsigned long k = 0; k < _frameLength; k++) {
+			storeBin (k * _frameCount + frame, 0.0f);
+		}
+		return;
+	}
+	
+	// half 0x0000 is also 0.0
+	if (_halfFrames) {
+		memset (_halfFrames + (unsigned long) frame * _frameLength, 0, _frameLength * sizeof(uint16_t));
+	}
+	else {
+		memset (_frames + (unsigned long) frame * _frameLength, 0, _frameLength * sizeof(float));
+	}
+}
+
+
+bool FTprocDelay::computeIdentity()
+{
+	// no delay anywhere means no feedback either
+	_idle = _delayFilter->getBypassed()
+		|| (_delayFilter->getActiveRanges (_delayFilter->getMin(), _ranges) == 0);
+
+	// the interpolated history has to keep up for when a delay is
+	// drawn again, the frames only until what was pending is gone
+	return _idle && _delayMode == DELAY_FRAMES && _idleHops >= _frameCount;
+}
 
 void FTprocDelay::process (fft_data *data, unsigned int fftn)
 {
-	if (!_inited) return;
+	if (isIdentity() || fftn != _frameLength) return;
+
+	if (_idle) {
+		processIdle (data, fftn);
+		return;
+	}
+
+	_idleHops = 0;
 	
-	if (_delayFilter->getBypassed())
-	{
-		_frameFifo->write ( (char *) data, sizeof(fft_data) * fftn);
+	if (_delayMode == DELAY_INTERPOLATED) {
+		processInterpolated (data, fftn);
+	}
+	else {
+		processFrames (data, fftn);
+	}
+}
 
-		_frameFifo->read( (char *) data, sizeof(fft_data) * fftn);
-		
-		// RETURNS HERE
+void FTprocDelay::processIdle (fft_data *data, unsigned int fftn)
+{
+	if (_delayMode == DELAY_INTERPOLATED) {
+		// keep the history running so a delay coming back is seamless
+		for (unsigned long k = 0; k < fftn; k++) {
+			storeBin (k * _frameCount + _currFrame, data[k]);
+		}
+		_currFrame = (_currFrame + 1) % _frameCount;
 		return;
 	}
 
-	float *delay = _delayFilter->getValues();
-	float *feedb = _feedbackFilter->getValues();
+	// drop whatever was pending for this hop, the same as a delay of
+	// 0 does, and free up the slot
+	clearFrame (_currFrame);
+	_currFrame = (_currFrame + 1) % _frameCount;
+
+	if (++_idleHops >= _frameCount) {
+		// the ring is clear, the engine can skip us until a delay
+		// is drawn
+		_identity = true;
+	}
+}
+
+void FTprocDelay::processFrames (fft_data *data, unsigned int fftn)
+{
+	unsigned long curr = (unsigned long) _currFrame * fftn;
+
+	FTspectrumModifier::Reader delay (_delayFilter);
+	FTspectrumModifier::Reader feedb (_feedbackFilter);
 	float feedback = 0.0;
 	bool bypassfeed = _feedbackFilter->getBypassed();
 	
 	float mindelay = _delayFilter->getMin();
 	float maxdelay = _delayFilter->getMax();
 	float thisdelay;
-	
-	float *rdest = 0, *idest = 0;
-	float *rcurr = 0, *icurr = 0;
-	nframes_t bshift, fshift;
-	int fftn2 = (fftn+1) >> 1;
 
+	// hops per second
+	float hoprate = _sampleRate * _oversamp / (float) fftn;
 	
-	//RingBuffer::rw_vector readvec[2];
-	RingBuffer::rw_vector wrvec[2];
-
-	_frameFifo->get_write_vector(wrvec);
+	unsigned int fshift;
+	unsigned long dest;
+	int fftn2 = (fftn+1) >> 1;
 
-	
 	for (int i = 0; i < fftn2-1; i++)
 	{
 		if (bypassfeed) {
@@ -159,46 +303,119 @@ void FTprocDelay::process (fft_data *data, unsigned int fftn)
 		}
 		
 		// frames to shift
-		fshift = ((nframes_t)(_sampleRate * thisdelay * sizeof(sample_t))) / fftn;
-		//nframes_t bshift = fshift * fftn * sizeof(sample_t);
-		//printf ("bshift %Zd  wrvec[0]=%d\n", bshift, wrvec[0].len);
-		// byte offset to start of frame
-		//bshift = fshift * fftn * sizeof(sample_t);
-		bshift = fshift * fftn * sizeof(sample_t);
-
-
-		// we know the next frame is in the first segment of the FIFO
-		// because our FIFO size is always shifted one frame at a time
-		rcurr = (float * ) (wrvec[0].buf + i*sizeof(sample_t));
-		icurr = (float * ) (wrvec[0].buf + (fftn-i)*sizeof(sample_t));
+		fshift = (unsigned int) (thisdelay * hoprate);
+		if (fshift >= _frameCount) {
+			fshift = _frameCount - 1;
+		}
+
+		// start of destination frame
+		dest = (unsigned long) ((_currFrame + fshift) % _frameCount) * fftn;
 		
-		if (wrvec[0].len > bshift) {
-			rdest = (float *) (wrvec[0].buf + bshift + i*sizeof(sample_t));
-			idest = (float *) (wrvec[0].buf + bshift + (fftn-i)*sizeof(sample_t));
+		storeBin (dest + i, data[i] + loadBin(curr + i) * feedback);
+		if (i > 0) {
+			storeBin (dest + fftn - i, data[fftn-i] + loadBin(curr + fftn - i) * feedback);
+		}
+	}
+
+	// read current frame into output
+	if (_halfFrames) {
+		for (unsigned int i = 0; i < fftn; i++) {
+			data[i] = half_to_float (_halfFrames[curr + i]);
 		}
-		else if (wrvec[1].len) {
-			bshift -= wrvec[0].len;
-			rdest = (float *) (wrvec[1].buf + bshift + i*sizeof(sample_t));
-			idest = (float *) (wrvec[1].buf + bshift + (fftn-i)*sizeof(sample_t));
+	}
+	else {
+		memcpy (data, _frames + curr, fftn * sizeof(fft_data));
+	}
+
+	// and free up the slot for max delay from now
+	clearFrame (_currFrame);
+	_currFrame = (_currFrame + 1) % _frameCount;
+}
+
+
+void FTprocDelay::processInterpolated (fft_data *data, unsigned int fftn)
+{
+	unsigned int count = _frameCount;
+	unsigned int curr = _currFrame;
+	int fftn2 = (fftn+1) >> 1;
+
+	FTspectrumModifier::Reader delay (_delayFilter);
+	FTspectrumModifier::Reader feedb (_feedbackFilter);
+	float feedback = 0.0;
+	bool bypassfeed = _feedbackFilter->getBypassed();
+	
+	float mindelay = _delayFilter->getMin();
+	float maxdelay = _delayFilter->getMax();
+	float thisdelay;
+
+	// hops per second
+	float hoprate = _sampleRate * _oversamp / (float) fftn;
+	
+	float fhops, frac;
+	unsigned int whole;
+	unsigned long rlane, ilane;
+	unsigned int newer, older;
+	float rout, iout;
+	
+	for (int i = 0; i < fftn2-1; i++)
+	{
+		if (bypassfeed) {
+			feedback = 0.0;
 		}
 		else {
-			printf ("BLAHHALALAHLA\n");
-			continue;
+			feedback = feedb[i] < 0.0 ? 0.0 : feedb[i];
 		}
+
+		rlane = (unsigned long) i * count;
+		ilane = (unsigned long) (fftn - i) * count;
 		
+		if (delay[i] <= mindelay) {
+			// straight through, nothing to feed back
+			storeBin (rlane + curr, data[i]);
+			if (i > 0) {
+				storeBin (ilane + curr, data[fftn-i]);
+			}
+			continue;
+		}
+
+		thisdelay = (delay[i] > maxdelay) ? maxdelay : delay[i];
+
+		fhops = thisdelay * hoprate;
+		whole = (unsigned int) fhops;
+		if (whole > count - 2) {
+			whole = count - 2;
+		}
+		frac = fhops - whole;
+
+		// the two frames either side of the delay point
+		newer = (curr + count - whole) % count;
+		older = (newer + count - 1) % count;
+
+		// newer is this hop's input when whole is 0, which isn't
+		// stored yet
+		if (whole == 0) {
+			rout = (1.0f - frac) * data[i] + frac * loadBin (rlane + older);
+		}
+		else {
+			rout = (1.0f - frac) * loadBin (rlane + newer) + frac * loadBin (rlane + older);
+		}
+
+		storeBin (rlane + curr, data[i] + rout * feedback);
+		data[i] = rout;
 		
-		*rdest = data[i] + (*rcurr)*feedback;
 		if (i > 0) {
-			*idest = data[fftn-i] + (*icurr)*feedback;
+			// DC has no imaginary part, its lane would be past the end
+			if (whole == 0) {
+				iout = (1.0f - frac) * data[fftn-i] + frac * loadBin (ilane + older);
+			}
+			else {
+				iout = (1.0f - frac) * loadBin (ilane + newer) + frac * loadBin (ilane + older);
+			}
+			
+			storeBin (ilane + curr, data[fftn-i] + iout * feedback);
+			data[fftn-i] = iout;
 		}
 	}
-	
-	// advance it
-	_frameFifo->write_advance(fftn * sizeof(fft_data));
-	
-	//_frameFifo->write ( (char *) data, sizeof(fft_data) * fftn);
-
-	// read data into output
-	_frameFifo->read( (char *) data, sizeof(fft_data) * fftn);
 
+	_currFrame = (curr + 1) % count;
 }
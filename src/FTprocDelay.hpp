@@ -22,15 +22,27 @@
 
 
 #include "FTprocI.hpp"
-
-class RingBuffer;
+#include "FTutils.hpp"
 
 class FTprocDelay
 	: public FTprocI
 {
   public:
 
-	FTprocDelay (nframes_t samprate, unsigned int fftn);
+	enum StorageMode
+	{
+		STORAGE_AUTO = 0, // float, falling back to half when the delay is very long
+		STORAGE_FLOAT,
+		STORAGE_HALF
+	};
+
+	enum DelayMode
+	{
+		DELAY_FRAMES = 0,   // each bin delayed by a whole number of hops
+		DELAY_INTERPOLATED  // fractional hops, linear between neighbour frames
+	};
+
+	FTprocDelay (nframes_t samprate, unsigned int fftn, DelayMode mode=DELAY_FRAMES);
 	FTprocDelay (const FTprocDelay & other);
 
 	virtual ~FTprocDelay();
@@ -45,22 +57,83 @@ class FTprocDelay
 
 	
 	void setMaxDelay(float secs);
+
+	void setFFTsize (unsigned int fftn);
+	void setOversamp (int osamp);
+	void setSampleRate (nframes_t rate);
+
+	// ONLY call when not processing
+	void setStorageMode (StorageMode mode);
+	StorageMode getStorageMode() { return _storageMode; }
+
+	DelayMode getDelayMode() { return _delayMode; }
+
+	virtual bool useAsDefault() { return _delayMode == DELAY_FRAMES; }
 	
   protected:
 
-	FTspectrumModifier * _delayFilter;
-	FTspectrumModifier * _feedbackFilter;
+	bool computeIdentity();
+	
+	void processFrames (fft_data *data, unsigned int fftn);
+	void processInterpolated (fft_data *data, unsigned int fftn);
+	// no delay anywhere, just keeps the ring going
+	void processIdle (fft_data *data, unsigned int fftn);
+	
+	void allocateFrames();
+	void clearFrame (unsigned int frame);
 
+	inline float loadBin (unsigned long pos);
+	inline void storeBin (unsigned long pos, float val);
 
-	// this is a very large ringbuffer
-	// used to store the fft results over time
-	// each frame is stored sequentially.
-	// the length is determined by the maximum delay time
-	RingBuffer *_frameFifo;
+	FTspectrumModifier * _delayFilter;
+	FTspectrumModifier * _feedbackFilter;
 
-	unsigned long _maxDelaySamples;
+	// for computeIdentity(), reserved up front
+	FTspectrumModifier::RangeList _ranges;
+
+
+	// ring of fft frames over time, one slot per hop, in whichever
+	// of the two buffers is in use.  there are just enough
+	// slots to cover the max delay at the current hop rate.
+	//
+	// DELAY_FRAMES is frame-major: frame n lives at [n*fftN, (n+1)*fftN)
+	// DELAY_INTERPOLATED is bin-major: the history of halfcomplex
+	// element k lives at [k*_frameCount, (k+1)*_frameCount), so the
+	// two neighbouring frames read for each bin are adjacent
+	float *_frames;
+	uint16_t *_halfFrames;
+
+	unsigned int _frameCount;
+	unsigned int _frameLength;
+	unsigned int _currFrame;
+
+	// bypassed or no delay anywhere, and the hops since the ring was
+	// last fed.  DELAY_FRAMES is an identity once that has cleared
+	// the whole ring
+	bool _idle;
+	unsigned int _idleHops;
+
+	StorageMode _storageMode;
+	DelayMode _delayMode;
 	float _maxDelay;
 
 };
 
+
+
+inline float FTprocDelay::loadBin (unsigned long pos)
+{
+	return _halfFrames ? half_to_float (_halfFrames[pos]) : _frames[pos];
+}
+
+inline void FTprocDelay::storeBin (unsigned long pos, float val)
+{
+	if (_halfFrames) {
+		_halfFrames[pos] = float_to_half (val);
+	}
+	else {
+		_frames[pos] = val;
+	}
+}
+
 #endif
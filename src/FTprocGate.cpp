@@ -65,26 +65,35 @@ FTprocGate::~FTprocGate()
 
 void FTprocGate::process (fft_data *data, unsigned int fftn)
 {
-	if (!_inited || _filter->getBypassed()) {
+	if (isIdentity()) {
 		return;
 	}
 	
-	float *filter = _filter->getValues();
-	float *invfilter = _invfilter->getValues();
+	int fftn2 = (fftn+1) >> 1;
+
+	processBins (data, fftn, 0, fftn2-1);
+}
+
+void FTprocGate::processBins (fft_data *data, unsigned int fftn, int start, int end)
+{
+	FTspectrumModifier::Reader filter (_filter);
+	FTspectrumModifier::Reader invfilter (_invfilter);
 	
 	float power;
 	float db;
-	int fftn2 = (fftn+1) >> 1;
 	
 	// only allow data through if power is above threshold
 
-	power = (data[0] * data[0]);
-	db = FTutils::powerLogScale (power, 0.0000000) + _dbAdjust; // total fudge factors
-	if (db < filter[0] || db > invfilter[0]) {
-		data[0] = 0.0;
+	if (start == 0) {
+		power = (data[0] * data[0]);
+		db = FTutils::powerLogScale (power, 0.0000000) + _dbAdjust; // total fudge factors
+		if (db < filter[0] || db > invfilter[0]) {
+			data[0] = 0.0;
+		}
+		start = 1;
 	}
 	
- 	for (int i = 1; i < fftn2-1; i++)
+ 	for (int i = start; i < end; i++)
  	{
 		power = (data[i] * data[i]) + (data[fftn-i] * data[fftn-i]);
 		db = FTutils::powerLogScale (power, 0.0000000) + _dbAdjust; // total fudge factors
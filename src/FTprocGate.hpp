@@ -36,9 +36,14 @@ class FTprocGate
 	
 	void process (fft_data *data, unsigned int fftn);
 
+	bool isFusible() { return true; }
+	void processBins (fft_data *data, unsigned int fftn, int start, int end);
+
 	
   protected:
 
+	bool computeIdentity() { return _filter->getBypassed(); }
+	
 	FTspectrumModifier * _filter;
 	FTspectrumModifier * _invfilter;
 
@@ -26,7 +26,8 @@
 
 
 FTprocI::FTprocI (const string & name, nframes_t samprate, unsigned int fftn)
-	: _sampleRate(samprate), _fftN(fftn), _oversamp(4), _inited(false), _name(name), _confname(name)
+	: _sampleRate(samprate), _fftN(fftn), _oversamp(4), _inited(false), _name(name), _confname(name),
+	  _identity(false), _identityValid(false), _identityVersion(0), _viewVersion(0)
 {
 }
 
@@ -54,6 +55,82 @@ void FTprocI::setId (int id)
 		(*filt)->setId(id);
 	}
 }
+
+unsigned int FTprocI::getFiltersVersion()
+{
+	unsigned int version = 0;
+	
+	for (FilterList::iterator filt = _filterlist.begin();
+	     filt != _filterlist.end(); ++filt)
+	{
+		version += (*filt)->getVersion();
+	}
+
+	return version;
+}
+
+unsigned int FTprocI::getFiltersView()
+{
+	unsigned int version = 0;
 	
+	for (FilterList::iterator filt = _filterlist.begin();
+	     filt != _filterlist.end(); ++filt)
+	{
+		version += (*filt)->getViewVersion();
+	}
 
+	return version;
+}
 
+void FTprocI::smoothFilters (nframes_t now)
+{
+	for (FilterList::iterator filt = _filterlist.begin();
+	     filt != _filterlist.end(); ++filt)
+	{
+		if (!(*filt)->getBypassed()) {
+			(*filt)->smooth (now, _sampleRate);
+		}
+	}
+}
+
+void FTprocI::settleFilters ()
+{
+	for (FilterList::iterator filt = _filterlist.begin();
+	     filt != _filterlist.end(); ++filt)
+	{
+		(*filt)->settle();
+	}
+}
+
+bool FTprocI::isIdentity()
+{
+	if (!_inited) {
+		return true;
+	}
+	
+	unsigned int version = getFiltersVersion();
+	unsigned int view = getFiltersView();
+	bool wasidentity = _identityValid && _identity;
+
+	if (!_identityValid || version != _identityVersion)
+	{
+		_identity = computeIdentity();
+		_identityVersion = version;
+		_identityValid = true;
+
+		viewChanged();
+		_viewVersion = view;
+	}
+	else if (view != _viewVersion)
+	{
+		viewChanged();
+		_viewVersion = view;
+	}
+
+	if (wasidentity && !_identity) {
+		// whatever state we have is stale now
+		reset();
+	}
+
+	return _identity;
+}
@@ -108,9 +108,45 @@ class FTprocI
 	virtual void reset() {}
 
 	virtual bool useAsDefault() { return true; }
+
+	// true when process() would leave the spectrum untouched, the
+	// engine skips these modules entirely.  this is only re-evaluated
+	// when one of our filters has changed since the last call
+	bool isIdentity();
+
+	// advance the smoothing ramps of our filters, called by the
+	// engine once per hop before processing
+	void smoothFilters (nframes_t now);
+	// and jump them straight to their targets, before processing starts
+	void settleFilters ();
+
+	// pointwise modules, where each output bin only depends on the
+	// same input bin and its own state, can work on a tile of bins at
+	// a time.  the engine runs consecutive fusible modules together
+	// tile by tile so the spectrum only streams through cache once
+	virtual bool isFusible() { return false; }
+
+	// process bins start <= i < end in place, bin 0 is the DC term.
+	// only called on fusible modules that are not at identity
+	virtual void processBins (fft_data *data, unsigned int fftn, int start, int end) {}
+	
  protected:
 
 	FTprocI (const string & name, nframes_t samprate, unsigned int fftn);
+
+	// modules that can tell override this, it is called from
+	// isIdentity() after a filter change and is a good place to
+	// recompute any active bin ranges
+	virtual bool computeIdentity() { return false; }
+
+	// called from isIdentity() after computeIdentity() and whenever
+	// what a filter Reader sees has moved since (rotation, smoothing).
+	// modules that cache anything in bin order (like active ranges)
+	// remap it here.  may update _identity
+	virtual void viewChanged() {}
+
+	unsigned int getFiltersVersion();
+	unsigned int getFiltersView();
 	
 	
 	bool _bypassed;
@@ -124,6 +160,11 @@ class FTprocI
 	int _id;
 	string _name;
 	string _confname;
+
+	bool _identity;
+	bool _identityValid;
+	unsigned int _identityVersion;
+	unsigned int _viewVersion;
 };
 
 
@@ -59,11 +59,18 @@ FTprocLimit::~FTprocLimit()
 
 void FTprocLimit::process (fft_data *data, unsigned int fftn)
 {
-	if (!_inited || _threshfilter->getBypassed()) {
+	if (isIdentity()) {
 		return;
 	}
 	
-	float *filter = _threshfilter->getValues();
+	int fftN2 = (fftn+1) >> 1;
+
+	processBins (data, fftn, 0, fftN2-1);
+}
+
+void FTprocLimit::processBins (fft_data *data, unsigned int fftn, int start, int end)
+{
+	FTspectrumModifier::Reader filter (_threshfilter);
 	float min = _threshfilter->getMin();
 	float max = _threshfilter->getMax();
 	float filt;
@@ -71,21 +78,21 @@ void FTprocLimit::process (fft_data *data, unsigned int fftn)
 	float db;
 	float scale;
 
-	
-	int fftN2 = (fftn+1) >> 1;
-
 	// do for first element
-	filt = FTutils::f_clamp (filter[0], min, max);
-	power = (data[0] * data[0]);
-	db = FTutils::powerLogScale (power, 0.0000000) + _dbAdjust; // total fudge factors
-	if (filt < db) {
-		// apply limiting
-		scale = 1 / (pow (2, (db-filt) / 6.0));
-		data[0] *=  scale;
+	if (start == 0) {
+		filt = FTutils::f_clamp (filter[0], min, max);
+		power = (data[0] * data[0]);
+		db = FTutils::powerLogScale (power, 0.0000000) + _dbAdjust; // total fudge factors
+		if (filt < db) {
+			// apply limiting
+			scale = 1 / (pow (2, (db-filt) / 6.0));
+			data[0] *=  scale;
+		}
+		start = 1;
 	}
 	
 	// do for the rest
-	for (int i = 1; i < fftN2-1; i++)
+	for (int i = start; i < end; i++)
 	{
 		filt = FTutils::f_clamp (filter[i], min, max);
 		power = (data[i] * data[i]) + (data[fftn-i] * data[fftn-i]);
@@ -37,10 +37,15 @@ class FTprocLimit
 	
 	void process (fft_data *data,  unsigned int fftn);
 
+	bool isFusible() { return true; }
+	void processBins (fft_data *data, unsigned int fftn, int start, int end);
+
 	virtual bool useAsDefault() { return false; }
 	
   protected:
 
+	bool computeIdentity() { return _threshfilter->getBypassed(); }
+	
 	FTspectrumModifier * _threshfilter;
 	float _dbAdjust;
 };
@@ -78,11 +78,11 @@ FTprocPitch::~FTprocPitch()
 
 void FTprocPitch::process (fft_data *data, unsigned int fftn)
 {
- 	if (!_inited || _filter->getBypassed()) {
+ 	if (isIdentity()) {
  		return;
  	}
 
-	float *filter = _filter->getValues();
+	FTspectrumModifier::Reader filter (_filter);
 
 	double magn, phase, tmp, real, imag;
 	double freqPerBin, expct;
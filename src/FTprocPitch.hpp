@@ -38,6 +38,8 @@ class FTprocPitch
 	
   protected:
 
+	bool computeIdentity() { return _filter->getBypassed(); }
+	
 	FTspectrumModifier * _filter;
 
 	// stuff for pitchscaling
@@ -20,6 +20,10 @@
 #include "FTprocWarp.hpp"
 #include "FTutils.hpp"
 
+// room in the gather table.  two taps per source bin always fit, the
+// rest is for filling in stretched regions
+#define FT_WARP_MAX_TAPS (4 * FT_MAX_FFT_SIZE_HALF)
+
 FTprocWarp::FTprocWarp (nframes_t samprate, unsigned int fftn)
 	: FTprocI("Warp", samprate, fftn)
 {
@@ -43,6 +47,12 @@ void FTprocWarp::initialize()
 	_filterlist.push_back (_filter);
 
 	_tmpdata = new fft_data[FT_MAX_FFT_SIZE];
+
+	_tapStart = new int[FT_MAX_FFT_SIZE_HALF + 1];
+	_tapFill = new int[FT_MAX_FFT_SIZE_HALF];
+	_tapSource = new int[FT_WARP_MAX_TAPS];
+	_tapWeight = new float[FT_WARP_MAX_TAPS];
+	_tableBins = 0;
 	
 	_inited = true;
 }
@@ -55,45 +65,187 @@ FTprocWarp::~FTprocWarp()
 	delete _filter;
 
 	delete [] _tmpdata;
+	delete [] _tapStart;
+	delete [] _tapFill;
+	delete [] _tapSource;
+	delete [] _tapWeight;
 }
 
-void FTprocWarp::process (fft_data *data, unsigned int fftn)
+bool FTprocWarp::computeIdentity()
 {
-	if (!_inited || _filter->getBypassed()) {
+	// the real check is in viewChanged(), which always follows
+	return _filter->getBypassed();
+}
+
+void FTprocWarp::viewChanged()
+{
+	if (_filter->getBypassed()) {
 		return;
 	}
 	
-	float *filter = _filter->getValues();
+	// identity if every bin maps onto itself
+	FTspectrumModifier::Reader filter (_filter);
 	float min = _filter->getMin();
 	float max = _filter->getMax();
-	float filt;
+	int fftN2 = (_fftN+1) >> 1;
 
-	int fftN2 = (fftn+1) >> 1;
+	_identity = true;
+	
+	for (int i = 1; i < fftN2-1; i++)
+	{
+		if (fabsf (FTutils::f_clamp(filter[i], min, max) - i) > 1e-3f) {
+			_identity = false;
+			break;
+		}
+	}
+
+	// only rebuilt when the curve has changed or moved
+	if (!_identity) {
+		compileTable();
+	}
+}
 
-	memset(_tmpdata, 0, fftn * sizeof(fft_data));
+inline void FTprocWarp::addTap (int dest, int src, float weight, bool counting)
+{
+	if (weight <= 0.0f) return;
+	
+	if (counting) {
+		_tapStart[dest+1]++;
+	}
+	else {
+		int n = _tapFill[dest]++;
+		_tapSource[n] = src;
+		_tapWeight[n] = weight;
+	}
+}
 
-	for (int i = 1; i < fftN2-1; i++)
+void FTprocWarp::compileTable()
+{
+	// Each source bin i lands on the fractional bin filter[i] and is
+	// split linearly between its two neighbours, so many-to-one maps
+	// still sum up.  Where neighbouring source bins land more than a
+	// bin apart, the output bins in between are interpolated from the
+	// pair so stretched regions don't leave holes.
+	
+	FTspectrumModifier::Reader filter (_filter);
+	float min = _filter->getMin();
+	float max = _filter->getMax();
+	int fftN2 = (_fftN+1) >> 1;
+	int last = fftN2 - 1;
+	float pos, nextpos, lo, hi, frac;
+	int k, slo, shi;
+	bool fill = true;
+
+	memset (_tapStart, 0, (fftN2 + 1) * sizeof(int));
+	
+	for (int pass = 0; pass < 2; pass++)
 	{
-		filt = FTutils::f_clamp(filter[i], min, max);
+		bool counting = (pass == 0);
 		
-// 		_tmpdata[i] +=  data[(int)filt];
-// 		_tmpdata[fftn-i] +=  data[fftn - ((int)filt)];
- 		_tmpdata[(int)filt] +=  data[i];
-		if (i > 0 && filt > 0) {
-			_tmpdata[fftn-((int)filt)] +=  data[fftn - i];
+		for (int i = 1; i < fftN2-1; i++)
+		{
+			pos = FTutils::f_clamp(filter[i], min, max);
+			if (pos > last) pos = last;
+
+			k = (int) pos;
+			frac = pos - k;
+			addTap (k, i, 1.0f - frac, counting);
+			if (k < last) {
+				addTap (k+1, i, frac, counting);
+			}
+
+			if (!fill || i+1 >= fftN2-1) continue;
+			
+			nextpos = FTutils::f_clamp(filter[i+1], min, max);
+			if (nextpos > last) nextpos = last;
+
+			if (pos <= nextpos) {
+				lo = pos;  hi = nextpos;  slo = i;  shi = i+1;
+			}
+			else {
+				lo = nextpos;  hi = pos;  slo = i+1;  shi = i;
+			}
+			
+			// the bins a full bin or more away from both endpoints,
+			// nearer ones already get a share of the endpoint splats
+			for (int j = (int) ceilf (lo + 1.0f); j <= (int) floorf (hi - 1.0f); j++)
+			{
+				frac = (j - lo) / (hi - lo);
+				addTap (j, slo, 1.0f - frac, counting);
+				addTap (j, shi, frac, counting);
+			}
+		}
+
+		if (counting) {
+			for (int j = 0; j < fftN2; j++) {
+				_tapStart[j+1] += _tapStart[j];
+			}
+
+			if (_tapStart[fftN2] > FT_WARP_MAX_TAPS) {
+				// too jagged to fill in between, count again with
+				// just the endpoint splats
+				fill = false;
+				memset (_tapStart, 0, (fftN2 + 1) * sizeof(int));
+				pass = -1;
+				continue;
+			}
+			memcpy (_tapFill, _tapStart, fftN2 * sizeof(int));
 		}
+	}
+
+	_tableBins = fftN2;
+}
+
+void FTprocWarp::process (fft_data *data, unsigned int fftn)
+{
+	if (isIdentity()) {
+		return;
+	}
+
+	int fftN2 = (fftn+1) >> 1;
+
+	if (_tableBins != fftN2) {
+		// table is for another fft size
+		return;
+	}
+
+	const int * start = _tapStart;
+	const int * src = _tapSource;
+	const float * weight = _tapWeight;
+	float re, im;
+	int n, end;
+	
+	// we gather from a copy of the input, every output bin is written
+	memcpy (_tmpdata, data, fftn * sizeof(fft_data));
+
+	re = 0.0f;
+	for (n = start[0]; n < start[1]; n++) {
+		re += weight[n] * _tmpdata[src[n]];
+	}
+	data[0] = re;
+	
+	for (int j = 1; j < fftN2; j++)
+	{
+		re = im = 0.0f;
+		end = start[j+1];
 		
+		for (n = start[j]; n < end; n++) {
+			re += weight[n] * _tmpdata[src[n]];
+			im += weight[n] * _tmpdata[fftn - src[n]];
+		}
+
+		data[j] = re;
+		data[fftn-j] = im;
 	}
 
-	memcpy (data, _tmpdata, fftn * sizeof(fft_data));
+	data[fftN2] = 0.0f;
 }
 
 
 void FTprocWarp::setFFTsize (unsigned int fftn)
 {
+	// setLength() scales the curve to the new bins
 	FTprocI::setFFTsize (fftn);
 
-	// reset our filters max
 	_filter->setRange (0.0, (float) (fftn >> 1));
-	_filter->reset();
 }
@@ -43,10 +43,25 @@ class FTprocWarp
 
  protected:
 
+	bool computeIdentity();
+	void viewChanged();
+
+	void compileTable();
+	inline void addTap (int dest, int src, float weight, bool counting);
+	
 	FTspectrumModifier * _filter;
 
 	fft_data *_tmpdata;
-	
+
+	// the warp curve compiled into a gather table for _tableBins
+	// output bins, output bin j sums _tapWeight[n] * input[_tapSource[n]]
+	// for _tapStart[j] <= n < _tapStart[j+1].  allocated for the
+	// largest fft size, compiling only reuses them
+	int * _tapStart;
+	int * _tapSource;
+	float * _tapWeight;
+	int * _tapFill;
+	int _tableBins;
 };
 
 #endif
@@ -0,0 +1,225 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "FTsettingsWriter.hpp"
+#include "FTpresetFile.hpp"
+
+using namespace PBD;
+
+FTsettingsWriter::FTsettingsWriter()
+	: _running(false), _quit(false)
+{
+	pthread_cond_init (&_cond, 0);
+}
+
+FTsettingsWriter::~FTsettingsWriter()
+{
+	if (_running) {
+		{
+			LockMonitor lm (_lock, __LINE__, __FILE__);
+			_quit = true;
+			pthread_cond_broadcast (&_cond);
+		}
+
+		pthread_join (_thread, 0);
+	}
+
+	pthread_cond_destroy (&_cond);
+}
+
+bool FTsettingsWriter::start()
+{
+	// with _lock held
+	if (_running) {
+		return true;
+	}
+
+	if (pthread_create (&_thread, 0, threadEntry, this) != 0) {
+		fprintf (stderr, "Error creating the settings writer thread, saving in place\n");
+		return false;
+	}
+
+	_running = true;
+	return true;
+}
+
+void FTsettingsWriter::save (const string & path, FTpresetFile * file)
+{
+	Job job;
+	job.file = file;
+	queue (path, job);
+}
+
+void FTsettingsWriter::save (const string & path, const string & contents)
+{
+	Job job;
+	job.contents = contents;
+	queue (path, job);
+}
+
+void FTsettingsWriter::queue (const string & path, const Job & job)
+{
+	{
+		LockMonitor lm (_lock, __LINE__, __FILE__);
+		
+		if (start()) {
+			map<string, Job>::iterator old = _queue.find (path);
+			if (old != _queue.end()) {
+				// never written, this one supersedes it
+				delete old->second.file;
+				old->second = job;
+			}
+			else {
+				_queue[path] = job;
+			}
+			
+			pthread_cond_broadcast (&_cond);
+			return;
+		}
+	}
+
+	// no thread, do it here
+	bool ok = write (path, job);
+	delete job.file;
+
+	LockMonitor lm (_lock, __LINE__, __FILE__);
+	(ok ? _written : _failed).push_back (path);
+}
+
+bool FTsettingsWriter::write (const string & path, const Job & job)
+{
+	bool ok;
+	
+	if (job.file) {
+		ok = job.file->write (path);
+	}
+	else {
+		// the same temporary and rename as FTpresetFile::write()
+		string tmppath = path + ".tmp";
+		FILE * out = fopen (tmppath.c_str(), "wb");
+		
+		ok = out != 0;
+		ok = ok && fwrite (job.contents.data(), 1, job.contents.size(), out) == job.contents.size();
+		ok = ok && fflush (out) == 0 && fsync (fileno (out)) == 0;
+		if (out && fclose (out) != 0) {
+			ok = false;
+		}
+		ok = ok && rename (tmppath.c_str(), path.c_str()) == 0;
+		ok = ok && FTpresetFile::syncDirectory (path);
+
+		if (!ok) {
+			fprintf (stderr, "Error writing %s: %s\n", path.c_str(), strerror(errno));
+			unlink (tmppath.c_str());
+		}
+	}
+
+	if (job.file) {
+		if (ok) {
+			fprintf (stderr, "Stored settings into %s\n", path.c_str());
+		}
+		else {
+			fprintf (stderr, "Failed to store settings into %s\n", path.c_str());
+		}
+	}
+	
+	return ok;
+}
+
+void FTsettingsWriter::wait (const string & path)
+{
+	LockMonitor lm (_lock, __LINE__, __FILE__);
+
+	while (path.empty() ? (!_queue.empty() || !_writing.empty())
+	       : (_queue.find (path) != _queue.end() || _writing == path))
+	{
+		pthread_cond_wait (&_cond, _lock.mutex());
+	}
+}
+
+bool FTsettingsWriter::isPending (const string & path)
+{
+	LockMonitor lm (_lock, __LINE__, __FILE__);
+
+	return _queue.find (path) != _queue.end() || _writing == path;
+}
+
+void FTsettingsWriter::getPending (list<string> & paths)
+{
+	LockMonitor lm (_lock, __LINE__, __FILE__);
+
+	for (map<string, Job>::iterator iter = _queue.begin(); iter != _queue.end(); ++iter) {
+		paths.push_back (iter->first);
+	}
+	if (!_writing.empty()) {
+		paths.push_back (_writing);
+	}
+}
+
+void FTsettingsWriter::takeFinished (list<string> & written, list<string> & failed)
+{
+	LockMonitor lm (_lock, __LINE__, __FILE__);
+
+	written.splice (written.end(), _written);
+	failed.splice (failed.end(), _failed);
+}
+
+void * FTsettingsWriter::threadEntry (void * arg)
+{
+	static_cast<FTsettingsWriter *> (arg)->run();
+	return 0;
+}
+
+void FTsettingsWriter::run()
+{
+	LockMonitor lm (_lock, __LINE__, __FILE__);
+
+	while (true)
+	{
+		if (_queue.empty()) {
+			if (_quit) break;
+			
+			pthread_cond_wait (&_cond, _lock.mutex());
+			continue;
+		}
+
+		map<string, Job>::iterator next = _queue.begin();
+		Job job = next->second;
+		_writing = next->first;
+		_queue.erase (next);
+
+		// the disk work happens unlocked
+		_lock.unlock();
+		
+		bool ok = write (_writing, job);
+		delete job.file;
+
+		_lock.lock();
+
+		(ok ? _written : _failed).push_back (_writing);
+
+		_writing = "";
+		// for anyone in wait()
+		pthread_cond_broadcast (&_cond);
+	}
+}
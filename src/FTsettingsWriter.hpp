@@ -0,0 +1,88 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#ifndef __FTSETTINGSWRITER_HPP__
+#define __FTSETTINGSWRITER_HPP__
+
+#include <pthread.h>
+
+#include <string>
+#include <list>
+#include <map>
+using namespace std;
+
+#include "LockMonitor.hpp"
+
+class FTpresetFile;
+
+// Writes preset files on its own thread so saving never holds up the
+// gui.  Each save is a finished snapshot, a newer one for the same
+// path replaces any that hasn't been written yet.
+class FTsettingsWriter
+{
+  public:
+
+	FTsettingsWriter();
+	// writes whatever is still queued first
+	~FTsettingsWriter();
+
+	// takes file, it is deleted once written
+	void save (const string & path, FTpresetFile * file);
+	// any other file, written the same way
+	void save (const string & path, const string & contents);
+
+	// blocks until path (or everything, if empty) has been written
+	void wait (const string & path = "");
+
+	bool isPending (const string & path);
+	void getPending (list<string> & paths);
+	// the paths written, and that failed to be, since the last call
+	void takeFinished (list<string> & written, list<string> & failed);
+	
+  protected:
+
+	// one of the two
+	struct Job {
+		Job() : file(0) {}
+		FTpresetFile * file;
+		string contents;
+	};
+	
+	static void * threadEntry (void * arg);
+	void run();
+
+	bool start();
+	void queue (const string & path, const Job & job);
+	static bool write (const string & path, const Job & job);
+	
+	PBD::Lock _lock;
+	pthread_cond_t _cond;
+	pthread_t _thread;
+	bool _running;
+	bool _quit;
+
+	map<string, Job> _queue;
+	// the one being written right now
+	string _writing;
+	// for takeFinished()
+	list<string> _written;
+	list<string> _failed;
+};
+
+#endif
@@ -57,6 +57,8 @@
 #include "FTupdateToken.hpp"
 #include "FTprocI.hpp"
 #include "FTmodulatorI.hpp"
+#include "FTspectralFeatures.hpp"
+#include "cycles.h"
 
 using namespace PBD;
 using namespace std;
@@ -71,11 +73,22 @@ const int FTspectralEngine::_fftSizes[] = {
 	32, 64, 128, 256, 512, 1024, 2048, 4096, 8192
 };
 
+volatile unsigned int FTspectralEngine::_activeGeneration = 0;
+unsigned int FTspectralEngine::_cycleGeneration = 0;
+volatile unsigned int FTspectralEngine::_lastGeneration = 0;
+
 
 // in samples  (about 3 seconds at 44100)
 
 #define FT_MAX_DELAYSAMPLES (1 << 19)
 
+// bins per tile when running fused modules, small enough that the
+// spectrum tile and every filter array of a few modules stay in L1
+#define FT_FUSE_TILE_BINS 256
+
+// weight of each hop in the running average of a modulator's cost
+#define FT_MOD_COST_AVERAGE 0.01f
+
 
 FTspectralEngine::FTspectralEngine()
 	: _fftN (512), _windowing(FTspectralEngine::WINDOW_HANNING)
@@ -97,6 +110,19 @@ FTspectralEngine::FTspectralEngine()
 	memset((char *) _runningOutputPower, 0, FT_MAX_FFT_SIZE_HALF*sizeof(fft_data));
 	memset((char *) _runningInputPower, 0, FT_MAX_FFT_SIZE_HALF*sizeof(fft_data));
 
+	_inputHopPower = new fft_data [FT_MAX_FFT_SIZE_HALF];
+	memset((char *) _inputHopPower, 0, FT_MAX_FFT_SIZE_HALF*sizeof(fft_data));
+	_hopPower = _runningInputPower;
+
+	_features = new FTspectralFeatures();
+	_featuresLive = false;
+	_hopCount = 0;
+	_nextHopOffset = 0;
+
+	_stageState = STAGE_IDLE;
+	_stageGeneration = 0;
+	_fadeHops = 0;
+	_fadeHop = 0;
 
 	initState();
 }
@@ -105,6 +131,7 @@ void FTspectralEngine::initState()
 {
 	_inwork = new fft_data [_fftN];
 	_accum = new fft_data [2 * _fftN];
+	_fadework = new fft_data [_fftN];
 
 	memset((char *) _accum, 0, 2*_fftN*sizeof(fft_data));
 	memset((char *) _inwork, 0, _fftN*sizeof(fft_data));
@@ -149,6 +176,7 @@ void FTspectralEngine::destroyState()
 
  	delete [] _inwork;
  	delete [] _accum;
+	delete [] _fadework;
 	
 
 	// destroy window vectors
@@ -182,6 +210,8 @@ FTspectralEngine::~FTspectralEngine()
 	delete [] _inputPowerSpectra;
         delete [] _outputPowerSpectra;
 	delete [] _runningInputPower;
+	delete [] _inputHopPower;
+	delete _features;
 	delete [] _runningOutputPower;
 
 	
@@ -190,6 +220,18 @@ FTspectralEngine::~FTspectralEngine()
 	{
 		delete (*iter);
 	}
+
+	// whatever is still staged, or was replaced by it
+	for (vector<FTmodulatorI*>::iterator iter = _stagedModulators.begin();
+	     iter != _stagedModulators.end(); ++iter)
+	{
+		delete (*iter);
+	}
+	for (vector<FTprocI*>::iterator iter = _stagedModules.begin();
+	     iter != _stagedModules.end(); ++iter)
+	{
+		delete (*iter);
+	}
 }
 
 
@@ -229,19 +271,21 @@ void FTspectralEngine::insertProcessorModule (FTprocI * procmod, unsigned int in
 	procmod->setSampleRate (_sampleRate);
 	
 	_procModules.insert (iter, procmod);
+	_fuseRun.reserve (_procModules.size());
 }
 
 void FTspectralEngine::appendProcessorModule (FTprocI * procmod)
 {
 	if (!procmod) return;
 
-	LockMonitor (_procmodLock, __LINE__, __FILE__);
+	LockMonitor pmlock(_procmodLock, __LINE__, __FILE__);
 	
 	procmod->setOversamp (_oversamp);
 	procmod->setFFTsize (_fftN);
 	procmod->setSampleRate (_sampleRate);
 	
 	_procModules.push_back (procmod);
+	_fuseRun.reserve (_procModules.size());
 }
 
 void FTspectralEngine::moveProcessorModule (unsigned int from, unsigned int to)
@@ -351,6 +395,8 @@ void FTspectralEngine::insertModulator (FTmodulatorI * procmod, unsigned int ind
 		
 		procmod->setFFTsize (_fftN);
 		procmod->setSampleRate (_sampleRate);
+		procmod->setFeatures (_features);
+		procmod->_hopOffset = _nextHopOffset++;
 		
 		_modulators.insert (iter, procmod);
 	}
@@ -367,6 +413,8 @@ void FTspectralEngine::appendModulator (FTmodulatorI * procmod)
 		
 		procmod->setFFTsize (_fftN);
 		procmod->setSampleRate (_sampleRate);
+		procmod->setFeatures (_features);
+		procmod->_hopOffset = _nextHopOffset++;
 		
 		_modulators.push_back (procmod);
 	}
@@ -430,6 +478,9 @@ void FTspectralEngine::removeModulator (unsigned int index, bool destroy)
 
 		delete proc;
 	}
+	else {
+		(*iter)->setFeatures (0);
+	}
 	
 	_modulators.erase(iter);
 }
@@ -446,6 +497,7 @@ void FTspectralEngine::removeModulator (FTmodulatorI * procmod, bool destroy)
 		{
 			if (procmod == *iter) {
 				
+				procmod->setFeatures (0);
 				_modulators.erase(iter);
 				candel = true;
 				break;
@@ -472,16 +524,137 @@ void FTspectralEngine::clearModulators (bool destroy)
 	
 	vector<FTmodulatorI*>::iterator iter = _modulators.begin();
 
-	if (destroy) {
-		for (; iter != _modulators.end(); ++iter) {
+	for (; iter != _modulators.end(); ++iter) {
+		if (destroy) {
 			delete (*iter);
 		}
+		else {
+			(*iter)->setFeatures (0);
+		}
 	}
 
 	_modulators.clear();
 }
 
 
+bool FTspectralEngine::stageProcessorModules (vector<FTprocI *> & modules, vector<FTmodulatorI *> & modulators,
+					      unsigned int generation, int fadehops)
+{
+	if (_stageState != STAGE_IDLE) return false;
+
+	// nobody is running these yet, so they can be set up here
+	for (vector<FTprocI*>::iterator iter = modules.begin();
+	     iter != modules.end(); ++iter)
+	{
+		(*iter)->setOversamp (_oversamp);
+		(*iter)->setFFTsize (_fftN);
+		(*iter)->setSampleRate (_sampleRate);
+		(*iter)->setId (_id);
+	}
+
+	for (vector<FTmodulatorI*>::iterator iter = modulators.begin();
+	     iter != modulators.end(); ++iter)
+	{
+		(*iter)->setFFTsize (_fftN);
+		(*iter)->setSampleRate (_sampleRate);
+		(*iter)->setFeatures (_features);
+		(*iter)->_hopOffset = _nextHopOffset++;
+	}
+
+	{
+		LockMonitor pmlock(_procmodLock, __LINE__, __FILE__);
+
+		// the crossfade runs both
+		_fuseRun.reserve (max (_procModules.size(), modules.size()));
+
+		_stagedModules = modules;
+		_stagedModulators = modulators;
+		_stageGeneration = generation;
+		_fadeHops = fadehops > 0 ? fadehops : 0;
+	}
+
+	// everything above before the process thread sees it ready
+	__sync_synchronize();
+	_stageState = STAGE_READY;
+
+	modules.clear();
+	modulators.clear();
+	
+	return true;
+}
+
+unsigned int FTspectralEngine::newStageGeneration()
+{
+	return __sync_add_and_fetch (&_lastGeneration, 1);
+}
+
+void FTspectralEngine::activateStaged (unsigned int generation)
+{
+	__sync_synchronize();
+	_activeGeneration = generation;
+}
+
+void FTspectralEngine::swapStaged (bool fade)
+{
+	__sync_synchronize();
+	
+	_procModules.swap (_stagedModules);
+	_modulators.swap (_stagedModulators);
+
+	_fadeHop = 0;
+	
+	__sync_synchronize();
+	_stageState = (fade && _fadeHops > 0) ? STAGE_FADING : STAGE_DONE;
+}
+
+bool FTspectralEngine::stagedSwapped (bool force)
+{
+	if (force && _stageState == STAGE_READY) {
+		LockMonitor modlock(_modulatorLock, __LINE__, __FILE__);
+		LockMonitor pmlock(_procmodLock, __LINE__, __FILE__);
+
+		if (__sync_bool_compare_and_swap (&_stageState, STAGE_READY, STAGE_SWAPPING)) {
+			swapStaged (false);
+		}
+	}
+
+	return _stageState != STAGE_READY && _stageState != STAGE_SWAPPING;
+}
+
+bool FTspectralEngine::stagedDone (bool force)
+{
+	if (force && _stageState == STAGE_FADING) {
+		// the process thread only fades with this held
+		LockMonitor pmlock(_procmodLock, __LINE__, __FILE__);
+		__sync_bool_compare_and_swap (&_stageState, STAGE_FADING, STAGE_DONE);
+	}
+	
+	return _stageState == STAGE_DONE || _stageState == STAGE_IDLE;
+}
+
+bool FTspectralEngine::reclaimStaged (vector<FTprocI *> & modules, vector<FTmodulatorI *> & modulators)
+{
+	if (_stageState != STAGE_DONE) return false;
+
+	__sync_synchronize();
+	
+	modules.insert (modules.end(), _stagedModules.begin(), _stagedModules.end());
+	modulators.insert (modulators.end(), _stagedModulators.begin(), _stagedModulators.end());
+	_stagedModules.clear();
+	_stagedModulators.clear();
+
+	for (vector<FTmodulatorI*>::iterator iter = modulators.begin();
+	     iter != modulators.end(); ++iter)
+	{
+		(*iter)->setFeatures (0);
+	}
+
+	__sync_synchronize();
+	_stageState = STAGE_IDLE;
+	
+	return true;
+}
+
 void FTspectralEngine::setId (int id)
 {
 	LockMonitor pmlock(_procmodLock, __LINE__, __FILE__);
@@ -510,6 +683,11 @@ void FTspectralEngine::setFFTsize (FTspectralEngine::FFT_Size sz)
 		{
 			(*iter)->setFFTsize (_fftN);
 		}
+		for (vector<FTprocI*>::iterator iter = _stagedModules.begin();
+		     iter != _stagedModules.end(); ++iter)
+		{
+			(*iter)->setFFTsize (_fftN);
+		}
 
 		destroyState();
 		initState();
@@ -538,6 +716,11 @@ void FTspectralEngine::setOversamp (int osamp)
 	{
 		(*iter)->setOversamp (_oversamp);
 	}
+	for (vector<FTprocI*>::iterator iter = _stagedModules.begin();
+	     iter != _stagedModules.end(); ++iter)
+	{
+		(*iter)->setOversamp (_oversamp);
+	}
 	
 }
 
@@ -571,6 +754,11 @@ void FTspectralEngine::setMaxDelay(float secs)
 	{
 		(*iter)->setMaxDelay (secs);
 	}
+	for (vector<FTprocI*>::iterator iter = _stagedModules.begin();
+	     iter != _stagedModules.end(); ++iter)
+	{
+		(*iter)->setMaxDelay (secs);
+	}
 	
 }
 
@@ -625,30 +813,116 @@ bool FTspectralEngine::processNow (FTprocessPath *procpath)
 		// compute running mag^2 buffer for input
 		computeAverageInputPower (_outwork);
 
+		// a staged chain goes in before anything runs on this hop,
+		// if the gui has either list it waits for the next one
+		if (_stageState == STAGE_READY && _stageGeneration == _cycleGeneration)
+		{
+			TentativeLockMonitor modlock(_modulatorLock, __LINE__, __FILE__);
+			TentativeLockMonitor pmlock(_procmodLock, __LINE__, __FILE__);
+
+			if (modlock.locked() && pmlock.locked()
+			    && __sync_bool_compare_and_swap (&_stageState, STAGE_READY, STAGE_SWAPPING))
+			{
+				swapStaged (true);
+			}
+		}
+		
 
 		// do modulation in order with each modulator
 		{
 			TentativeLockMonitor modlock(_modulatorLock, __LINE__, __FILE__);
 			if (modlock.locked()) {
-			
+
+				// work out the features once for all who want them
+				bool wanted = false;
 				for (vector<FTmodulatorI*>::iterator iter = _modulators.begin();
 				     iter != _modulators.end(); ++iter)
 				{
-					(*iter)->modulate (current_frame, _outwork, _fftN, _inwork, _fftN);
+					if ((*iter)->usesFeatures()) {
+						wanted = true;
+						break;
+					}
+				}
+
+				if (wanted) {
+					if (!_featuresLive) {
+						_features->reset();
+					}
+					_features->compute (_hopPower, _fftN, _sampleRate, step_size);
+				}
+				_featuresLive = wanted;
+				
+				float hoprate = _sampleRate / (float) step_size;
+				
+				for (vector<FTmodulatorI*>::iterator iter = _modulators.begin();
+				     iter != _modulators.end(); ++iter)
+				{
+					FTmodulatorI * mod = (*iter);
+					float rate = mod->getUpdateRate();
+					unsigned int every = 1;
+
+					if (rate > 0.0f && rate < hoprate) {
+						every = (unsigned int) (hoprate / rate);
+					}
+
+					float cycles = 0.0f;
+					
+					if ((_hopCount + mod->_hopOffset) % every == 0) {
+						// only the low 32 bits are good on some platforms
+						uint32_t start = (uint32_t) get_cycles();
+						mod->modulate (current_frame, _outwork, _fftN, _inwork, _fftN);
+						cycles = (float) (uint32_t) ((uint32_t) get_cycles() - start);
+					}
+
+					mod->_cost += (cycles - mod->_cost) * FT_MOD_COST_AVERAGE;
 				}
 			}
 		}
+
+		++_hopCount;
 		
 		// do processing in order with each processing module
 		{
 			TentativeLockMonitor pmlock(_procmodLock, __LINE__, __FILE__);
 			if (pmlock.locked()) {
-			
+
+				// ramp the filters towards their targets first
 				for (vector<FTprocI*>::iterator iter = _procModules.begin();
 				     iter != _procModules.end(); ++iter)
 				{
-					// do it in place
-					(*iter)->process (_outwork,  _fftN);
+					(*iter)->smoothFilters (current_frame);
+				}
+
+				bool fading = (_stageState == STAGE_FADING);
+				
+				if (fading) {
+					// the chain we swapped out gets its own copy
+					memcpy (_fadework, _outwork, _fftN * sizeof(fft_data));
+
+					for (vector<FTprocI*>::iterator iter = _stagedModules.begin();
+					     iter != _stagedModules.end(); ++iter)
+					{
+						(*iter)->smoothFilters (current_frame);
+					}
+
+					processModules (_fadework, _stagedModules);
+				}
+				
+				processModules (_outwork, _procModules);
+
+				if (fading) {
+					// the ifft is linear, so this is a crossfade of
+					// the overlapped outputs too
+					float gain = (float) ++_fadeHop / (float) (_fadeHops + 1);
+
+					for (i=0; i < _fftN; i++) {
+						_outwork[i] = _fadework[i] + gain * (_outwork[i] - _fadework[i]);
+					}
+
+					if (_fadeHop >= _fadeHops) {
+						__sync_synchronize();
+						_stageState = STAGE_DONE;
+					}
 				}
 			}
 		}
@@ -706,26 +980,81 @@ bool FTspectralEngine::processNow (FTprocessPath *procpath)
 
 
 
+void FTspectralEngine::processModules (fft_data *data, vector<FTprocI *> & modules)
+{
+	// runs of consecutive fusible modules are done together one tile
+	// of bins at a time, everything else gets its own pass.
+	
+	int fftN2 = (_fftN+1) >> 1;
+	unsigned int nmods = modules.size();
+	unsigned int n = 0;
+	
+	while (n < nmods)
+	{
+		FTprocI * procmod = modules[n];
+		
+		if (!procmod->isFusible()) {
+			// nothing to do until a curve is drawn
+			if (!procmod->isIdentity()) {
+				// do it in place
+				procmod->process (data, _fftN);
+			}
+			++n;
+			continue;
+		}
+
+		// gather the active members of this run, identity modules
+		// don't break it up
+		_fuseRun.clear();
+		for (; n < nmods && modules[n]->isFusible(); ++n) {
+			if (!modules[n]->isIdentity()) {
+				_fuseRun.push_back (modules[n]);
+			}
+		}
+
+		if (_fuseRun.size() == 1) {
+			_fuseRun[0]->processBins (data, _fftN, 0, fftN2-1);
+		}
+		else if (_fuseRun.size() > 1) {
+			for (int start = 0; start < fftN2-1; start += FT_FUSE_TILE_BINS)
+			{
+				int end = start + FT_FUSE_TILE_BINS < fftN2-1 ? start + FT_FUSE_TILE_BINS : fftN2-1;
+
+				for (vector<FTprocI*>::iterator iter = _fuseRun.begin();
+				     iter != _fuseRun.end(); ++iter)
+				{
+					(*iter)->processBins (data, _fftN, start, end);
+				}
+			}
+		}
+	}
+}
+
 void FTspectralEngine::computeAverageInputPower (fft_data *fftbuf)
 {
 	int fftn2 = _fftN / 2;
 
+	// this hop first, the averages and the features build on it
+	fft_data * power = (_averages > 1) ? _inputHopPower : _runningInputPower;
+	
+	power[0] = fftbuf[0] * fftbuf[0];
+	for (int i=1; i < fftn2-1; i++)
+	{
+		power[i] = (fftbuf[i] * fftbuf[i]) + (fftbuf[_fftN-i] * fftbuf[_fftN-i]);
+	}
+
+	_hopPower = power;
+	
 	if (_averages > 1) {
 
 		if (_currInAvgIndex > 0) {
-			_inputPowerSpectra[0] += fftbuf[0] * fftbuf[0];
-			for (int i=1; i < fftn2-1; i++)
+			for (int i=0; i < fftn2-1; i++)
 			{
-				_inputPowerSpectra[i] += (fftbuf[i] * fftbuf[i]) + (fftbuf[_fftN-i] * fftbuf[_fftN-i]);
+				_inputPowerSpectra[i] += power[i];
 			}	
 		}
 		else {
-			_inputPowerSpectra[0] = fftbuf[0] * fftbuf[0];
-		
-			for (int i=1; i < fftn2-1 ; i++)
-			{
-				_inputPowerSpectra[i] = (fftbuf[i] * fftbuf[i]) + (fftbuf[_fftN-i] * fftbuf[_fftN-i]);
-			}	
+			memcpy (_inputPowerSpectra, power, (fftn2-1) * sizeof(fft_data));
 		}
 		
 		_currInAvgIndex = (_currInAvgIndex+1) % _averages;
@@ -740,15 +1069,8 @@ void FTspectralEngine::computeAverageInputPower (fft_data *fftbuf)
 		}
 	}
 	else {
-		// 1 average, minimize looping
-		_runningInputPower[0] = (fftbuf[0] * fftbuf[0]);
-		
-		for (int i=1; i < fftn2-1 ; i++)
-		{
-			_runningInputPower[i] = (fftbuf[i] * fftbuf[i]) + (fftbuf[_fftN-i] * fftbuf[_fftN-i]);
-		}		
+		// 1 average, the hop is the running power
 		_avgReady = true;
-
 	}
 	
 }
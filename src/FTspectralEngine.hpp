@@ -55,6 +55,7 @@ class FTspectrumModifier;
 class FTupdateToken;
 class FTmodulatorI;
 class FTprocI;
+class FTspectralFeatures;
 
 class FTspectralEngine
 
@@ -171,6 +172,33 @@ class FTspectralEngine
 
 	SigC::Signal1<void, FTmodulatorI *> ModulatorAdded;
 
+	// Staged recall.  A chain and its modulators built off to the
+	// side (see FTconfigManager::stageSettings()) are handed over with
+	// stageProcessorModules(), which fits them to this engine.  After
+	// activateStaged() with the same generation the process thread
+	// swaps them in at the start of its next hop, so every engine
+	// staged with one generation switches on the same hop.  For
+	// fadehops hops the old chain keeps running on a copy of the
+	// spectrum and the output crossfades over to the new one.
+	// false if something is staged here already
+	bool stageProcessorModules (vector<FTprocI *> & modules, vector<FTmodulatorI *> & modulators,
+				    unsigned int generation, int fadehops=0);
+	static unsigned int newStageGeneration();
+	static void activateStaged (unsigned int generation);
+	// the io thread calls this at the start of each cycle, before
+	// any engine runs, so an activation can't land between two
+	static void latchStaged () { _cycleGeneration = _activeGeneration; }
+
+	// true once nothing staged is waiting to be swapped in.  force
+	// swaps it in from here, for when the process thread isn't running
+	bool stagedSwapped (bool force=false);
+	// true when what the swap replaced is no longer processed.
+	// force cuts a crossfade short
+	bool stagedDone (bool force=false);
+	// hands back what the swap replaced once it is done, the caller
+	// deletes it
+	bool reclaimStaged (vector<FTprocI *> & modules, vector<FTmodulatorI *> & modulators);
+
 
 	
 	static const char ** getWindowStrings() { return (const char **) _windowStrings; }
@@ -183,6 +211,12 @@ class FTspectralEngine
 protected:
 
 	
+	// must be called with the _procmodLock held
+	void processModules (fft_data *data, vector<FTprocI *> & modules);
+
+	// swaps the staged chain in, both locks must be held
+	void swapStaged (bool fade);
+	
 	void computeAverageInputPower (fft_data *fftbuf);
 	void computeAverageOutputPower (fft_data *fftbuf);
 	
@@ -205,10 +239,44 @@ protected:
 	vector<FTprocI *> _procModules;
 	PBD::NonBlockingLock _procmodLock;
 
+	// scratch for processModules, reserved to the module count so
+	// the process thread never allocates
+	vector<FTprocI *> _fuseRun;
+
 	// the modulators
 	vector<FTmodulatorI *> _modulators;
 	PBD::NonBlockingLock _modulatorLock;
 
+	enum StageState {
+		STAGE_IDLE = 0,
+		STAGE_READY,    // staged, waiting for its generation
+		STAGE_SWAPPING, // the process thread has it
+		STAGE_FADING,   // swapped in, the old chain is still fading out
+		STAGE_DONE      // the old chain is waiting to be reclaimed
+	};
+
+	// the chain waiting to be swapped in, afterwards the one it replaced
+	vector<FTprocI *> _stagedModules;
+	vector<FTmodulatorI *> _stagedModulators;
+	volatile int _stageState;
+	unsigned int _stageGeneration;
+	int _fadeHops;
+	int _fadeHop;
+
+	static volatile unsigned int _activeGeneration;
+	static unsigned int _cycleGeneration;
+	static volatile unsigned int _lastGeneration;
+
+	// input features for the modulators, only computed while one
+	// of them uses it
+	FTspectralFeatures * _features;
+	bool _featuresLive;
+
+	// hops so far, and the offset the next modulator gets so
+	// ones that run every few hops don't all land on the same one
+	unsigned int _hopCount;
+	unsigned int _nextHopOffset;
+
 	
 	// fft size (thus frame length)
         int _fftN;
@@ -240,6 +308,11 @@ protected:
 	fft_data * _runningInputPower;
 	fft_data * _runningOutputPower;
 
+	// the power of just the last hop, with averaging on this is
+	// _inputHopPower, otherwise _runningInputPower itself
+	fft_data * _inputHopPower;
+	fft_data * _hopPower;
+
 	
 	nframes_t _sampleRate;
 	
@@ -257,6 +330,8 @@ protected:
 private:
 	
 	fft_data *_inwork, *_outwork;
+	// the spectrum through the old chain while crossfading
+	fft_data *_fadework;
 	fft_data *_winwork;
 	fft_data *_accum;
 	fft_data *_scaletemp;
@@ -0,0 +1,157 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#include "FTspectralFeatures.hpp"
+#include "FTutils.hpp"
+
+#include <cmath>
+using namespace std;
+
+// time constant of the flux average onsets are measured against
+#define FT_ONSET_AVERAGE_TIME 0.25f
+
+FTspectralFeatures::FTspectralFeatures()
+	: _bins(0), _binHz(0.0f), _scale(0.0f), _hopTime(0.0f), _fresh(true)
+	, _centroid(0.0f), _flux(0.0f), _fluxAvg(0.0f), _onset(0.0f), _energy(0.0f)
+{
+	_mag = new float[FT_MAX_FFT_SIZE_HALF];
+	_lastMag = new float[FT_MAX_FFT_SIZE_HALF];
+	_cumPower = new double[FT_MAX_FFT_SIZE_HALF + 1];
+
+	_cumPower[0] = 0.0;
+}
+
+FTspectralFeatures::~FTspectralFeatures()
+{
+	delete [] _mag;
+	delete [] _lastMag;
+	delete [] _cumPower;
+}
+
+void FTspectralFeatures::reset()
+{
+	_fresh = true;
+	_flux = _fluxAvg = _onset = 0.0f;
+}
+
+void FTspectralFeatures::compute (const float * power, int fftn, nframes_t samplerate, int hopsamps)
+{
+	int bins = fftn / 2 - 1;
+	int i;
+
+	if (bins != _bins) {
+		// a new fft size, the last magnitudes don't line up
+		_bins = bins;
+		_fresh = true;
+	}
+	
+	_binHz = samplerate / (float) fftn;
+	_scale = 4.0f / ((float) fftn * fftn);
+	_hopTime = hopsamps / (float) samplerate;
+	
+	// the sums are split in four so they vectorize without
+	// reassociating floats behind our back
+	float psum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	float wsum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	int n4 = bins & ~3;
+	
+	for (i=0; i < n4; i += 4) {
+		psum[0] += power[i];
+		psum[1] += power[i+1];
+		psum[2] += power[i+2];
+		psum[3] += power[i+3];
+		wsum[0] += power[i] * i;
+		wsum[1] += power[i+1] * (i+1);
+		wsum[2] += power[i+2] * (i+2);
+		wsum[3] += power[i+3] * (i+3);
+	}
+	for (; i < bins; ++i) {
+		psum[0] += power[i];
+		wsum[0] += power[i] * i;
+	}
+
+	float total = (psum[0] + psum[1]) + (psum[2] + psum[3]);
+	float weighted = (wsum[0] + wsum[1]) + (wsum[2] + wsum[3]);
+	
+	_energy = total * _scale;
+	_centroid = (total > 0.0f) ? (weighted / total) * _binHz : 0.0f;
+
+	// running sum for band energy lookups
+	for (i=0; i < bins; ++i) {
+		_cumPower[i+1] = _cumPower[i] + power[i];
+	}
+	
+	// flux from the magnitudes
+	FTutils::vector_fast_square_root (power, _mag, bins);
+
+	if (_fresh) {
+		_flux = 0.0f;
+		_fresh = false;
+	}
+	else {
+		float rise[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float msum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float d;
+		
+		for (i=0; i < n4; i += 4) {
+			d = _mag[i] - _lastMag[i];     rise[0] += d > 0.0f ? d : 0.0f;
+			d = _mag[i+1] - _lastMag[i+1]; rise[1] += d > 0.0f ? d : 0.0f;
+			d = _mag[i+2] - _lastMag[i+2]; rise[2] += d > 0.0f ? d : 0.0f;
+			d = _mag[i+3] - _lastMag[i+3]; rise[3] += d > 0.0f ? d : 0.0f;
+			msum[0] += _mag[i];
+			msum[1] += _mag[i+1];
+			msum[2] += _mag[i+2];
+			msum[3] += _mag[i+3];
+		}
+		for (; i < bins; ++i) {
+			d = _mag[i] - _lastMag[i];
+			rise[0] += d > 0.0f ? d : 0.0f;
+			msum[0] += _mag[i];
+		}
+
+		float risen = (rise[0] + rise[1]) + (rise[2] + rise[3]);
+		float mag = (msum[0] + msum[1]) + (msum[2] + msum[3]);
+
+		_flux = (mag > 0.0f) ? risen / mag : 0.0f;
+	}
+
+	float * tmp = _lastMag;
+	_lastMag = _mag;
+	_mag = tmp;
+
+	// onsets are flux standing out from its recent average
+	_onset = _flux - _fluxAvg;
+	if (_onset < 0.0f) _onset = 0.0f;
+
+	_fluxAvg += (_flux - _fluxAvg) * (1.0f - expf (-_hopTime / FT_ONSET_AVERAGE_TIME));
+}
+
+float FTspectralFeatures::getBandEnergy (float minfreq, float maxfreq) const
+{
+	if (_bins <= 0 || _binHz <= 0.0f) return 0.0f;
+	
+	int minbin = (int) (minfreq / _binHz);
+	int maxbin = (int) (maxfreq / _binHz);
+
+	if (minbin < 0) minbin = 0;
+	if (maxbin > _bins) maxbin = _bins;
+	if (maxbin <= minbin) return 0.0f;
+
+	return (float) (_cumPower[maxbin] - _cumPower[minbin]) * _scale;
+}
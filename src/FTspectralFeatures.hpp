@@ -0,0 +1,80 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+#ifndef __FTSPECTRALFEATURES_HPP__
+#define __FTSPECTRALFEATURES_HPP__
+
+#include "FTtypes.hpp"
+
+// A few measures of the input spectrum, worked out by the spectral
+// engine once a hop from that hop's power spectrum and shared by
+// every modulator that follows them.
+class FTspectralFeatures
+{
+  public:
+	FTspectralFeatures();
+	~FTspectralFeatures();
+
+	// power holds the fftn/2 - 1 bins from 0 up that the engine fills,
+	// hopsamps is the distance in samples from the previous call
+	void compute (const float * power, int fftn, nframes_t samplerate, int hopsamps);
+
+	// forget the last hop, so the next flux is not measured against
+	// something stale
+	void reset();
+
+	// power weighted mean frequency in Hz
+	float getCentroid() const { return _centroid; }
+
+	// magnitude gained since the last hop relative to the current
+	// magnitude, 0 for a steady sound
+	float getFlux() const { return _flux; }
+
+	// how much the flux rises above its recent average
+	float getOnset() const { return _onset; }
+
+	// total power, relative to a full scale signal
+	float getEnergy() const { return _energy; }
+
+	// power between minfreq and maxfreq Hz, relative to full scale
+	float getBandEnergy (float minfreq, float maxfreq) const;
+
+	// seconds between the last two hops
+	float getHopTime() const { return _hopTime; }
+	
+  protected:
+
+	float * _mag;
+	float * _lastMag;
+	double * _cumPower;
+
+	int _bins;
+	float _binHz;
+	float _scale;
+	float _hopTime;
+	bool _fresh;
+	
+	float _centroid;
+	float _flux;
+	float _fluxAvg;
+	float _onset;
+	float _energy;
+};
+
+#endif
@@ -22,14 +22,17 @@
 #endif
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <math.h>
 
 #include <algorithm>
 using namespace std;
 
 #include "FTspectrumModifier.hpp"
 #include "FTtypes.hpp"
+#include "FTutils.hpp"
 
 
 
@@ -37,16 +40,27 @@ using namespace std;
 FTspectrumModifier::FTspectrumModifier(const string &name, const string &configName, int group,
 				       FTspectrumModifier::ModifierType mtype, SpecModType smtype, int length, float initval)
 	:  _modType(mtype), _specmodType(smtype), _name(name), _configName(configName), _group(group),
-	   _values(0), _length(length), _linkedTo(0), _initval(initval),
-	   _id(0), _bypassed(false), _dirty(false), _extra_node(0)
+	   _store(0), _values(0), _edit(0), _spare(0), _pending(0), _retired(0), _writeFree(0), _writeFreeCount(0), _write(0), _writeSpare(0), _view(0), _source(0), _sourceValid(false), _current(0), _smoothTime(mtype == FREQ_MODIFIER ? 0.0f : FT_DEFAULT_SMOOTHING_TIME), _settled(true), _smoothVersion(0), _smoothFrame(0),
+	   _length(length), _linkedTo(0), _initval(initval),
+	   _id(0), _bypassed(false), _dirty(false), _version(0),
+	   _rotStart(0), _rotEnd(0), _rotOffset(0), _rotTotal(0), _rotRegion(1),
+	   _rotQueued(false), _queuedStart(0), _queuedEnd(0), _queuedShift(0), _viewVersion(0), _viewSeq(0),
+	   _routeVersion(0), _routeSumVersion(0), _effective(0), _routeSteps(0), _modulated(false), _extra_node(0)
 
 {
-	_values = new float[FT_MAX_FFT_SIZE/2];
-	_tmpvalues = new float[FT_MAX_FFT_SIZE/2];
+	setStore (newStore (_length));
+	allocWorkspace (_length);
+	allocWriteStores (_length);
 
-	for (int i=0; i < FT_MAX_FFT_SIZE/2; i++)
+	for (int r=0; r < FT_MAX_ROUTES; r++) {
+		_routes[r].key = 0;
+		_routes[r].start = _routes[r].end = 0;
+		_routes[r].offset = 0.0f;
+	}
+
+	for (int i=0; i < _length; i++)
 	{
-		_values[i] = initval;
+		_values[i] = _current[i] = initval;
 	}
 
 }
@@ -61,9 +75,71 @@ FTspectrumModifier::~FTspectrumModifier()
 	unlink(true);
 	
 	//printf ("delete specmod\n");
-	delete [] _values;
-	delete [] _tmpvalues;
+	releaseStore (_edit);
+	releaseStore (_pending);
+	reclaimStores();
+	releaseStore (_spare);
+	releaseStore (_write);
+	releaseStore (_writeSpare);
+	allocWriteStores (0);
+	dropSource();
+	releaseStore (_store);
+	delete [] _current;
+	delete [] _effective;
+	delete [] _routeSteps;
+	delete [] _view;
+	
+}
+
+FTspectrumModifier::ValueStore * FTspectrumModifier::newStore (int length)
+{
+	ValueStore * store = (ValueStore *) malloc (sizeof(ValueStore) + (length - 1) * sizeof(float));
+	store->refs = 1;
+	store->length = length;
+	store->next = 0;
+	store->recycle = false;
+	store->rotRegion = 0;
+	store->rotTotal = 0;
+	return store;
+}
+
+void FTspectrumModifier::releaseStore (ValueStore * store)
+{
+	if (store && __sync_sub_and_fetch (&store->refs, 1) == 0) {
+		free (store);
+	}
+}
+
+void FTspectrumModifier::setStore (ValueStore * store)
+{
+	// takes over the caller's reference
+	ValueStore * old = _store;
+	_store = store;
+	_values = store->values;
+	releaseStore (old);
+}
+
+void FTspectrumModifier::makeWritable()
+{
+	if (_store->refs == 1) return;
+
+	// someone we were linked to still has these
+	ValueStore * store = newStore (_length);
+	memcpy (store->values, _values, _length * sizeof(float));
+	setStore (store);
+}
+
+void FTspectrumModifier::allocWorkspace (int length)
+{
+	delete [] _current;
+	delete [] _effective;
+	delete [] _routeSteps;
+	delete [] _view;
 	
+	_current = new float[length];
+	_effective = new float[length];
+	_routeSteps = new float[length + 1];
+	_view = new float[length];
 }
 
 
@@ -87,22 +163,112 @@ void FTspectrumModifier::setLength(int length)
 {
 	int origlen = _length;
 	
-	if (length < FT_MAX_FFT_SIZE/2) {
-		_length = length;
+	if (length < FT_MAX_FFT_SIZE/2 && length != origlen) {
+		// not processing, the buffer for it is ours to make
+		reclaim();
+		applyRotation();
+		_rotStart = _rotEnd = 0;
+		++_rotRegion;
+		_rotQueued = false;
 
-		// now resample existing values into new length
-		if (! _linkedTo)
-		{
-			float scale = origlen / (float) length;
-			for (int i=0; i < length; i++) {
-				_tmpvalues[i] = _values[(int)(i*scale)];
+		// a committed edit nobody has taken yet (a filter being
+		// loaded before it is processed) is the newest
+		ValueStore * pending = (ValueStore *) __sync_lock_test_and_set (&_pending, (ValueStore *) 0);
+
+		if (pending || !_source || !_sourceValid) {
+			// changed since we last rendered, what we have now
+			// is the curve to render from
+			dropSource();
+			if (pending) {
+				_source = pending;
+			}
+			else {
+				__sync_add_and_fetch (&_store->refs, 1);
+				_source = _store;
 			}
+		}
+		
+		// render it at the new length, unless we already have.  if
+		// we are linked these aren't used until we unlink, which
+		// shares theirs anyway
+		ValueStore * store = (_source->length == length) ? _source : 0;
+		for (unsigned int n=0; !store && n < _renders.size(); n++) {
+			if (_renders[n]->length == length) {
+				store = _renders[n];
+			}
+		}
+		if (!store) {
+			store = newStore (length);
+			FTutils::vector_resample (_source->values, _source->length, store->values, length);
 
-			memcpy(_values, _tmpvalues, length * sizeof(float));
+			if (_modType == FREQ_MODIFIER) {
+				// bin numbers, at the new size
+				float scale = length / (float) _source->length;
+				for (int i=0; i < length; i++) {
+					store->values[i] *= scale;
+				}
+			}
+			_renders.push_back (store);
 		}
+		// writers install a new store, it stays as it is
+		__sync_add_and_fetch (&store->refs, 1);
+
+		// not called while processing, readers don't need the old
+		// ones.  an unfinished edit for the old length is no good
+		_length = length;
+		setStore (store);
+		releaseStore (_edit);
+		releaseStore (_spare);
+		_edit = _spare = 0;
+		reclaimStores();
+		releaseStore (_spare);
+		_spare = 0;
+		releaseStore (_write);
+		_write = 0;
+		releaseStore (_writeSpare);
+		_writeSpare = 0;
+		allocWriteStores (length);
+		allocWorkspace (length);
+
+		// no point ramping between different resolutions
+		memcpy(_current, _values, length * sizeof(float));
+		_settled = true;
+		_modulated = false;
+		_routeSumVersion = _routeVersion - 1;
+
+		// smooth() would take the new version for an edit
+		++_version;
+		_smoothVersion = _version;
+		_sourceValid = true;
 	}
 }
 
+void FTspectrumModifier::dropSource()
+{
+	for (unsigned int n=0; n < _renders.size(); n++) {
+		releaseStore (_renders[n]);
+	}
+	_renders.clear();
+
+	releaseStore (_source);
+	_source = 0;
+}
+
+const float * FTspectrumModifier::getSourceValues (int & length)
+{
+	if (_linkedTo) {
+		return _linkedTo->getSourceValues (length);
+	}
+
+	if (_source && _sourceValid && !_edit && !_pending && _rotOffset == 0) {
+		length = _source->length;
+		return _source->values;
+	}
+
+	length = _length;
+	return getLatestValues();
+}
+
 
 bool FTspectrumModifier::link (FTspectrumModifier *specmod)
 {
@@ -122,6 +288,7 @@ bool FTspectrumModifier::link (FTspectrumModifier *specmod)
 	_linkedTo = specmod;
 
 	specmod->addedLinkFrom(this);
+	++_version;
 	
 	return true;
 }
@@ -131,8 +298,23 @@ void FTspectrumModifier::unlink (bool unlinksources)
 	if (_linkedTo) {
 		_linkedTo->removedLinkFrom ( this );
 
-		// copy their values into our internal
-		copy (_linkedTo);
+		// share their values if they aren't rotated, ours haven't
+		// been read since we linked.  the audio thread might be
+		// rotating theirs, or reusing one it wrote, so leave the
+		// stores alone otherwise
+		FTspectrumModifier * owner = _linkedTo->getValueOwner();
+
+		if (owner->_length == _length && !owner->_edit && !owner->_pending && owner->_rotOffset == 0
+		    && !owner->_store->recycle) {
+			__sync_add_and_fetch (&owner->_store->refs, 1);
+			setStore (owner->_store);
+			memcpy (_current, owner->_current, _length * sizeof(float));
+		}
+		else {
+			copy (owner);
+		}
+		_rotOffset = 0;
+		++_version;
 	}
 	_linkedTo = 0;
 
@@ -179,50 +361,763 @@ bool FTspectrumModifier::isLinkedFrom (FTspectrumModifier *specmod)
 }
 
 
-float * FTspectrumModifier::getValues()
+float * FTspectrumModifier::beginEdit()
 {
 	if (_linkedTo) {
-		return _linkedTo->getValues();
+		return _linkedTo->beginEdit();
+	}
+
+	if (_edit) {
+		// still going
+		return _edit->values;
+	}
+
+	reclaimStores();
+
+	if (_spare) {
+		_edit = _spare;
+		_spare = 0;
+	}
+	else {
+		_edit = newStore (_length);
 	}
 
-	return _values;
+	// start from our last commit if the audio thread hasn't got to
+	// it yet.  only we free it, even after it is taken
+	ValueStore * pending = _pending;
+	if (pending) {
+		memcpy (_edit->values, pending->values, _length * sizeof(float));
+		_edit->rotRegion = pending->rotRegion;
+		_edit->rotTotal = pending->rotTotal;
+	}
+	else {
+		readView (_edit);
+	}
+	
+	return _edit->values;
 }
 
-void FTspectrumModifier::reset()
+void FTspectrumModifier::commitEdit()
 {
-	float *data;
+	if (_linkedTo) {
+		_linkedTo->commitEdit();
+		return;
+	}
 
-	if (getModifierType() == FREQ_MODIFIER)
-	{
-		float incr = (_max - _min) / _length;
-		float val = _min;
+	if (!_edit) return;
+
+	// the values have to be there before the pointer is
+	__sync_synchronize();
+	ValueStore * old = (ValueStore *) __sync_lock_test_and_set (&_pending, _edit);
+	_edit = 0;
+
+	// replaced before the audio thread took it
+	if (old && !_spare) {
+		_spare = old;
+	}
+	else {
+		releaseStore (old);
+	}
+
+	// let the graphs follow along
+	_dirty = true;
+}
+
+const float * FTspectrumModifier::getLatestValues()
+{
+	if (_linkedTo) {
+		return _linkedTo->getLatestValues();
+	}
+
+	if (_edit) {
+		return _edit->values;
+	}
+
+	// only reclaimStores() frees it once the audio thread has it
+	ValueStore * pending = _pending;
+	if (pending) {
+		return pending->values;
+	}
+
+	readView (_view);
+	return _view;
+}
+
+float * FTspectrumModifier::beginWrite()
+{
+	if (_linkedTo) {
+		return _linkedTo->beginWrite();
+	}
+
+	if (!_write) {
+		ValueStore * store = takeWriteStore (1);
+		if (!store) return 0;
+
+		// on top of the latest gui edit
+		takeEdit();
+		readView (store);
+		_write = store;
+	}
+	
+	return _write->values;
+}
+
+void FTspectrumModifier::endWrite()
+{
+	if (_linkedTo) {
+		_linkedTo->endWrite();
+		return;
+	}
+
+	if (!_write) return;
+
+	installStore (_write);
+	_write = 0;
+}
+
+void FTspectrumModifier::takeEdit()
+{
+	if (!_pending) return;
+
+	ValueStore * store = (ValueStore *) __sync_lock_test_and_set (&_pending, (ValueStore *) 0);
+	if (store) {
+		installStore (store);
+	}
+}
+
+void FTspectrumModifier::installStore (ValueStore * store)
+{
+	int len = _rotEnd - _rotStart;
+	int residual = 0;
+	
+	if (store->rotRegion == _rotRegion && len > 0) {
+		// rotated this far since it was read (a gui edit can be a
+		// few hops old), which it keeps on doing from here
+		residual = (_rotTotal - store->rotTotal + len) % len;
+	}
+
+	// the values have to be there before the pointer is
+	beginViewChange();
+
+	if (_rotOffset != residual) {
+		// the store is the view it was read at, bring the smoothed
+		// and modulated copies in line with it
+		int shift = (_rotOffset - residual + len) % len;
+		std::rotate (_current + _rotStart, _current + _rotEnd - shift, _current + _rotEnd);
+		std::rotate (_effective + _rotStart, _effective + _rotEnd - shift, _effective + _rotEnd);
+		_rotOffset = residual;
+		++_viewVersion;
+	}
+
+	ValueStore * old = _store;
+	_store = store;
+	_values = store->values;
+	endViewChange();
+
+	// nothing on this thread is reading the old one any more.  our
+	// own go straight back to the writer, the gui frees the rest
+	if (old->recycle && old->refs == 1 && old->length == _length) {
+		old->next = _writeFree;
+		_writeFree = old;
+		++_writeFreeCount;
+	}
+	else {
+		do {
+			old->next = _retired;
+		} while (!__sync_bool_compare_and_swap (&_retired, old->next, old));
+	}
+	
+	++_version;
+	_dirty = true;
+	_sourceValid = false;
+}
+
+void FTspectrumModifier::reclaimStores()
+{
+	ValueStore * store = (ValueStore *) __sync_lock_test_and_set (&_retired, (ValueStore *) 0);
+
+	while (store) {
+		ValueStore * next = store->next;
+
+		if (store->refs != 1 || store->length != _length) {
+			releaseStore (store);
+		}
+		else if (!_spare) {
+			// the back buffer for the next edit
+			store->recycle = false;
+			_spare = store;
+		}
+		else if (!__sync_bool_compare_and_swap (&_writeSpare, (ValueStore *) 0, store)) {
+			releaseStore (store);
+		}
+		store = next;
+	}
+}
+
+void FTspectrumModifier::reclaim()
+{
+	reclaimStores();
+
+	if (!_writeSpare) {
+		// in case the writer runs short.  the audio thread only
+		// ever takes it, so nobody else puts one back meanwhile
+		_writeSpare = newStore (_length);
+	}
+}
+
+FTspectrumModifier::ValueStore * FTspectrumModifier::takeWriteStore (int keep)
+{
+	ValueStore * store;
+	
+	if (_writeFreeCount > keep) {
+		store = _writeFree;
+		_writeFree = store->next;
+		--_writeFreeCount;
+	}
+	else {
+		// we lost some to whoever still shares them, make do
+		// with the one the gui keeps topped up
+		store = (ValueStore *) __sync_lock_test_and_set (&_writeSpare, (ValueStore *) 0);
+		if (!store) return 0;
+		store->recycle = true;
+	}
+
+	store->next = 0;
+	return store;
+}
+
+void FTspectrumModifier::allocWriteStores (int length)
+{
+	while (_writeFree) {
+		ValueStore * next = _writeFree->next;
+		releaseStore (_writeFree);
+		_writeFree = next;
+	}
+	_writeFreeCount = 0;
+
+	for (int n=0; length > 0 && n < FT_WRITE_STORES; n++) {
+		ValueStore * store = newStore (length);
+		store->recycle = true;
+		store->next = _writeFree;
+		_writeFree = store;
+		++_writeFreeCount;
+	}
+}
+
+void FTspectrumModifier::readView (float * dest, bool modulated)
+{
+	unsigned int seq;
+	
+	// the audio thread might be rotating or switching stores, go
+	// again if it did while we looked
+	do {
+		seq = _viewSeq;
+		__sync_synchronize();
 		
-		if (_linkedTo) {
-			data = _linkedTo->getValues();
-			for (int i=0; i < _length; i++) {
-				_values[i] = data[i] = val;
-				val += incr;
-			}
+		const float * src = modulated ? _effective : _values;
+		int start = _rotStart;
+		int end = _rotEnd;
+		int offset = _rotOffset;
+
+		memcpy (dest, src, _length * sizeof(float));
+
+		if (offset > 0 && start >= 0 && end <= _length && offset < end - start) {
+			std::rotate_copy (src + start, src + end - offset, src + end, dest + start);
 		}
-		else {
-			for (int i=0; i < _length; i++) {
-				_values[i] = val;
-				val += incr;
+
+		__sync_synchronize();
+	} while ((seq & 1) || seq != _viewSeq);
+}
+
+void FTspectrumModifier::readView (ValueStore * store)
+{
+	unsigned int seq;
+	
+	do {
+		seq = _viewSeq;
+		__sync_synchronize();
+		
+		store->rotRegion = _rotRegion;
+		store->rotTotal = _rotTotal;
+		readView (store->values);
+		
+		__sync_synchronize();
+	} while ((seq & 1) || seq != _viewSeq);
+}
+
+bool FTspectrumModifier::applyRotation()
+{
+	if (_rotOffset == 0) return true;
+
+	// beginWrite() leaves us the last one
+	ValueStore * store = takeWriteStore (0);
+
+	if (store) {
+		// the gui might be reading the old values, they stay as
+		// they are.  getActiveRanges() results move, installing
+		// bumps the version
+		readView (store);
+		installStore (store);
+		return true;
+	}
+
+	if (!_store->recycle || _store->refs != 1) {
+		// a gui edit, it might still be looking at it
+		return false;
+	}
+
+	// ours and only ours, the gui only sees it through readView()
+	int shift = _rotOffset;
+	
+	beginViewChange();
+	std::rotate (_values + _rotStart, _values + _rotEnd - shift, _values + _rotEnd);
+	std::rotate (_current + _rotStart, _current + _rotEnd - shift, _current + _rotEnd);
+	std::rotate (_effective + _rotStart, _effective + _rotEnd - shift, _effective + _rotEnd);
+	_rotOffset = 0;
+	_store->rotRegion = _rotRegion;
+	_store->rotTotal = _rotTotal;
+	endViewChange();
+
+	++_viewVersion;
+	++_version;
+	_dirty = true;
+	_sourceValid = false;
+	return true;
+}
+
+bool FTspectrumModifier::setRotRegion (int start, int end)
+{
+	if (start == _rotStart && end == _rotEnd) return true;
+
+	// only one region is kept, settle the old one
+	if (!applyRotation()) return false;
+
+	beginViewChange();
+	_rotStart = start;
+	_rotEnd = end;
+	_rotTotal = 0;
+	++_rotRegion;
+	endViewChange();
+	return true;
+}
+
+void FTspectrumModifier::shiftRotation (int shift)
+{
+	int len = _rotEnd - _rotStart;
+	
+	beginViewChange();
+	_rotOffset = (_rotOffset + shift + len) % len;
+	_rotTotal = (_rotTotal + shift + len) % len;
+	endViewChange();
+
+	++_viewVersion;
+
+	if (_modulated) {
+		// the routes stay where they show up, resum
+		__sync_add_and_fetch (&_routeVersion, 1);
+	}
+
+	// let the graphs follow along
+	_dirty = true;
+}
+
+bool FTspectrumModifier::flushRotation()
+{
+	if (!_rotQueued) return true;
+	if (!setRotRegion (_queuedStart, _queuedEnd)) return false;
+
+	_rotQueued = false;
+	shiftRotation (_queuedShift);
+	return true;
+}
+
+void FTspectrumModifier::rotate (int start, int end, int shift)
+{
+	if (_linkedTo) {
+		_linkedTo->rotate (start, end, shift);
+		return;
+	}
+
+	if (start < 0) start = 0;
+	if (end > _length) end = _length;
+
+	int len = end - start;
+	if (len <= 0) return;
+
+	shift %= len;
+
+	if (!flushRotation() || !setRotRegion (start, end)) {
+		// nowhere to settle the old region yet, the new one waits
+		// for the next hop.  a newer one replaces one that never
+		// showed, the old region keeps its offset either way
+		if (!_rotQueued || start != _queuedStart || end != _queuedEnd) {
+			_queuedStart = start;
+			_queuedEnd = end;
+			_queuedShift = 0;
+		}
+		_rotQueued = true;
+		_queuedShift = (_queuedShift + shift) % len;
+		return;
+	}
+
+	shiftRotation (shift);
+}
+
+void FTspectrumModifier::setSmoothingTime (float secs)
+{
+	if (_linkedTo) {
+		_linkedTo->setSmoothingTime (secs);
+		return;
+	}
+
+	if (secs > 0.0f && _smoothTime <= 0.0f) {
+		// start off where the values are now
+		memcpy (_current, _modulated ? _effective : _values, _length * sizeof(float));
+		_settled = true;
+	}
+	
+	_smoothTime = secs > 0.0f ? secs : 0.0f;
+	++_viewVersion;
+}
+
+void FTspectrumModifier::settle()
+{
+	if (_linkedTo) {
+		_linkedTo->settle();
+		return;
+	}
+
+	takeEdit();
+	reclaim();
+	flushRotation();
+	applyRotation();
+	
+	sumRoutes (true);
+	memcpy (_current, _modulated ? _effective : _values, _length * sizeof(float));
+	_settled = true;
+	_smoothVersion = _version;
+	++_viewVersion;
+}
+
+void FTspectrumModifier::smooth (nframes_t now, nframes_t samplerate)
+{
+	if (_linkedTo) {
+		_linkedTo->smooth (now, samplerate);
+		return;
+	}
+
+	// a hop boundary, a good time to switch to a gui edit and do
+	// a held back rotation
+	takeEdit();
+	flushRotation();
+	
+	bool edited = (_version != _smoothVersion);
+	bool routed = sumRoutes (edited);
+	const float * target = _modulated ? _effective : _values;
+	
+	if (_smoothTime <= 0.0f) {
+		if (routed) {
+			// Readers follow _current while modulated
+			memcpy (_current, target, _length * sizeof(float));
+			++_viewVersion;
+		}
+		_smoothVersion = _version;
+		return;
+	}
+
+	nframes_t elapsed = now - _smoothFrame;
+	_smoothFrame = now;
+	
+	if (edited || routed) {
+		if (_settled) {
+			// a new target, start ramping.  bump the version so
+			// cached active ranges get recomputed for the ramp
+			_settled = false;
+			++_version;
+		}
+		_smoothVersion = _version;
+	}
+
+	if (_settled || elapsed == 0) return;
+
+	// one pole towards the target, time based so it doesn't matter
+	// how many hops or engines share this filter.  a big jump in
+	// time (or back) just settles
+	float coeff = 1.0f - expf (- (float) elapsed / (_smoothTime * samplerate));
+	float tolerance = (_max - _min) * 1e-4f;
+	float diff, maxdiff = 0.0f;
+	
+	for (int i=0; i < _length; i++)
+	{
+		diff = target[i] - _current[i];
+		_current[i] += diff * coeff;
+		diff = fabsf (diff);
+		maxdiff = diff > maxdiff ? diff : maxdiff;
+	}
+
+	if (maxdiff * (1.0f - coeff) <= tolerance) {
+		memcpy (_current, target, _length * sizeof(float));
+		_settled = true;
+
+		// ranges can be exact again
+		++_version;
+		_smoothVersion = _version;
+	}
+	
+	++_viewVersion;
+}
+
+void FTspectrumModifier::setRoute (const void * key, int start, int end, float offset)
+{
+	if (_linkedTo) {
+		_linkedTo->setRoute (key, start, end, offset);
+		return;
+	}
+
+	Route * route = 0;
+	Route * unused = 0;
+	
+	for (int r=0; r < FT_MAX_ROUTES; r++) {
+		if (_routes[r].key == key) {
+			route = &_routes[r];
+			break;
+		}
+		else if (!_routes[r].key && !unused) {
+			unused = &_routes[r];
+		}
+	}
+
+	if (!route) {
+		if (!unused || offset == 0.0f) return;
+		route = unused;
+		route->offset = 0.0f;
+		route->key = key;
+	}
+
+	if (route->start == start && route->end == end && route->offset == offset) {
+		return;
+	}
+
+	route->start = start;
+	route->end = end;
+	route->offset = offset;
+	++_routeVersion;
+}
+
+void FTspectrumModifier::clearRoute (const void * key)
+{
+	if (_linkedTo) {
+		_linkedTo->clearRoute (key);
+	}
+
+	// could have been set before we were linked
+	for (int r=0; r < FT_MAX_ROUTES; r++) {
+		if (_routes[r].key == key) {
+			_routes[r].key = 0;
+			__sync_synchronize();
+			__sync_add_and_fetch (&_routeVersion, 1);
+		}
+	}
+}
+
+bool FTspectrumModifier::sumRoutes (bool edited)
+{
+	unsigned int rversion = _routeVersion;
+	
+	if (rversion == _routeSumVersion && !(_modulated && edited)) {
+		return false;
+	}
+
+	_routeSumVersion = rversion;
+
+	// each route is a step up at start and back down at end, so
+	// one running sum covers any number of them
+	memset (_routeSteps, 0, (_length + 1) * sizeof(float));
+
+	bool any = false;
+	
+	for (int r=0; r < FT_MAX_ROUTES; r++) {
+		const Route & route = _routes[r];
+		if (!route.key || route.offset == 0.0f) continue;
+
+		int start = route.start < 0 ? 0 : route.start;
+		int end = route.end > _length ? _length : route.end;
+		if (end <= start) continue;
+
+		_routeSteps[start] += route.offset;
+		_routeSteps[end] -= route.offset;
+		any = true;
+	}
+
+	if (any) {
+		float run = 0.0f;
+		for (int i=0; i < _length; i++) {
+			run += _routeSteps[i];
+			_routeSteps[i] = run;
+		}
+
+		beginViewChange();
+		for (int i=0; i < _length; i++) {
+			_effective[i] = _values[i] + _routeSteps[i];
+		}
+
+		if (_rotOffset != 0) {
+			// route bins are where they show up, inside the rotated
+			// region stored bin j shows up _rotOffset bins on
+			int len = _rotEnd - _rotStart;
+			for (int j = _rotStart; j < _rotEnd; j++) {
+				int k = j + _rotOffset;
+				if (k >= _rotEnd) k -= len;
+				_effective[j] = _values[j] + _routeSteps[k];
 			}
 		}
+		endViewChange();
+	}
+
+	bool changed = any || _modulated;
+
+	if (any != _modulated) {
+		// getActiveRanges() answers differently
+		_modulated = any;
+		++_version;
+	}
+	
+	if (changed) {
+		// let the graphs follow along
+		_dirty = true;
+	}
+	
+	return changed;
+}
+
+const float * FTspectrumModifier::getModulatedValues()
+{
+	FTspectrumModifier * owner = getValueOwner();
+
+	if (owner->_edit || owner->_pending || !owner->_modulated) {
+		// show an edit straight away
+		return getLatestValues();
+	}
+
+	owner->readView (owner->_view, true);
+	return owner->_view;
+}
+
+FTspectrumModifier::Reader::Reader (FTspectrumModifier * specmod)
+{
+	FTspectrumModifier * owner = specmod->getValueOwner();
+
+	_values = (owner->_smoothTime > 0.0f || owner->_modulated) ? owner->_current : owner->_values;
+	_start = owner->_rotStart;
+
+	if (owner->_rotOffset != 0) {
+		_len = owner->_rotEnd - owner->_rotStart;
+		_shift = _len - owner->_rotOffset;
 	}
 	else {
-		if (_linkedTo) {
-			data = _linkedTo->getValues();
-			for (int i=0; i < _length; i++) {
-				_values[i] = data[i] = _initval;
-			}
+		_len = 0;
+		_shift = 0;
+	}
+}
+
+void FTspectrumModifier::Reader::mapRanges (const RangeList & stored, RangeList & bins) const
+{
+	bins.clear();
+	
+	if (_len == 0) {
+		bins.insert (bins.end(), stored.begin(), stored.end());
+		return;
+	}
+
+	int end = _start + (int) _len;
+	int offset = (int) (_len - _shift);
+	
+	for (RangeList::const_iterator r = stored.begin(); r != stored.end(); ++r)
+	{
+		// the parts outside the rotated region stay put
+		if (r->start < _start) {
+			bins.push_back (BinRange (r->start, r->end < _start ? r->end : _start));
+		}
+		if (r->end > end) {
+			bins.push_back (BinRange (r->start > end ? r->start : end, r->end));
+		}
+
+		int a = r->start > _start ? r->start : _start;
+		int b = r->end < end ? r->end : end;
+		if (a >= b) continue;
+
+		a += offset;
+		b += offset;
+		if (a >= end) {
+			bins.push_back (BinRange (a - _len, b - _len));
+		}
+		else if (b > end) {
+			bins.push_back (BinRange (a, end));
+			bins.push_back (BinRange (_start, b - _len));
 		}
 		else {
-			for (int i=0; i < _length; i++) {
-				_values[i] = _initval;
+			bins.push_back (BinRange (a, b));
+		}
+	}
+
+	mergeRanges (bins);
+}
+
+static bool range_less (const FTspectrumModifier::BinRange & a, const FTspectrumModifier::BinRange & b)
+{
+	return a.start < b.start;
+}
+
+void FTspectrumModifier::reserveRanges (RangeList & ranges)
+{
+	// a run and the gap after it take two bins, mapping splits up to
+	// three more and two lists may be merged into one
+	ranges.reserve (FT_MAX_FFT_SIZE_HALF + 8);
+}
+
+void FTspectrumModifier::mergeRanges (RangeList & ranges)
+{
+	if (ranges.size() < 2) return;
+	
+	sort (ranges.begin(), ranges.end(), range_less);
+	
+	unsigned int last = 0;
+	for (unsigned int n = 1; n < ranges.size(); n++) {
+		if (ranges[n].start <= ranges[last].end) {
+			if (ranges[n].end > ranges[last].end) {
+				ranges[last].end = ranges[n].end;
 			}
 		}
+		else {
+			ranges[++last] = ranges[n];
+		}
+	}
+	ranges.resize (last + 1, ranges[0]);
+}
+
+void FTspectrumModifier::reset()
+{
+	// one edit like any other, the audio thread might be reading
+	fillDefaults (beginEdit());
+	commitEdit();
+}
+
+void FTspectrumModifier::fillDefaults (float * data)
+{
+	if (getModifierType() == FREQ_MODIFIER)
+	{
+		float incr = (_max - _min) / _length;
+		float val = _min;
+		
+		for (int i=0; i < _length; i++) {
+			data[i] = val;
+			val += incr;
+		}
+	}
+	else {
+		for (int i=0; i < _length; i++) {
+			data[i] = _initval;
+		}
 	}
 }
 
@@ -232,9 +1127,67 @@ void FTspectrumModifier::copy (FTspectrumModifier *specmod)
 	// this always copies into our internal values
 	if (!specmod) return;
 	
-	float * othervals = specmod->getValues();
+	const float * othervals = specmod->getLatestValues();
+	int len = specmod->getLength() < _length ? specmod->getLength() : _length;
+
+	_rotOffset = 0;
+	makeWritable();
+	memcpy (_values, othervals, len * sizeof(float));
+	++_version;
+	_sourceValid = false;
+}
+
+int FTspectrumModifier::getActiveRanges (float identval, RangeList & ranges, int mingap)
+{
+	FTspectrumModifier * owner = getValueOwner();
+	
+	if (!owner->_settled || owner->_modulated) {
+		ranges.clear();
+		ranges.push_back (BinRange (0, _length));
+		return _length;
+	}
+	
+	// the stored order, so a rotation doesn't need a rescan
+	float * values = owner->_values;
+	float tolerance = (_max - _min) * 1e-6f;
+	float val;
+	int start = -1;
+	int covered = 0;
+	
+	ranges.clear();
+
+	for (int i=0; i <= _length; i++)
+	{
+		bool active = false;
+		
+		if (i < _length) {
+			val = values[i];
+			if (val < _min) val = _min;
+			else if (val > _max) val = _max;
+
+			active = (val - identval > tolerance || identval - val > tolerance);
+		}
+		
+		if (active) {
+			if (start < 0) {
+				start = i;
+			}
+		}
+		else if (start >= 0) {
+			// end of a run, merge with the last if close enough
+			if (!ranges.empty() && start - ranges.back().end < mingap) {
+				covered += i - ranges.back().end;
+				ranges.back().end = i;
+			}
+			else {
+				covered += i - start;
+				ranges.push_back (BinRange (start, i));
+			}
+			start = -1;
+		}
+	}
 
-	memcpy (_values, othervals, _length * sizeof(float));
+	return covered;
 }
 
 XMLNode * FTspectrumModifier::getExtraNode()
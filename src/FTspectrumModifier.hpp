@@ -26,8 +26,18 @@
 
 #include <string>
 #include <list>
+#include <vector>
 using namespace std;
 
+// default time constant of the parameter smoothing, in seconds
+#define FT_DEFAULT_SMOOTHING_TIME 0.02f
+
+// modulation routes a filter can take at once
+#define FT_MAX_ROUTES 16
+
+// stores the audio thread keeps for its own writes, one of them held
+// back for settling a rotation
+#define FT_WRITE_STORES 3
 
 
 class FTspectrumModifier
@@ -53,6 +63,42 @@ class FTspectrumModifier
 	  	virtual ~Listener() {}
 		virtual void goingAway(FTspectrumModifier * ft) = 0;
 	};
+
+	// a run of bins [start, end)
+	struct BinRange {
+		BinRange (int s, int e) : start(s), end(e) {}
+		int start;
+		int end;
+	};
+	typedef vector<BinRange> RangeList;
+
+	// Reads values as they are after any pending rotation (see
+	// rotate()) without moving them.  Processors make one of these
+	// per hop instead of copying them
+	class Reader {
+	  public:
+		Reader (FTspectrumModifier * specmod);
+		
+		float operator[] (int i) const {
+			unsigned int k = (unsigned int) (i - _start);
+			if (k < _len) {
+				k += _shift;
+				if (k >= _len) k -= _len;
+				return _values[_start + k];
+			}
+			return _values[i];
+		}
+
+		// maps ranges from getActiveRanges() onto the bins they
+		// currently show up at, sorted and merged
+		void mapRanges (const RangeList & stored, RangeList & bins) const;
+		
+	  private:
+		const float * _values;
+		int _start;
+		unsigned int _len;
+		unsigned int _shift;
+	};
 	
 	
 	FTspectrumModifier(const string & name, const string &configName, int group,
@@ -63,6 +109,12 @@ class FTspectrumModifier
 	void setId (int id) { _id = id; }
 	int getId () { return _id; }
 	
+	// Renders the values at another number of bins, band-limited (see
+	// FTutils::vector_resample).  The curve at the size it was last
+	// changed at is kept along with each size rendered from it, so
+	// going back to a size is lossless and changing again is a swap.
+	// FREQ_MODIFIER values are bin numbers and get scaled to the new
+	// size too
 	void setLength(int length);
 	int getLength() { return _length; }
 
@@ -75,7 +127,29 @@ class FTspectrumModifier
 	int getGroup() { return _group; }
 	void setGroup(int grp) { _group = grp; }
 	
-	float * getValues();
+	// Tear free editing for the gui.  beginEdit() returns a private
+	// copy of the values to change and commitEdit() hands over the
+	// whole edit, which the audio thread switches to at its next hop
+	// (in smooth()), so processors never see half a curve.  Until
+	// then getLatestValues() shows it.  Nobody writes into the values
+	// in place, a store is only read once it is installed
+	float * beginEdit();
+	void commitEdit();
+
+	// the values as a Reader sees them (or the edit it is about to),
+	// for the gui.  a copy, good until the next call
+	const float * getLatestValues();
+
+	// The audio thread's writer, for modulators.  beginWrite() hands
+	// out a preallocated copy of the values to change and endWrite()
+	// switches to it.  The audio thread recycles the stores it wrote
+	// itself, so every hop can write.  Neither allocates or frees
+	float * beginWrite();
+	void endWrite();
+
+	// gui side, frees the stores the audio thread let go of and tops
+	// up the writer if it lost any to sharing.  called every so often
+	void reclaim();
 
 	ModifierType getModifierType() { return _modType; }
 	SpecModType getSpecModifierType() { return _specmodType; }
@@ -90,9 +164,10 @@ class FTspectrumModifier
 	float getMax() const { return _max;}
 
 
-	void setBypassed (bool flag) { _bypassed = flag; }
+	void setBypassed (bool flag) { _bypassed = flag; ++_version; }
 	bool getBypassed () { return _bypassed; }
 
+	// asks the graphs for a redraw, changes go through the writers
 	void setDirty (bool val) { _dirty = val; }
 	// this is as close of a test-and-set as I need
 	bool getDirty (bool tas=false, bool val=false)
@@ -110,11 +185,85 @@ class FTspectrumModifier
 			return false;
 		}
 
+
+	// changes whenever the values, bypass state or link changes
+	unsigned int getVersion() {
+		return _linkedTo ? _version + _linkedTo->getVersion() : _version;
+	}
+
+	// Rotates the bins [start, end) right by shift bins (left if
+	// negative), wrapping at the ends.  Audio thread only.  Only an
+	// offset is kept, the values are moved into a new store when the
+	// region changes (or rotated where they are if nobody else can see
+	// them, or the change waits for the next hop if neither can be
+	// done yet).  This doesn't change the version, use getViewVersion()
+	void rotate (int start, int end, int shift);
+
+	// Parameter smoothing.  The values are the target, a Reader
+	// sees a copy that follows it with this time constant so jumps
+	// from modulators or the gui don't zipper.  0 turns it off, which
+	// is the default for FREQ_MODIFIER filters: a processor using bin
+	// numbers rebuilds its tables whenever they move
+	void setSmoothingTime (float secs);
+	float getSmoothingTime() { return _linkedTo ? _linkedTo->getSmoothingTime() : _smoothTime; }
+
+	// moves the smoothed copy on to frame now.  called once per hop
+	// for every filter in use, repeat calls for the same frame (from
+	// linked or shared filters) don't advance it further
+	void smooth (nframes_t now, nframes_t samplerate);
+
+	// takes any committed edit and jumps the smoothed copy straight
+	// onto it.  only for filters nobody is processing yet
+	void settle();
+	
+	// Modulation routes.  A modulator keeps an offset over the bins
+	// [start, end) in a slot here, under any key it likes.  smooth()
+	// adds all the offsets onto the values in one pass whenever one
+	// changes, so modulators sharing a filter add up in any order
+	// and getLatestValues() never sees them.  setRoute() is for the audio
+	// thread, clearRoute() for the gui once that modulator has
+	// stopped calling setRoute()
+	void setRoute (const void * key, int start, int end, float offset);
+	void clearRoute (const void * key);
+
+	// what the processors see before smoothing, for drawing
+	const float * getModulatedValues();
+	
+	// changes on every rotate() and smoothing step, when a Reader
+	// would see something else while the version stays the same
+	unsigned int getViewVersion() {
+		return _linkedTo ? _linkedTo->getViewVersion() : _viewVersion;
+	}
+
+	// collects the runs of bins whose value (clamped to our range)
+	// differs from identval.  runs closer than mingap bins are merged.
+	// returns the number of bins covered.  The ranges ignore any
+	// pending rotation, pass them through Reader::mapRanges().
+	// While smoothing is still moving or routes are modulating it,
+	// the whole length is returned
+	int getActiveRanges (float identval, RangeList & ranges, int mingap=16);
+
+	// sorts and coalesces overlapping or touching ranges
+	static void mergeRanges (RangeList & ranges);
+
+	// makes room for as many ranges as the above can come up with at
+	// any length, so a processor's lists never allocate on the audio
+	// thread.  call once when setting up
+	static void reserveRanges (RangeList & ranges);
 	
 	// resets all bins to constructed value
 	void reset();
+	// writes the constructed values into data, getLength() bins
+	void fillDefaults (float * data);
 
+	// writes specmod's values into ours
 	void copy (FTspectrumModifier *specmod);
+
+	// the curve setLength() last rendered from, at the size it was
+	// changed at, if the values are still that render.  otherwise
+	// getLatestValues() at getLength().  what presets store, so a
+	// preset saved while running a smaller size keeps the detail
+	const float * getSourceValues (int & length);
 	
 	list<FTspectrumModifier*> & getLinkedFrom() { return _linkedFrom; }
 
@@ -132,6 +281,77 @@ class FTspectrumModifier
 
 	void addedLinkFrom (FTspectrumModifier * specmod);
 	void removedLinkFrom (FTspectrumModifier * specmod);
+
+	// the array that actually holds our values and its owner
+	FTspectrumModifier * getValueOwner() { return _linkedTo ? _linkedTo->getValueOwner() : this; }
+
+	// Reference counted value array.  Unlinking shares the one we
+	// were linked to instead of copying it and setLength() shares its
+	// renders.  Writers always install a new one, so a shared store is
+	// never changed under anyone
+	struct ValueStore {
+		volatile int refs;
+		int length;
+		ValueStore * next; // on _retired or _writeFree
+		// one of the writer's, it goes back to _writeFree once
+		// replaced if nobody shares it
+		bool recycle;
+		// the rotation it was read at, see installStore()
+		unsigned int rotRegion;
+		int rotTotal;
+		float values[1];
+	};
+
+	static ValueStore * newStore (int length);
+	static void releaseStore (ValueStore * store);
+	void setStore (ValueStore * store);
+	// forks _store if it is shared.  gui side, only while nobody is
+	// processing us
+	void makeWritable();
+	// (re)allocates the smoothing, route and view arrays for length bins
+	void allocWorkspace (int length);
+	// forgets _source and its renders
+	void dropSource();
+
+	// audio side, switches to a committed edit
+	void takeEdit();
+	// audio side, makes store the values and retires the old ones.
+	// rotation since the store was read carries on from it
+	void installStore (ValueStore * store);
+	// gui side, drops or recycles the arrays takeEdit() replaced
+	void reclaimStores();
+	// copies the values (or with modulated, _effective) as a Reader
+	// sees them, without moving them.  from any thread
+	void readView (float * dest, bool modulated=false);
+	// the same into a store, noting the rotation it was read at
+	void readView (ValueStore * store);
+
+	// audio side, brackets changes to what readView() reads
+	void beginViewChange() { ++_viewSeq; __sync_synchronize(); }
+	void endViewChange() { __sync_synchronize(); ++_viewSeq; }
+
+	// audio side, a store for the writer, leaving keep of them for
+	// applyRotation().  0 if there are none left to take
+	ValueStore * takeWriteStore (int keep);
+	// (re)fills _writeFree with FT_WRITE_STORES of length, 0 just
+	// frees them.  only while nobody is processing us
+	void allocWriteStores (int length);
+
+	// audio side, installs the rotated values as a new store, or
+	// rotates them in place if they are one of the writer's nobody
+	// shares.  false if neither can be done
+	bool applyRotation();
+	// audio side, moves the rotation to [start, end), false if the
+	// old region couldn't be settled
+	bool setRotRegion (int start, int end);
+	// audio side, adds shift to the current region's offset
+	void shiftRotation (int shift);
+	// audio side, does a region change rotate() had to hold back.
+	// false if it still can't
+	bool flushRotation();
+	// brings _effective up to date, true if it changed.  edited
+	// says the values changed since the last call
+	bool sumRoutes (bool edited);
 	
 	ModifierType _modType;
 	SpecModType _specmodType;
@@ -140,10 +360,40 @@ class FTspectrumModifier
 	string _configName;
 	int _group;
 	
-	// might point to a linked value array
+	// _store->values, possibly shared with filters we were linked to
+	ValueStore * _store;
 	float * _values;
 
-	float * _tmpvalues; // used for copying
+	// gui edit in progress and a spare for the next, the committed
+	// one the audio thread hasn't taken yet, and fronts it has let go of
+	ValueStore * _edit;
+	ValueStore * _spare;
+	ValueStore * volatile _pending;
+	ValueStore * volatile _retired;
+
+	// the audio thread's stores for beginWrite() and applyRotation(),
+	// the write in progress, and one from the gui if it ran short
+	ValueStore * _writeFree;
+	int _writeFreeCount;
+	ValueStore * _write;
+	ValueStore * volatile _writeSpare;
+
+	// what getLatestValues() hands the gui
+	float * _view;
+
+	// what setLength() renders from and what it has rendered at other
+	// sizes, shared with _store.  only good while _sourceValid, any
+	// new store makes a new source
+	ValueStore * _source;
+	vector<ValueStore*> _renders;
+	bool _sourceValid;
+
+	// smoothed copy of _values, what a Reader sees when smoothing
+	float * _current;
+	float _smoothTime;
+	bool _settled;
+	unsigned int _smoothVersion;
+	nframes_t _smoothFrame;
 	
 	int _length;
 
@@ -157,6 +407,41 @@ class FTspectrumModifier
 	int _id;
 	bool _bypassed;
 	bool _dirty;
+	unsigned int _version;
+
+	// pending rotation of [_rotStart, _rotEnd) by _rotOffset bins
+	int _rotStart;
+	int _rotEnd;
+	int _rotOffset;
+	// every rotation of the region since it was set, modulo its
+	// length, and which setting of the region that was
+	int _rotTotal;
+	unsigned int _rotRegion;
+	// a region change waiting on applyRotation(), and the shift
+	// for the new region
+	bool _rotQueued;
+	int _queuedStart;
+	int _queuedEnd;
+	int _queuedShift;
+	unsigned int _viewVersion;
+	// odd while the audio thread changes the above or the stores
+	volatile unsigned int _viewSeq;
+
+	struct Route {
+		const void * volatile key;
+		int start;
+		int end;
+		float offset;
+	};
+
+	Route _routes[FT_MAX_ROUTES];
+	volatile unsigned int _routeVersion;
+	unsigned int _routeSumVersion;
+	// _values plus the route offsets, while _modulated.  in stored
+	// order like _values and _current
+	float * _effective;
+	float * _routeSteps;
+	bool _modulated;
 	
 	list<Listener *> _listenerList;
 
@@ -448,6 +448,100 @@ void FTutils::vector_fast_log2 (const float* x_input, float* y_output, int N)
 
 
 
+void FTutils::vector_random_fill (float *out, int N, uint32_t key, uint32_t counter, float lb, float ub)
+{
+    // top 24 bits give an exact float in [0,1)
+    const float scale = (ub - lb) * (1.0f / 16777216.0f);
+    int i;
+    
+    for (i=0; i<N; ++i)
+    {
+	out[i] = lb + scale * (float) (hash_random (key, counter + i) >> 8);
+    }
+}
+
+
+
+void FTutils::vector_weighted_sum (const float *rows, int stride, const float *weights, int nrows, float *out, int N)
+{
+    int i, k;
+    bool first = true;
+    
+    for (k=0; k<nrows; ++k)
+    {
+	const float w = weights[k];
+	const float * row = rows + k * stride;
+	
+	if (w == 0.0f) continue;
+
+	// one row at a time streams straight through
+	if (first) {
+	    for (i=0; i<N; ++i) {
+		out[i] = w * row[i];
+	    }
+	    first = false;
+	}
+	else {
+	    for (i=0; i<N; ++i) {
+		out[i] += w * row[i];
+	    }
+	}
+    }
+
+    if (first) {
+	memset (out, 0, N * sizeof(float));
+    }
+}
+
+void FTutils::vector_resample (const float *in, int inlen, float *out, int outlen)
+{
+    int i, k;
+    const double scale = inlen / (double) outlen;
+
+    if (inlen == outlen) {
+	memcpy (out, in, outlen * sizeof(float));
+    }
+    else if (outlen < inlen) {
+	// box filter over the input bins [i*scale, (i+1)*scale), the
+	// partly covered ones at either end weighted by how much
+	for (i=0; i<outlen; ++i)
+	{
+	    const double lo = i * scale;
+	    const double hi = lo + scale;
+	    int first = (int) lo;
+	    int last = (int) hi;
+	    if (last >= inlen) last = inlen - 1;
+
+	    double sum = in[first] * (first + 1 - lo);
+	    for (k=first+1; k<last; ++k) {
+		sum += in[k];
+	    }
+	    if (last > first) {
+		sum += in[last] * (hi - last);
+	    }
+	    out[i] = (float) (sum / scale);
+	}
+    }
+    else {
+	for (i=0; i<outlen; ++i)
+	{
+	    const double pos = (i + 0.5) * scale - 0.5;
+
+	    if (pos <= 0.0) {
+		out[i] = in[0];
+	    }
+	    else if (pos >= inlen - 1) {
+		out[i] = in[inlen - 1];
+	    }
+	    else {
+		k = (int) pos;
+		const float frac = (float) (pos - k);
+		out[i] = in[k] + frac * (in[k+1] - in[k]);
+	    }
+	}
+    }
+}
+
 void FTutils::vector_fast_square_root (const float* x_input, float* y_output, int N)
 {
     int i;
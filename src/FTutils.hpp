@@ -23,6 +23,7 @@
 #include <iostream>
 #include <sstream>
 #include <cmath>
+#include <stdint.h>
 
 #include <wx/string.h>
 
@@ -95,6 +96,24 @@ public:
 	static double square_wave   (double time, double freq_Hz);
 	static double triangle_wave (double time, double freq_Hz);
 
+/* Counter based random numbers.  The result only depends on the key */
+/* and the counter, so there is no state to share between threads   */
+/* and a given key always replays the same sequence.                 */
+	static inline uint32_t hash_random (uint32_t key, uint32_t counter);
+
+/* out[i] = lb + (ub-lb) * uniform(key, counter+i), in [lb, ub)  */
+/* written so the compiler can vectorize it                       */
+	static void vector_random_fill (float *out, int N, uint32_t key, uint32_t counter, float lb, float ub);
+
+/* out[i] = sum of weights[k] * rows[k*stride + i] over the nrows rows */
+/* of one contiguous block.  rows with a weight of 0 are skipped      */
+	static void vector_weighted_sum (const float *rows, int stride, const float *weights, int nrows, float *out, int N);
+
+/* resamples a curve of inlen bins onto outlen bins covering the same */
+/* range.  going down each bin is the average of the bins it covers,  */
+/* so nothing aliases, going up it is linear between bin centres      */
+	static void vector_resample (const float *in, int inlen, float *out, int outlen);
+
 	
 };
 
@@ -119,6 +138,23 @@ inline float FTutils::powerLogScale(float yval, float min)
 
 
 
+inline uint32_t FTutils::hash_random (uint32_t key, uint32_t counter)
+{
+	// a well mixed 32 bit integer hash (lowbias32) of the counter
+	// spread over the golden ratio and keyed
+	uint32_t x = (counter * 0x9e3779b9u) ^ key;
+
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	
+	return x;
+}
+
+
+
 /* 32 bit "pointer cast" union */
 typedef union {
         float f;
@@ -137,6 +173,49 @@ static inline float flush_to_zero(float f)
 }
 
 
+/* IEEE half precision packing, used for compact storage of spectral
+ * frames.  Values too small for a normal half flush to zero and
+ * values too big clamp to the largest finite half.
+ */
+static inline uint16_t float_to_half(float f)
+{
+	ls_pcast32 v;
+	v.f = f;
+
+	uint32_t bits = (uint32_t) v.i;
+	uint16_t sign = (uint16_t) ((bits >> 16) & 0x8000);
+	int exp = (int) ((bits >> 23) & 0xff) - 127 + 15;
+
+	if (exp <= 0) {
+		return sign;
+	}
+
+	// round to nearest, a carry out of the mantissa bumps the exponent
+	uint32_t h = ((uint32_t) exp << 10) + (((bits & 0x7fffff) + 0x1000) >> 13);
+	if (h > 0x7bff) {
+		h = 0x7bff;
+	}
+
+	return (uint16_t) (sign | h);
+}
+
+static inline float half_to_float(uint16_t h)
+{
+	ls_pcast32 v;
+	uint32_t sign = ((uint32_t) h & 0x8000) << 16;
+	uint32_t exp = (h >> 10) & 0x1f;
+
+	if (exp == 0) {
+		v.i = (int32_t) sign;
+	}
+	else {
+		v.i = (int32_t) (sign | ((exp - 15 + 127) << 23) | (((uint32_t) h & 0x3ff) << 13));
+	}
+
+	return v.f;
+}
+
+
 
 /* A set of branchless clipping operations from Laurent de Soras */
 
@@ -0,0 +1,744 @@
+/*
+** Copyright (C) 2026 The FreqTweak contributors
+**  
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**  
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**  
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+**  
+*/
+
+// ftpreset: checks and converts presets without the gui or jack.
+// Every path given is a preset file, a preset directory or a tree
+// of them, and each preset found is a job for one of the workers
+
+#if HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <cmath>
+#include <cfloat>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <wx/wx.h>
+#include <wx/init.h>
+#include <libxml/parser.h>
+
+#include "FTconfigManager.hpp"
+#include "FTspectralEngine.hpp"
+#include "FTspectrumModifier.hpp"
+#include "FTioSupport.hpp"
+#include "FTdspManager.hpp"
+#include "FTmodulatorManager.hpp"
+#include "FTprocI.hpp"
+#include "FTpresetFile.hpp"
+#include "xml++.hpp"
+#include "version.h"
+
+using namespace std;
+
+enum Command {
+	CMD_VALIDATE = 0,
+	CMD_CONVERT,
+	CMD_MIGRATE,
+	CMD_BENCH
+};
+
+// what bench times, milliseconds per load
+enum BenchTime {
+	BENCH_DIR = 0,
+	BENCH_FTP,
+	BENCH_DOM,
+	BENCH_PULL,
+	BENCH_COUNT
+};
+
+static const char * benchNames[BENCH_COUNT] = { "dir", "ftp", "dom", "pull" };
+
+struct Job {
+	Job (const string & p, const string & r) : path(p), rel(r), ok(false) {
+		for (int t=0; t < BENCH_COUNT; t++) times[t] = 0.0;
+	}
+	
+	string path;
+	// where it goes under the output directory
+	string rel;
+
+	bool ok;
+	string message;
+	// for bench
+	double times[BENCH_COUNT];
+};
+
+struct Options {
+	Options() : command(CMD_VALIDATE), dirformat(false), fftsize(0), quiet(false), rounds(20) {}
+	
+	Command command;
+	string outdir;
+	bool dirformat;
+	int fftsize;
+	bool quiet;
+	int rounds;
+};
+
+struct Worker {
+	pthread_t thread;
+	FTconfigManager * config;
+};
+
+static Options opts;
+static vector<Job> jobs;
+static volatile int nextJob = 0;
+
+
+static void usage()
+{
+	fprintf (stderr,
+		 "FreqTweak preset tool %s\n"
+		 "usage: ftpreset [options] validate PATH...\n"
+		 "       ftpreset [options] convert -o OUTDIR [-f ftp|dir] [-s FFTSIZE] PATH...\n"
+		 "       ftpreset [options] migrate [-s FFTSIZE] PATH...\n"
+		 "       ftpreset [options] bench [-n ROUNDS] PATH...\n"
+		 "\n"
+		 "  PATH is a preset file, a preset directory or a directory of them\n"
+		 "  validate   check that every preset loads completely and sanely\n"
+		 "  convert    write them under OUTDIR as preset files (ftp, the default)\n"
+		 "             or in the directory format (dir), keeping the tree\n"
+		 "  migrate    write NAME%s next to each directory or pre 0.5.0 preset,\n"
+		 "             the originals are left alone\n"
+		 "  bench      time loading each preset from both formats, and walking\n"
+		 "             its config as a tree (dom) and with the pull parser,\n"
+		 "             one preset at a time, ROUNDS times each (default 20)\n"
+		 "  -s         render the filters at another FFT size (%d-%d)\n"
+		 "\n"
+		 "options:\n"
+		 "  -j JOBS    presets to work on at once, default is one per processor\n"
+		 "  -q         only report problems\n"
+		 "  -r DIR     what directory to use for run-control state. default is ~/.freqtweak\n",
+		 freqtweak_version, FT_PRESET_EXT,
+		 FTspectralEngine::getFFTSizes()[0],
+		 FTspectralEngine::getFFTSizes()[FTspectralEngine::getFFTSizeCount()-1]);
+}
+
+static bool endsWith (const string & str, const string & suffix)
+{
+	return str.size() >= suffix.size()
+		&& str.compare (str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+static bool isDirectory (const string & path)
+{
+	struct stat st;
+	return stat (path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static bool fileExists (const string & path)
+{
+	struct stat st;
+	return stat (path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
+}
+
+static bool isPresetDir (const string & path)
+{
+	return fileExists (path + "/config.xml") || fileExists (path + "/config.0");
+}
+
+static string baseName (string path)
+{
+	while (path.size() > 1 && path[path.size()-1] == '/') {
+		path.erase (path.size()-1);
+	}
+	string::size_type pos = path.rfind ('/');
+	return pos == string::npos ? path : path.substr (pos+1);
+}
+
+static bool validSize (int fftsize)
+{
+	const int * sizes = FTspectralEngine::getFFTSizes();
+	for (int i=0; i < FTspectralEngine::getFFTSizeCount(); i++) {
+		if (sizes[i] == fftsize) return true;
+	}
+	return false;
+}
+
+// the directories up to and including path, several workers may be
+// making the same ones
+static bool makeDirs (const string & path)
+{
+	for (string::size_type pos = 1; pos <= path.size(); pos++) {
+		if (pos < path.size() && path[pos] != '/') continue;
+
+		string dir = path.substr (0, pos);
+		if (mkdir (dir.c_str(), 0755) && errno != EEXIST) {
+			return false;
+		}
+	}
+	return isDirectory (path);
+}
+
+// presets under dir, in name order so the jobs are always the same
+static void findPresets (const string & dir, const string & rel)
+{
+	DIR * d = opendir (dir.c_str());
+	if (!d) {
+		fprintf (stderr, "Error reading directory %s\n", dir.c_str());
+		return;
+	}
+
+	vector<string> names;
+	struct dirent * ent;
+	while ((ent = readdir (d)) != 0) {
+		if (ent->d_name[0] != '.') {
+			names.push_back (ent->d_name);
+		}
+	}
+	closedir (d);
+
+	sort (names.begin(), names.end());
+
+	for (unsigned int n=0; n < names.size(); n++) {
+		string path = dir + "/" + names[n];
+		string subrel = rel.empty() ? names[n] : rel + "/" + names[n];
+
+		if (isDirectory (path)) {
+			if (isPresetDir (path)) {
+				jobs.push_back (Job (path, subrel));
+			}
+			else {
+				findPresets (path, subrel);
+			}
+		}
+		else if (endsWith (names[n], FT_PRESET_EXT)) {
+			jobs.push_back (Job (path, subrel));
+		}
+	}
+}
+
+// renders every filter at fftsize and makes that what gets stored
+static void resample (FTstagedPreset & preset, int fftsize)
+{
+	preset.fft_size = fftsize;
+
+	for (unsigned int i=0; i < preset.procvec.size(); i++) {
+		for (unsigned int n=0; n < preset.procvec[i].size(); n++) {
+			FTprocI * procmod = preset.procvec[i][n];
+			procmod->setFFTsize (fftsize);
+
+			vector<FTspectrumModifier *> filts;
+			procmod->getFilters (filts);
+
+			for (unsigned int m=0; m < filts.size(); m++) {
+				// linked ones go with the one they follow
+				if (filts[m]->getLink()) continue;
+
+				filts[m]->beginEdit();
+				filts[m]->commitEdit();
+				filts[m]->settle();
+			}
+		}
+	}
+}
+
+static bool validate (FTstagedPreset & preset, Job & job)
+{
+	bool ok = true;
+	char buf[256];
+
+	if (preset.dropped) {
+		snprintf (buf, sizeof(buf), "%u modules, filters or modulators could not be loaded; ", preset.dropped);
+		job.message += buf;
+		ok = false;
+	}
+
+	if (!validSize (preset.fft_size)) {
+		snprintf (buf, sizeof(buf), "invalid fft size %d; ", preset.fft_size);
+		job.message += buf;
+		ok = false;
+	}
+
+	unsigned int filtcount = 0;
+	
+	for (unsigned int i=0; i < preset.procvec.size(); i++) {
+		for (unsigned int n=0; n < preset.procvec[i].size(); n++) {
+			vector<FTspectrumModifier *> filts;
+			preset.procvec[i][n]->getFilters (filts);
+
+			for (unsigned int m=0; m < filts.size(); m++) {
+				FTspectrumModifier * specmod = filts[m];
+				const float * values = specmod->getLatestValues();
+				int length = specmod->getLength();
+				int nonfinite = 0, outside = 0;
+
+				for (int b=0; b < length; b++) {
+					// false for nan too
+					if (!(fabsf (values[b]) <= FLT_MAX)) {
+						nonfinite++;
+					}
+					else if (values[b] < specmod->getMin() || values[b] > specmod->getMax()) {
+						outside++;
+					}
+				}
+
+				if (nonfinite) {
+					snprintf (buf, sizeof(buf), "channel %u %s %s: %d bad values; ", i,
+						  preset.procvec[i][n]->getConfName().c_str(), specmod->getConfigName().c_str(), nonfinite);
+					job.message += buf;
+					ok = false;
+				}
+				if (outside) {
+					// the processors clamp these, only worth a mention
+					snprintf (buf, sizeof(buf), "channel %u %s %s: %d values out of range; ", i,
+						  preset.procvec[i][n]->getConfName().c_str(), specmod->getConfigName().c_str(), outside);
+					job.message += buf;
+				}
+				filtcount++;
+			}
+		}
+	}
+
+	if (ok) {
+		snprintf (buf, sizeof(buf), "%u channels, %u filters, fft size %d",
+			  (unsigned int) preset.procvec.size(), filtcount, preset.fft_size);
+		job.message += buf;
+	}
+	else {
+		// the last separator
+		job.message.erase (job.message.size() - 2);
+	}
+	
+	return ok;
+}
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+// what the tree loader did, every element and its name property
+static unsigned int walkTree (const XMLNode * node)
+{
+	unsigned int count = 1;
+	const XMLProperty * prop = node->property ("name");
+	if (prop) count += prop->value().size() ? 1 : 0;
+	
+	const XMLNodeList & children = node->children();
+	for (XMLNodeConstIterator child = children.begin(); child != children.end(); ++child) {
+		if (!(*child)->is_content()) {
+			count += walkTree (*child);
+		}
+	}
+	return count;
+}
+
+// the same with the reader
+static unsigned int walkReader (XMLReader & reader, int depth)
+{
+	unsigned int count = 0;
+	string value;
+	
+	while (reader.next_child (depth)) {
+		count++;
+		if (reader.property ("name", value)) count += value.size() ? 1 : 0;
+		count += walkReader (reader, reader.depth());
+	}
+	return count;
+}
+
+static bool removeTree (const string & path)
+{
+	if (!isDirectory (path)) {
+		return unlink (path.c_str()) == 0;
+	}
+	
+	DIR * d = opendir (path.c_str());
+	if (!d) return false;
+
+	struct dirent * ent;
+	bool ok = true;
+	while ((ent = readdir (d)) != 0) {
+		if (strcmp (ent->d_name, ".") && strcmp (ent->d_name, "..")) {
+			ok = removeTree (path + "/" + ent->d_name) && ok;
+		}
+	}
+	closedir (d);
+	
+	return rmdir (path.c_str()) == 0 && ok;
+}
+
+// writes the preset out in both formats under opts.outdir and times
+// loading each, then walking its config both ways
+static void benchJob (FTconfigManager * config, FTstagedPreset & preset, Job & job)
+{
+	char buf[256];
+	snprintf (buf, sizeof(buf), "%s/%d", opts.outdir.c_str(), (int) (&job - &jobs[0]));
+	string dirpath = buf;
+	string ftppath = dirpath + FT_PRESET_EXT;
+
+	if (!config->writePreset (dirpath, preset, true) || !config->writePreset (ftppath, preset, false)) {
+		job.message = "could not write it to " + opts.outdir;
+		removeTree (dirpath);
+		unlink (ftppath.c_str());
+		return;
+	}
+
+	FTpresetFile binfile;
+	if (!binfile.open (ftppath)) {
+		job.message = "could not open " + ftppath;
+		removeTree (dirpath);
+		unlink (ftppath.c_str());
+		return;
+	}
+	const string xml = binfile.getConfig();
+	binfile.close();
+
+	unsigned int domcount = 0, pullcount = 0;
+	bool ok = true;
+	double start;
+	
+	for (int r=0; r < opts.rounds && ok; r++) {
+		FTstagedPreset dirpreset, ftppreset;
+		
+		start = now();
+		ok = config->readPreset (dirpath, dirpreset) && ok;
+		job.times[BENCH_DIR] += now() - start;
+
+		start = now();
+		ok = config->readPreset (ftppath, ftppreset) && ok;
+		job.times[BENCH_FTP] += now() - start;
+
+		start = now();
+		XMLTree tree;
+		ok = tree.read_buffer (xml) && tree.root() && ok;
+		domcount = ok ? walkTree (tree.root()) : 0;
+		job.times[BENCH_DOM] += now() - start;
+
+		start = now();
+		XMLReader reader;
+		ok = reader.open_buffer (xml) && ok;
+		pullcount = ok ? walkReader (reader, -1) : 0;
+		ok = !reader.error() && ok;
+		job.times[BENCH_PULL] += now() - start;
+	}
+
+	removeTree (dirpath);
+	unlink (ftppath.c_str());
+
+	if (!ok || domcount != pullcount) {
+		job.message = "could not load it back the same";
+		return;
+	}
+	
+	job.message.clear();
+	for (int t=0; t < BENCH_COUNT; t++) {
+		job.times[t] /= opts.rounds;
+		snprintf (buf, sizeof(buf), "%s%s %.3f ms", t ? ", " : "", benchNames[t], job.times[t]);
+		job.message += buf;
+	}
+	job.ok = true;
+}
+
+static void runJob (FTconfigManager * config, Job & job)
+{
+	FTstagedPreset preset;
+	
+	if (!config->readPreset (job.path, preset)) {
+		job.message = "could not be read";
+		return;
+	}
+
+	if (opts.command == CMD_VALIDATE) {
+		job.ok = validate (preset, job);
+		return;
+	}
+
+	if (opts.command == CMD_BENCH) {
+		benchJob (config, preset, job);
+		return;
+	}
+
+	if (preset.dropped) {
+		// would lose them
+		job.message = "parts could not be loaded, validate it";
+		return;
+	}
+	
+	string outpath;
+	bool dirformat = opts.dirformat;
+
+	if (opts.command == CMD_MIGRATE) {
+		dirformat = false;
+		
+		if (endsWith (job.path, FT_PRESET_EXT)) {
+			if (!opts.fftsize) {
+				job.ok = true;
+				job.message = "already a preset file";
+				return;
+			}
+			// rewritten in place, the file is replaced whole
+			outpath = job.path;
+		}
+		else {
+			outpath = job.path;
+			while (outpath.size() > 1 && outpath[outpath.size()-1] == '/') {
+				outpath.erase (outpath.size()-1);
+			}
+			outpath += FT_PRESET_EXT;
+
+			if (fileExists (outpath)) {
+				job.ok = true;
+				job.message = "already migrated to " + outpath;
+				return;
+			}
+		}
+	}
+	else {
+		string rel = job.rel;
+		if (endsWith (rel, FT_PRESET_EXT)) {
+			rel.erase (rel.size() - strlen(FT_PRESET_EXT));
+		}
+		outpath = opts.outdir + "/" + rel + (dirformat ? "" : FT_PRESET_EXT);
+
+		string::size_type pos = outpath.rfind ('/');
+		if (!makeDirs (outpath.substr (0, pos))) {
+			job.message = "could not create directory for " + outpath;
+			return;
+		}
+	}
+
+	if (opts.fftsize) {
+		resample (preset, opts.fftsize);
+	}
+
+	if (!config->writePreset (outpath, preset, dirformat)) {
+		job.message = "could not write " + outpath;
+		return;
+	}
+
+	job.ok = true;
+	job.message = "-> " + outpath;
+}
+
+static void * workerEntry (void * arg)
+{
+	Worker * worker = (Worker *) arg;
+	int n;
+
+	while ((n = __sync_fetch_and_add (&nextJob, 1)) < (int) jobs.size()) {
+		runJob (worker->config, jobs[n]);
+	}
+
+	return 0;
+}
+
+
+int main (int argc, char ** argv)
+{
+	long njobs = sysconf (_SC_NPROCESSORS_ONLN);
+	string rcdir;
+	int c;
+
+	while ((c = getopt (argc, argv, "j:qr:o:f:s:n:h")) != -1) {
+		switch (c) {
+		case 'j':
+			njobs = atol (optarg);
+			break;
+		case 'q':
+			opts.quiet = true;
+			break;
+		case 'r':
+			rcdir = optarg;
+			break;
+		case 'o':
+			opts.outdir = optarg;
+			break;
+		case 'f':
+			if (strcmp (optarg, "dir") == 0) {
+				opts.dirformat = true;
+			}
+			else if (strcmp (optarg, "ftp") != 0) {
+				fprintf (stderr, "Error: unknown format '%s'\n", optarg);
+				usage();
+				return 2;
+			}
+			break;
+		case 's':
+			opts.fftsize = atoi (optarg);
+			if (!validSize (opts.fftsize)) {
+				fprintf (stderr, "Error: invalid fft size %s\n", optarg);
+				usage();
+				return 2;
+			}
+			break;
+		case 'n':
+			opts.rounds = atoi (optarg);
+			if (opts.rounds < 1) {
+				fprintf (stderr, "Error: invalid rounds %s\n", optarg);
+				usage();
+				return 2;
+			}
+			break;
+		default:
+			usage();
+			return 2;
+		}
+	}
+
+	if (optind + 1 >= argc) {
+		usage();
+		return 2;
+	}
+
+	string command = argv[optind++];
+	
+	if (command == "validate") {
+		opts.command = CMD_VALIDATE;
+	}
+	else if (command == "convert") {
+		opts.command = CMD_CONVERT;
+		if (opts.outdir.empty()) {
+			fprintf (stderr, "Error: convert needs an output directory (-o)\n");
+			usage();
+			return 2;
+		}
+	}
+	else if (command == "migrate") {
+		opts.command = CMD_MIGRATE;
+	}
+	else if (command == "bench") {
+		opts.command = CMD_BENCH;
+	}
+	else {
+		fprintf (stderr, "Error: unknown command '%s'\n", command.c_str());
+		usage();
+		return 2;
+	}
+
+	for ( ; optind < argc; optind++) {
+		string path = argv[optind];
+
+		if (isDirectory (path) && !isPresetDir (path)) {
+			findPresets (path, "");
+		}
+		else if (isDirectory (path) || fileExists (path)) {
+			jobs.push_back (Job (path, baseName (path)));
+		}
+		else {
+			fprintf (stderr, "Error: %s does not exist\n", path.c_str());
+			return 2;
+		}
+	}
+
+	if (jobs.empty()) {
+		fprintf (stderr, "No presets found\n");
+		return 1;
+	}
+
+	wxInitializer initializer;
+	if (!initializer.IsOk()) {
+		fprintf (stderr, "Error initializing wxWidgets\n");
+		return 1;
+	}
+	
+	// the prototypes everyone clones, made before anyone needs them.
+	// the io support is only asked for its sample rate
+	FTioSupport::setIOtype (FTioSupport::IO_OFFLINE);
+	FTioSupport::instance();
+	FTdspManager::instance();
+	FTmodulatorManager::instance();
+
+	if (opts.command == CMD_BENCH) {
+		// side by side they'd time each other
+		njobs = 1;
+
+		char tmpl[] = "/tmp/ftpreset-bench.XXXXXX";
+		if (!mkdtemp (tmpl)) {
+			fprintf (stderr, "Error creating a directory for bench: %s\n", strerror(errno));
+			return 1;
+		}
+		opts.outdir = tmpl;
+	}
+	
+	if (njobs < 1) njobs = 1;
+	if (njobs > (long) jobs.size()) njobs = (long) jobs.size();
+
+	// each one keeps its own link cache while loading
+	vector<Worker> workers (njobs);
+
+	for (long i=0; i < njobs; i++) {
+		workers[i].config = new FTconfigManager (rcdir);
+	}
+	// libxml2 sets up its globals on first use, which isn't safe
+	// from several workers at once
+	xmlInitParser();
+	
+	for (long i=0; i < njobs; i++) {
+		pthread_create (&workers[i].thread, NULL, workerEntry, &workers[i]);
+	}
+	for (long i=0; i < njobs; i++) {
+		pthread_join (workers[i].thread, NULL);
+		delete workers[i].config;
+	}
+
+	// nobody parses anything from here on
+	xmlCleanupParser();
+
+	int failed = 0;
+	double totals[BENCH_COUNT] = { 0.0 };
+	
+	for (unsigned int n=0; n < jobs.size(); n++) {
+		if (!jobs[n].ok) {
+			failed++;
+			printf ("%s: FAILED: %s\n", jobs[n].path.c_str(), jobs[n].message.c_str());
+			continue;
+		}
+		else if (!opts.quiet) {
+			printf ("%s: ok: %s\n", jobs[n].path.c_str(), jobs[n].message.c_str());
+		}
+
+		for (int t=0; t < BENCH_COUNT; t++) {
+			totals[t] += jobs[n].times[t];
+		}
+	}
+
+	if (opts.command == CMD_BENCH) {
+		rmdir (opts.outdir.c_str());
+
+		if (failed < (int) jobs.size()) {
+			printf ("per preset, %d loaded:", (int) jobs.size() - failed);
+			for (int t=0; t < BENCH_COUNT; t++) {
+				printf ("%s %s %.3f ms", t ? "," : "", benchNames[t], totals[t] / (jobs.size() - failed));
+			}
+			printf ("\n");
+		}
+	}
+
+	if (!opts.quiet || failed) {
+		printf ("%d of %u presets failed\n", failed, (unsigned int) jobs.size());
+	}
+	
+	return failed ? 1 : 0;
+}
@@ -340,3 +340,100 @@ static void writenode(xmlDocPtr doc, XMLNode * n, xmlNodePtr p, int root =
 			 curchild++)
 		writenode(doc, *curchild, node);
 }
+
+bool XMLReader::open(const string & fn)
+{
+    close();
+    _reader = xmlReaderForFile(fn.c_str(), NULL, XML_PARSE_NOBLANKS);
+    return _reader != NULL;
+}
+
+bool XMLReader::open_buffer(const string & buffer)
+{
+    close();
+    _reader = xmlReaderForMemory(buffer.c_str(), buffer.length(), NULL, NULL,
+				 XML_PARSE_NOBLANKS);
+    return _reader != NULL;
+}
+
+void XMLReader::close()
+{
+    if (_reader)
+		xmlFreeTextReader(_reader);
+    _reader = NULL;
+    _status = 0;
+    _stay = false;
+    _name = string();
+    _depth = -1;
+}
+
+bool XMLReader::step()
+{
+    if (_stay) {
+		/* already on the node expand() or next_child() left us on */
+		_stay = false;
+		return _status == 1;
+    }
+
+    _status = xmlTextReaderRead(_reader);
+    return _status == 1;
+}
+
+bool XMLReader::next_child(int depth)
+{
+    if (!_reader)
+		return false;
+
+    while (step()) {
+		int type = xmlTextReaderNodeType(_reader);
+		int d = xmlTextReaderDepth(_reader);
+
+		if (type == XML_READER_TYPE_ELEMENT) {
+		    if (d <= depth) {
+				/* past the end of an empty element, leave
+				 * this one for our caller's loop */
+				_stay = true;
+				return false;
+		    }
+		    if (d == depth + 1) {
+				const xmlChar * name = xmlTextReaderConstName(_reader);
+				_name = name ? (const char *) name : "";
+				_depth = d;
+				return true;
+		    }
+		}
+		else if (type == XML_READER_TYPE_END_ELEMENT && d <= depth) {
+		    return false;
+		}
+    }
+
+    return false;
+}
+
+bool XMLReader::property(const string & n, string & value) const
+{
+    xmlChar * val = xmlTextReaderGetAttribute(_reader, (const xmlChar *) n.c_str());
+
+    if (!val)
+		return false;
+
+    value = (const char *) val;
+    xmlFree(val);
+    return true;
+}
+
+XMLNode *XMLReader::expand()
+{
+    xmlNodePtr node = xmlTextReaderExpand(_reader);
+
+    if (!node)
+		return NULL;
+
+    XMLNode * tmp = readnode(node);
+
+    /* on to whatever follows the element */
+    _status = xmlTextReaderNext(_reader);
+    _stay = true;
+
+    return tmp;
+}
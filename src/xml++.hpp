@@ -11,6 +11,7 @@
 
 #include <libxml/parser.h>
 #include <libxml/tree.h>
+#include <libxml/xmlreader.h>
 #include <stdarg.h>
 
 #ifndef __XMLPP_H
@@ -22,6 +23,7 @@ using std::list;
 
 class XMLTree;
 class XMLNode;
+class XMLReader;
 typedef list<XMLNode *> XMLNodeList;
 typedef XMLNodeList::iterator XMLNodeIterator;
 typedef XMLNodeList::const_iterator XMLNodeConstIterator;
@@ -119,5 +121,48 @@ public:
   const string & set_value(const string &v) { return _value = v; };
 };
 
+/* Pull parser.  Walks a document one element at a time without
+ * building a tree, for reading big or many documents:
+ *
+ *   int depth = reader.depth();
+ *   while (reader.next_child (depth)) { ... reader.name() ... }
+ *
+ * visits the children of the current element (the root for a depth
+ * of -1).  Their own children are skipped unless the loop body walks
+ * them the same way.  expand() makes a node of just the current
+ * element, for the odd part a caller wants as XMLNodes.
+ */
+class XMLReader {
+private:
+  xmlTextReaderPtr _reader;
+  int _status;
+  bool _stay;
+  string _name;
+  int _depth;
+
+  bool step();
+
+public:
+  XMLReader() : _reader(0), _status(0), _stay(false), _depth(-1) { };
+  ~XMLReader() { close(); };
+
+  bool open(const string &fn);
+  bool open_buffer(const string &);
+  void close();
+
+  bool next_child(int);
+
+  const string & name() const { return _name; };
+  int depth() const { return _depth; };
+  bool property(const string &, string &) const;
+
+  /** The current element and all under it, the caller deletes it.
+   *  The reader moves on past the element */
+  XMLNode *expand();
+
+  /** True if the document turned out not to be well formed */
+  bool error() const { return _status < 0; };
+};
+
 #endif /* __XML_H */
 